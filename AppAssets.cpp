@@ -3,265 +3,376 @@
 #include "ShaderProgram.hpp"
 #include "Model.hpp"
 #include "Heightmap.hpp"
+#include "StartupProfile.hpp"
+#include "AssetLoader.hpp"
+#include "RenderState.hpp"
 
 #include <opencv2/opencv.hpp>
 #include <GL/glew.h>
 #include <GL/wglew.h>
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 #include <stdexcept>
 
 void App::init_assets(void) {
-    // Load everything needed for rendering (shader, textures, terrain, models) and register objects into `scene`.
+    // Shader and terrain load synchronously (placement and collision need the heightmap). Textures and
+    // models stream in through `assets`: workers decode/parse, run() uploads them a few per frame and the
+    // callbacks below place the objects into `scene` as they become ready.
+    StartupProfile& profile = StartupProfile::get();
+    assets_start = StartupProfile::Clock::now();
+    auto step_start = assets_start;
 
     // Shader used by the whole scene.
     my_shader = ShaderProgram("lighting_shader.vert", "lighting_shader.frag");
-
-    // Base textures (most objects pick one of these).
-    my_texture = textureInit("resources/textures/tex_2048.png");
-    GLuint lamp = textureInit("resources/textures/Lamp_BaseColor.png");
-    GLuint glass = textureInit("resources/textures/glass.jpg");
-    GLuint stone = textureInit("resources/textures/Rock.jpg");
-    GLuint stone_2 = textureInit("resources/textures/Rock-Texture-Surface.jpg");
-    GLuint stone_3 = textureInit("resources/textures/rock_2.jpg");
-    GLuint Cactus = textureInit("resources/textures/cactustextur.png");
-
-    // Take one tile from a texture atlas and upload it as a standalone GL texture.
-    auto createSubTextureFromAtlas = [&](const std::filesystem::path& atlasPath, int tileX, int tileY, int tilesPerRow = 16) -> GLuint {
-        cv::Mat atlas = cv::imread(atlasPath.string(), cv::IMREAD_UNCHANGED);
-        if (atlas.empty()) {
-            throw std::runtime_error("Cannot open atlas: " + atlasPath.string());
+    u.model = my_shader.uniform("uM_m");
+    u.normal_matrix = my_shader.uniform("N_matrix");
+    u.color = my_shader.uniform("my_color");
+    u.oit = my_shader.uniform("oit");
+    GeometryArena::get().create(my_shader);     // before any model is uploaded
+    scene_draws.create(my_shader);
+    transparent_draws.create(my_shader);
+    if (!instance_culler.create())
+        gpu_instance_culling = false;
+    if (!hiz.create())
+        occlusion_culling = false;
+    if (!transparency.create())
+        order_independent_transparency = false;
+    frame_ubo.create(kFrameBlockBinding, "Frame UBO");
+    lights_ubo.create(kLightsBlockBinding, "Lights UBO");
+    profile.add("shader", StartupProfile::msSince(step_start));
+    step_start = StartupProfile::Clock::now();
+
+    // Decodes are shared through texture_cache (each file is read once).
+    assets = std::make_unique<AssetLoader>(texture_cache,
+        [this](cv::Mat& image) { return gen_tex(image); },
+        [this](cv::Mat& atlas, int tilesPerRow) { return gen_tex_array(atlas, tilesPerRow); });
+
+    // Texture atlas as one GL_TEXTURE_2D_ARRAY; objects textured from it pick a layer instead of a texture.
+    const int atlasTilesPerRow = 16;
+    auto atlas = assets->loadAtlasArray("resources/textures/tex_2048.png", atlasTilesPerRow);
+    auto tile = [=](int tileX, int tileY) { return tileY * atlasTilesPerRow + tileX; };
+
+    // Base textures (most objects pick one of these). Queued before the models that use them.
+    auto lamp = assets->loadTexture("resources/textures/Lamp_BaseColor.png");
+    auto glass = assets->loadTexture("resources/textures/glass.jpg");
+    auto stone = assets->loadTexture("resources/textures/Rock.jpg");
+    auto stone_2 = assets->loadTexture("resources/textures/Rock-Texture-Surface.jpg");
+    auto stone_3 = assets->loadTexture("resources/textures/rock_2.jpg");
+    auto Cactus = assets->loadTexture("resources/textures/cactustextur.png");
+
+    // A .tiles file (raw float tiles, e.g. exported by a terrain tool) is always streamed.
+    const bool pre_tiled = terrain_file.extension() == ".tiles";
+    if (terrain_streaming || pre_tiled) {
+        // Tile the source once (the only time it is loaded whole), then keep only the tiles around the camera.
+        // Placement below needs real heights, so the tiles of the first window are read before going on.
+        terrain_streaming = true;
+        terrain_lod_enabled = true;
+        if (!pre_tiled && !HeightTiles::upToDate(terrain_file)) {
+            Heightmap source(terrain_file, my_shader, 0, false);
+            HeightTiles::write(terrain_file, source.heights);
         }
+        if (terrain_tiles.open(pre_tiled ? terrain_file : HeightTiles::tilesPathFor(terrain_file), kTerrainTileBudget, Ground.scale.x)) {
+            terrain_tiles.prefetch(camera.Position.x, camera.Position.z,
+                kTerrainWindowTiles * terrain_tiles.tileSize() * terrain_tiles.scale() * 0.5f);
+            auto const& tiles = terrain_tiles.stats();
+            profile.add("height tiles", StartupProfile::msSince(step_start),
+                std::to_string(tiles.resident) + " tiles, " + std::to_string(tiles.resident_bytes >> 20) + " MB");
+        }
+        Ground.atlas_layer = tile(14, 7);
+        step_start = StartupProfile::Clock::now();
 
-        int tilePx = atlas.cols / tilesPerRow;
-        int sx = tileX * tilePx;
-        int sy = tileY * tilePx;
-
-        // Keep the selected tile inside the atlas bounds.
-        sx = std::max(0, std::min(sx, atlas.cols - tilePx));
-        sy = std::max(0, std::min(sy, atlas.rows - tilePx));
-
-        cv::Rect roi(sx, sy, tilePx, tilePx);
-        cv::Mat tile = atlas(roi).clone();
-        return gen_tex(tile);
-        };
-
-    GLuint ground_tex = createSubTextureFromAtlas("resources/textures/tex_2048.png", 14, 7);
-    GLuint cactus_tex = createSubTextureFromAtlas("resources/textures/tex_2048.png", 14, 1);
-    GLuint plane_tex = createSubTextureFromAtlas("resources/textures/tex_2048.png", 1, 0);
+        update_terrain_streaming();
+        profile.add("terrain lod", StartupProfile::msSince(step_start), "streamed window");
+    }
+    else {
+        // Terrain mesh + cached heightmap data for collision / placement. Drawn untextured until the atlas arrives.
+        Ground = Heightmap(terrain_file, my_shader, 0, !terrain_lod_enabled);
+        Ground.atlas_layer = tile(14, 7);
+        profile.add("heightmap", StartupProfile::msSince(step_start));
+        step_start = StartupProfile::Clock::now();
+
+        // LOD renderer over the same heights (height texture + quadtree bounds).
+        terrain_lod = std::make_unique<TerrainLOD>(Ground.heights, Ground.scale.x, ShaderProgram("terrain_lod.vert", "lighting_shader.frag"));
+        profile.add("terrain lod", StartupProfile::msSince(step_start));
+    }
 
-    // Terrain mesh + cached heightmap data for collision / placement.
-    Ground = Heightmap("resources/heightmaps/ground_v1.png", my_shader, ground_tex);
+    // The atlas stays bound to texture unit 1 for the whole run.
+    assets->whenDone(atlas, [this, atlas](GLuint id) {
+        atlas_texture = atlas;
+        RenderState::get().bindTextureUnit(1, id);
+        my_shader.setUniform("atlas", 1);
+        });
 
     // Random placement config for environment objects.
-    const int numPoints = 75;
     const int minCoordinate = -100;
     const int maxCoordinate = 100;
     const int minborder = -15;
     const int maxborder = 15;
-    glm::vec2 cactuscoords = glm::vec2(0.0f);
 
     std::srand(static_cast<unsigned int>(std::time(0)));
 
-    float positionx = 0.0f;
-    float positionz = 0.0f;
-
-    // Load templates (some are copied and then placed multiple times).
-    Model my_model = Model("resources/objects/Wooden_Crate.obj", my_shader, my_texture);
-    Model base = my_model;
-    Model transparent_model = my_model;
-    Model Cactuses = Model("resources/objects/cactus.obj", my_shader, cactus_tex);
-    Model Lamp = Model("resources/objects/lamp.obj", my_shader, lamp);
-    Model mini_lamp = Lamp;
-    Model plane = Model("resources/objects/plane.obj", my_shader, plane_tex);
-    projectile = Model("resources/objects/Rock_1.OBJ", my_shader, stone);
-    Model rockTemplate = Model("resources/objects/rock_2.obj", my_shader, stone);
-    Model rock3Template = Model("resources/objects/rock_3.obj", my_shader, stone_2);
-    Model rock4Template = Model("resources/objects/rock_4.obj", my_shader, stone_3);
-
-    // Place the main crate.
-    positionx = -5.0f;
-    positionz = 15.0f;
-    float terrainYm = getTerrainHeight(positionx, positionz, Ground.heightmap);
-    my_model.origin = glm::vec3(positionx, terrainYm + 0.10f, positionz);
-    my_model.scale = glm::vec3(0.5f);
-
-    // Spawn cactuses randomly, but keep a clear area around the center.
-    for (int i = 0; i < numPoints; ++i) {
+    // Random (x, z) in the play area, outside the clear area around the center.
+    auto randomSpot = [=]() -> glm::vec2 {
         float x, z;
         do {
             x = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
             z = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
         } while (x > minborder && x < maxborder && z > minborder && z < maxborder);
+        return { x, z };
+        };
 
-        terrainYm = getTerrainHeight(x, z, Ground.heightmap);
-        Cactuses.origin = glm::vec3(x, terrainYm, z);
+    // `count` random spots and the terrain heights under them (sampled in one batch).
+    auto randomSpots = [this, randomSpot](std::size_t count, std::vector<float>& heights) {
+        std::vector<glm::vec2> spots(count);
+        std::generate(spots.begin(), spots.end(), randomSpot);
+        heights.resize(count);
+        getTerrainHeights(spots.data(), heights.data(), count);
+        return spots;
+        };
 
-        float s1 = 1.55f + static_cast<float>(std::rand()) / RAND_MAX * 1.65f;
-        Cactuses.scale = glm::vec3(s1);
-        Cactuses.orientation = glm::vec3(glm::radians(-90.0f), 0.0f, glm::radians(static_cast<float>(std::rand() % 360)));
+    // Place mini_lamp on top of the transparent block (centered in XZ); needs both models, so it runs
+    // from whichever of the two callbacks finishes last.
+    auto placeMiniLamp = [this]() {
+        Scene::Handle lamp = scene.find("Lamp");
+        Scene::Handle block = scene.find("trasparent_block");
+        if (!lamp.valid() || !block.valid() || scene.find("minilamp").valid())
+            return;
+
+        Model const transparent_model = scene.model(block);
+        Model mini_lamp = scene.model(lamp);
+        mini_lamp.scale = glm::vec3(0.3f);
+
+        glm::vec3 centroid_local(0.0f);
+        if (!transparent_model.vertices().empty()) {
+            for (auto const& v : transparent_model.vertices()) {
+                centroid_local += v.position;
+            }
+            centroid_local /= static_cast<float>(transparent_model.vertices().size());
+
+            mini_lamp.origin.x = transparent_model.origin.x + centroid_local.x * transparent_model.scale.x;
+            mini_lamp.origin.z = transparent_model.origin.z + centroid_local.z * transparent_model.scale.z;
+            mini_lamp.origin.y = transparent_model.origin.y + 0.01f;
+        }
+        else {
+            mini_lamp.origin = transparent_model.origin;
+        }
 
-        Cactuses.solid = true;
-        Cactuses.computeAABB();
-        scene.insert({ std::string("Cactus:").append(std::to_string(i)).c_str(), Cactuses });
-    }
+        mini_lamp.solid = true;
+        mini_lamp.computeAABB();
+        sync_collider(scene.add(mini_lamp, "minilamp"));
+        };
+
+    // Crate: main crate, its base and the transparent copy. Keeps its vertices (min/max Y, centroid for the mini lamp).
+    assets->loadModel("resources/objects/Wooden_Crate.obj", my_shader, atlas, tile(4, 0), [this, placeMiniLamp, tile](Model& my_model) {
+        Model base = my_model;
+        Model transparent_model = my_model;
+
+        // Place the main crate.
+        float positionx = -5.0f;
+        float positionz = 15.0f;
+        float terrainYm = getTerrainHeight(positionx, positionz);
+        my_model.origin = glm::vec3(positionx, terrainYm + 0.10f, positionz);
+        my_model.scale = glm::vec3(0.5f);
+        base.atlas_layer = tile(8, 1);
+        transparent_model.atlas_layer = tile(3, 4);
+
+        // Place crate base + transparent crate.
+        base.origin = glm::vec3(-5.0f, getTerrainHeight(-5.0f, 5.0f) + 0.5f, 10.0f);
+        base.scale = glm::vec3(0.25f);
+
+        positionx = -5.0f;
+        positionz = 5.0f;
+        float groundY = getTerrainHeight(positionx, positionz);
+
+        transparent_model.scale = glm::vec3(0.25f);
+        transparent_model.origin.x = positionx;
+        transparent_model.origin.z = positionz;
+        transparent_model.transparent = true;
+
+        // Compute the model's min/max local Y so we can place it exactly on the terrain.
+        auto computeMinMaxY = [](Model const& m) -> std::pair<float, float> {
+            if (m.vertices().empty()) return { 0.0f, 0.0f };
+            float miny = std::numeric_limits<float>::infinity();
+            float maxy = -std::numeric_limits<float>::infinity();
+            for (auto const& v : m.vertices()) {
+                miny = std::min(miny, v.position.y);
+                maxy = std::max(maxy, v.position.y);
+            }
+            return { miny, maxy };
+            };
+
+        auto [t_minY, t_maxY] = computeMinMaxY(transparent_model);
+        if (t_minY == std::numeric_limits<float>::infinity()) {
+            transparent_model.origin.y = groundY + 0.01f;
+        }
+        else {
+            transparent_model.origin.y = groundY - t_minY * transparent_model.scale.y;
+        }
+
+        // Enable collisions for selected objects.
+        transparent_model.solid = true; transparent_model.computeAABB();
+        my_model.solid = true;          my_model.computeAABB();
+
+        sync_collider(scene.add(my_model, "my_first_object"));
+        sync_collider(scene.add(transparent_model, "trasparent_block"));
+        sync_collider(scene.add(base, "wooden_base"));
+        placeMiniLamp();
+        }, true);
+
+    // Spawn cactuses randomly, but keep a clear area around the center. Drawn instanced (one draw call).
+    assets->loadModel("resources/objects/cactus.obj", my_shader, atlas, tile(14, 1), [this, randomSpots](Model& Cactuses) {
+        InstancedModel cacti(Cactuses);
+        cacti.solid = true;
+
+        const int numPoints = 75;
+        std::vector<float> heights;
+        std::vector<glm::vec2> spots = randomSpots(numPoints, heights);
+        for (int i = 0; i < numPoints; ++i) {
+            glm::vec2 spot = spots[i];
+            float terrainYm = heights[i];
+
+            float s1 = 1.55f + static_cast<float>(std::rand()) / RAND_MAX * 1.65f;
+            cacti.add({ glm::vec3(spot.x, terrainYm, spot.y),
+                glm::vec3(glm::radians(-90.0f), 0.0f, glm::radians(static_cast<float>(std::rand() % 360))),
+                glm::vec3(s1) });
+        }
+        instanced.insert({ "Cactus", std::move(cacti) });
+        add_colliders("Cactus");
+        });
+
+    // Lamp; its top (from the kept vertices) also positions the lamp light (lights[2]).
+    assets->loadModel("resources/objects/lamp.obj", my_shader, lamp, [this, placeMiniLamp](Model& Lamp) {
+        float positionx = 2.0f;
+        float positionz = 10.0f;
+        float terrainYm = getTerrainHeight(positionx, positionz);
+        Lamp.origin = glm::vec3(positionx, terrainYm, positionz);
+        Lamp.scale = glm::vec3(3.0f);
+        Lamp.solid = true;
+        Lamp.computeAABB();
+        sync_collider(scene.add(Lamp, "Lamp"));
+
+        float maxY = -std::numeric_limits<float>::infinity();
+        for (auto const& v : Lamp.vertices()) {
+            maxY = std::max(maxY, v.position.y);
+        }
+        if (maxY != -std::numeric_limits<float>::infinity()) {
+            glm::vec3 lampTopWorldPos(Lamp.origin.x, Lamp.origin.y + maxY * Lamp.scale.y - 0.15f, Lamp.origin.z);
+            lights_ubo.data.lights[2].position = glm::vec4(lampTopWorldPos, 1.0f);
+        }
+        placeMiniLamp();
+        }, true);
+
+    // Place the plane.
+    assets->loadModel("resources/objects/plane.obj", my_shader, atlas, tile(1, 0), [this](Model& plane) {
+        float positionx = 5.0f;
+        float positionz = 5.0f;
+        float terrainYm = getTerrainHeight(positionx, positionz);
+        plane.origin = glm::vec3(positionx, terrainYm + 0.5f, positionz);
+        plane.scale = glm::vec3(0.5f);
+        plane.orientation.z = glm::radians(30.0f);
+        sync_collider(scene.add(plane, "Moving_model", Scene::Motion::Circle));
+        });
+
+    // Init projectile placement (copied into the scene on each throw).
+    assets->loadModel("resources/objects/Rock_1.OBJ", my_shader, stone, [this](Model& rock) {
+        projectile = rock;
+        projectile.origin = glm::vec3(0.0f, 0.5f, 0.0f);
+        projectile.scale = glm::vec3(0.01f);
+        projectile.computeAABB();   // flight collision and the collider once it lands
+        });
+
+    // Spawn rock_2 instances.
+    assets->loadModel("resources/objects/rock_2.obj", my_shader, stone, [this, randomSpots](Model& rockTemplate) {
+        InstancedModel rocks(rockTemplate);
+        rocks.solid = true;
 
-    {
-        // Spawn rock_2 instances.
         const int numRocks = 25;
+        std::vector<float> heights;
+        std::vector<glm::vec2> spots = randomSpots(numRocks, heights);
         for (int i = 0; i < numRocks; ++i) {
-            float x, z;
-            do {
-                x = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
-                z = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
-            } while (x > minborder && x < maxborder && z > minborder && z < maxborder);
-
-            float terrainYat = getTerrainHeight(x, z, Ground.heightmap);
-            rockTemplate.origin = glm::vec3(x, terrainYat, z);
+            glm::vec2 spot = spots[i];
+            float terrainYat = heights[i];
 
             float s = 0.002f + static_cast<float>(std::rand()) / RAND_MAX * 0.04f;
-            rockTemplate.scale = glm::vec3(s);
-            rockTemplate.orientation = glm::vec3(0.0f, glm::radians(static_cast<float>(std::rand() % 360)), 0.0f);
-
-            rockTemplate.solid = true;
-            rockTemplate.computeAABB();
-            scene.insert({ std::string("Rock:").append(std::to_string(i)).c_str(), rockTemplate });
+            rocks.add({ glm::vec3(spot.x, terrainYat, spot.y),
+                glm::vec3(0.0f, glm::radians(static_cast<float>(std::rand() % 360)), 0.0f),
+                glm::vec3(s) });
         }
-    }
+        instanced.insert({ "Rock", std::move(rocks) });
+        add_colliders("Rock");
+        });
+
+    // Spawn rock_3 and rock_4 instances.
+    assets->loadModel("resources/objects/rock_3.obj", my_shader, stone_2, [this, randomSpots](Model& rock3Template) {
+        InstancedModel rocks(rock3Template);
+        rocks.solid = true;
 
-    {
-        // Spawn rock_3 and rock_4 instances.
         const int numRock3 = 20;
+        std::vector<float> heights;
+        std::vector<glm::vec2> spots = randomSpots(numRock3, heights);
         for (int i = 0; i < numRock3; ++i) {
-            float x, z;
-            do {
-                x = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
-                z = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
-            } while (x > minborder && x < maxborder && z > minborder && z < maxborder);
-
-            float terrainYat = getTerrainHeight(x, z, Ground.heightmap);
-            rock3Template.origin = glm::vec3(x, terrainYat - 0.5f, z);
+            glm::vec2 spot = spots[i];
+            float terrainYat = heights[i];
 
             float s3 = 0.01f + static_cast<float>(std::rand()) / RAND_MAX * 0.09f;
-            rock3Template.scale = glm::vec3(s3);
-            rock3Template.orientation = glm::vec3(
-                glm::radians(static_cast<float>(std::rand() % 360)),
-                glm::radians(static_cast<float>(std::rand() % 360)),
-                glm::radians(static_cast<float>(std::rand() % 360))
-            );
-
-            rock3Template.solid = true;
-            rock3Template.computeAABB();
-            scene.insert({ std::string("Rock3:").append(std::to_string(i)).c_str(), rock3Template });
+            rocks.add({ glm::vec3(spot.x, terrainYat - 0.5f, spot.y),
+                glm::vec3(
+                    glm::radians(static_cast<float>(std::rand() % 360)),
+                    glm::radians(static_cast<float>(std::rand() % 360)),
+                    glm::radians(static_cast<float>(std::rand() % 360))),
+                glm::vec3(s3) });
         }
+        instanced.insert({ "Rock3", std::move(rocks) });
+        add_colliders("Rock3");
+        });
+
+    assets->loadModel("resources/objects/rock_4.obj", my_shader, stone_3, [this, randomSpots](Model& rock4Template) {
+        InstancedModel rocks(rock4Template);
+        rocks.solid = true;
 
         const int numRock4 = 20;
+        std::vector<float> heights;
+        std::vector<glm::vec2> spots = randomSpots(numRock4, heights);
         for (int i = 0; i < numRock4; ++i) {
-            float x, z;
-            do {
-                x = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
-                z = minCoordinate + static_cast<float>(std::rand()) / RAND_MAX * (maxCoordinate - minCoordinate);
-            } while (x > minborder && x < maxborder && z > minborder && z < maxborder);
-
-            float terrainYat = getTerrainHeight(x, z, Ground.heightmap);
-            rock4Template.origin = glm::vec3(x, terrainYat + 1.0f, z);
+            glm::vec2 spot = spots[i];
+            float terrainYat = heights[i];
 
             float s4 = 0.008f + static_cast<float>(std::rand()) / RAND_MAX * 0.03f;
-            rock4Template.scale = glm::vec3(s4);
-            rock4Template.orientation = glm::vec3(0.0f, glm::radians(static_cast<float>(std::rand() % 360)), 0.0f);
-
-            rock4Template.solid = true;
-            rock4Template.computeAABB();
-            scene.insert({ std::string("Rock4:").append(std::to_string(i)).c_str(), rock4Template });
+            rocks.add({ glm::vec3(spot.x, terrainYat + 1.0f, spot.y),
+                glm::vec3(0.0f, glm::radians(static_cast<float>(std::rand() % 360)), 0.0f),
+                glm::vec3(s4) });
         }
-    }
+        instanced.insert({ "Rock4", std::move(rocks) });
+        add_colliders("Rock4");
+        });
 
-    // Place lamp.
-    positionx = 2.0f;
-    positionz = 10.0f;
-    terrainYm = getTerrainHeight(positionx, positionz, Ground.heightmap);
-    Lamp.origin = glm::vec3(positionx, terrainYm, positionz);
-    Lamp.scale = glm::vec3(3.0f);
-
-    // Place crate base + transparent crate.
-    base.origin = glm::vec3(-5.0f, getTerrainHeight(-5.0f, 5.0f, Ground.heightmap) + 0.5f, 10.0f);
-    base.scale = glm::vec3(0.25f);
-
-    positionx = -5.0f;
-    positionz = 5.0f;
-    float groundY = getTerrainHeight(positionx, positionz, Ground.heightmap);
-
-    transparent_model.scale = glm::vec3(0.25f);
-    transparent_model.origin.x = positionx;
-    transparent_model.origin.z = positionz;
-    transparent_model.transparent = true;
-
-    // Compute the model's min/max local Y so we can place it exactly on the terrain.
-    auto computeMinMaxY = [](Model const& m) -> std::pair<float, float> {
-        if (m.vertices.empty()) return { 0.0f, 0.0f };
-        float miny = std::numeric_limits<float>::infinity();
-        float maxy = -std::numeric_limits<float>::infinity();
-        for (auto const& v : m.vertices) {
-            miny = std::min(miny, v.position.y);
-            maxy = std::max(maxy, v.position.y);
-        }
-        return { miny, maxy };
-        };
+    profile.add("init_assets (sync part)", StartupProfile::msSince(assets_start));
+}
 
-    auto [t_minY, t_maxY] = computeMinMaxY(transparent_model);
-    if (t_minY == std::numeric_limits<float>::infinity()) {
-        transparent_model.origin.y = groundY + 0.01f;
-    }
-    else {
-        transparent_model.origin.y = groundY - t_minY * transparent_model.scale.y;
+// Called once per frame from run(): upload what the workers finished, report once everything is in.
+void App::update_assets(void) {
+    if (!assets) return;
+
+    StartupProfile& profile = StartupProfile::get();
+    if (!first_frame_reported) {
+        first_frame_reported = true;
+        profile.add("first frame", StartupProfile::msSince(assets_start));
     }
 
-    // Place mini_lamp on top of the transparent block (centered in XZ).
-    mini_lamp.scale = glm::vec3(0.3f);
+    const double upload_budget_ms = 4.0;
+    assets->pump(upload_budget_ms);
 
-    glm::vec3 centroid_local(0.0f);
-    if (!transparent_model.vertices.empty()) {
-        for (auto const& v : transparent_model.vertices) {
-            centroid_local += v.position;
-        }
-        centroid_local /= static_cast<float>(transparent_model.vertices.size());
+    if (!assets_reported && assets->idle()) {
+        assets_reported = true;
+        profile.add("all assets ready", StartupProfile::msSince(assets_start),
+            std::to_string(profile.count("cache")) + " meshes from cache, " + std::to_string(profile.count("parsed")) + " parsed");
+        profile.report();
 
-        mini_lamp.origin.x = transparent_model.origin.x + centroid_local.x * transparent_model.scale.x;
-        mini_lamp.origin.z = transparent_model.origin.z + centroid_local.z * transparent_model.scale.z;
-        mini_lamp.origin.y = transparent_model.origin.y + 0.01f;
-    }
-    else {
-        mini_lamp.origin = transparent_model.origin;
+        // Every tile is cut by now, the decoded atlas is not needed any more.
+        texture_cache.releaseImages();
+        texture_cache.report();
     }
-
-    // Place the plane.
-    positionx = 5.0f;
-    positionz = 5.0f;
-    terrainYm = getTerrainHeight(positionx, positionz, Ground.heightmap);
-    plane.origin = glm::vec3(positionx, terrainYm + 0.5f, positionz);
-    plane.scale = glm::vec3(0.5f);
-    plane.orientation.z = glm::radians(30.0f);
-
-    // Init projectile placement.
-    projectile.origin = glm::vec3(0.0f, 0.5f, 0.0f);
-    projectile.scale = glm::vec3(0.01f);
-
-    // Enable collisions for selected objects.
-    transparent_model.solid = true; transparent_model.computeAABB();
-    Lamp.solid = true;              Lamp.computeAABB();
-    mini_lamp.solid = true;         mini_lamp.computeAABB();
-    my_model.solid = true;          my_model.computeAABB();
-
-    // Register everything into the scene map.
-    scene.insert({ "my_first_object", my_model });
-    scene.insert({ "trasparent_block", transparent_model });
-    scene.insert({ "Lamp", Lamp });
-    scene.insert({ "Moving_model", plane });
-    scene.insert({ "wooden_base", base });
-    scene.insert({ "minilamp", mini_lamp });
-
-    // Drop CPU-side mesh data for this local copy (scene has its own stored copy anyway).
-    my_model.meshes.clear();
 }
 
 GLuint App::textureInit(const std::filesystem::path& file_name) {
@@ -310,3 +421,53 @@ GLuint App::gen_tex(cv::Mat& image) {
 
     return ID;
 }
+
+GLuint App::gen_tex_array(cv::Mat& atlas, int tilesPerRow) {
+    // Slice a square-tiled atlas (BGR/BGRA) into a GL_TEXTURE_2D_ARRAY, one layer per tile in row-major
+    // order from the top-left. Every layer gets its own mip chain, so minification never mixes tiles.
+
+    if (atlas.empty() || tilesPerRow <= 0) {
+        throw std::runtime_error("Atlas image empty?\n");
+    }
+
+    GLenum internal_format, format;
+    switch (atlas.channels()) {
+    case 3: internal_format = GL_RGB8;  format = GL_BGR;  break;
+    case 4: internal_format = GL_RGBA8; format = GL_BGRA; break;
+    default:
+        throw std::runtime_error("unsupported channel cnt. in atlas:" + std::to_string(atlas.channels()));
+    }
+
+    const int tilePx = atlas.cols / tilesPerRow;
+    const int tileRows = atlas.rows / tilePx;
+    const int layers = tilesPerRow * tileRows;
+    int levels = 1;
+    while ((tilePx >> levels) > 0) ++levels;
+
+    GLuint ID = 0;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &ID);
+    glObjectLabel(GL_TEXTURE, ID, -1, "MyAtlasArray");
+    glTextureStorage3D(ID, levels, internal_format, tilePx, tilePx, layers);
+
+    // Upload each tile straight from the atlas rows (no per-tile copies).
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(atlas.step / atlas.elemSize()));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int ty = 0; ty < tileRows; ++ty) {
+        for (int tx = 0; tx < tilesPerRow; ++tx) {
+            const unsigned char* tile = atlas.ptr<unsigned char>(ty * tilePx) + static_cast<size_t>(tx) * tilePx * atlas.elemSize();
+            glTextureSubImage3D(ID, 0, 0, 0, ty * tilesPerRow + tx, tilePx, tilePx, 1, format, GL_UNSIGNED_BYTE, tile);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTextureParameteri(ID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(ID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glGenerateTextureMipmap(ID);
+
+    // Repeat wraps inside the layer, neighbouring tiles never show up.
+    glTextureParameteri(ID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(ID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    return ID;
+}
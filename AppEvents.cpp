@@ -61,15 +61,15 @@ void App::key_callback(GLFWwindow* window, int key, int scancode, int action, in
             if (app->flashlight == FALSE) {
                 app->flashlight = TRUE;
                 app->brightness = 10.0f;
-                app->my_shader.setUniform("lights[1].ambientM", glm::vec3(0.05f, 0.05f, 0.05f));
-                app->my_shader.setUniform("lights[1].diffuseM", glm::vec3(1.0f * app->brightness, 0.95f * app->brightness, 0.8f * app->brightness));
-                app->my_shader.setUniform("lights[1].specularM", glm::vec3(1.0f * app->brightness, 0.95f * app->brightness, 0.9f * app->brightness));
+                app->lights_ubo.data.lights[1].ambientM = glm::vec3(0.05f, 0.05f, 0.05f);
+                app->lights_ubo.data.lights[1].diffuseM = glm::vec3(1.0f * app->brightness, 0.95f * app->brightness, 0.8f * app->brightness);
+                app->lights_ubo.data.lights[1].specularM = glm::vec3(1.0f * app->brightness, 0.95f * app->brightness, 0.9f * app->brightness);
             }
             else {
                 app->flashlight = FALSE;
-                app->my_shader.setUniform("lights[1].ambientM", glm::vec3(0.0f, 0.0f, 0.0f));
-                app->my_shader.setUniform("lights[1].diffuseM", glm::vec3(0.0f, 0.0f, 0.0f));
-                app->my_shader.setUniform("lights[1].specularM", glm::vec3(0.0f, 0.0f, 0.0f));
+                app->lights_ubo.data.lights[1].ambientM = glm::vec3(0.0f, 0.0f, 0.0f);
+                app->lights_ubo.data.lights[1].diffuseM = glm::vec3(0.0f, 0.0f, 0.0f);
+                app->lights_ubo.data.lights[1].specularM = glm::vec3(0.0f, 0.0f, 0.0f);
             }
             break;
 
@@ -83,32 +83,96 @@ void App::key_callback(GLFWwindow* window, int key, int scancode, int action, in
             if (app->night == FALSE) { // night
                 app->night = TRUE;
                 app->brightness = 0.1f;
-                app->my_shader.setUniform("fog_color", glm::vec4(glm::vec3(0.0f), 1.0f));
-                app->my_shader.setUniform("lights[0].ambientM", glm::vec3(0.05f, 0.05f, 0.1f));
-                app->my_shader.setUniform("lights[0].diffuseM", glm::vec3(
+                app->frame_ubo.data.fog_color = glm::vec4(glm::vec3(0.0f), 1.0f);
+                app->lights_ubo.data.lights[0].ambientM = glm::vec3(0.05f, 0.05f, 0.1f);
+                app->lights_ubo.data.lights[0].diffuseM = glm::vec3(
                     static_cast<GLfloat>(0.2f * app->brightness),
                     static_cast<GLfloat>(0.2f * app->brightness),
-                    static_cast<GLfloat>(0.35f * app->brightness)));
-                app->my_shader.setUniform("lights[0].specularM", glm::vec3(
+                    static_cast<GLfloat>(0.35f * app->brightness));
+                app->lights_ubo.data.lights[0].specularM = glm::vec3(
                     static_cast<GLfloat>(0.3f * app->brightness),
                     static_cast<GLfloat>(0.3f * app->brightness),
-                    static_cast<GLfloat>(0.5f * app->brightness)));
+                    static_cast<GLfloat>(0.5f * app->brightness));
             }
             else { // day
                 app->night = FALSE;
-                app->my_shader.setUniform("fog_color", glm::vec4(glm::vec3(0.85f), 1.0f));
-                app->my_shader.setUniform("lights[0].ambientM", glm::vec3(0.2f, 0.2f, 0.2f));
-                app->my_shader.setUniform("lights[0].diffuseM", glm::vec3(
+                app->frame_ubo.data.fog_color = glm::vec4(glm::vec3(0.85f), 1.0f);
+                app->lights_ubo.data.lights[0].ambientM = glm::vec3(0.2f, 0.2f, 0.2f);
+                app->lights_ubo.data.lights[0].diffuseM = glm::vec3(
                     static_cast<GLfloat>(1.0f),
                     static_cast<GLfloat>(0.95f),
-                    static_cast<GLfloat>(0.8f)));
-                app->my_shader.setUniform("lights[0].specularM", glm::vec3(
+                    static_cast<GLfloat>(0.8f));
+                app->lights_ubo.data.lights[0].specularM = glm::vec3(
                     static_cast<GLfloat>(1.0f),
                     static_cast<GLfloat>(0.95f),
-                    static_cast<GLfloat>(0.9f)));
+                    static_cast<GLfloat>(0.9f));
             }
             break;
 
+        case GLFW_KEY_U: // toggle the once-per-second uniform timing / render state / terrain culling report
+            ShaderProgram::profile_uniforms = !ShaderProgram::profile_uniforms;
+            std::cout << "Uniform profiling: " << (ShaderProgram::profile_uniforms ? "on" : "off") << '\n';
+            break;
+
+        case GLFW_KEY_L: // compare: look uniform names up with glGetUniformLocation on every call
+            ShaderProgram::legacy_uniform_lookup = !ShaderProgram::legacy_uniform_lookup;
+            std::cout << "Uniform lookup: " << (ShaderProgram::legacy_uniform_lookup ? "glGetUniformLocation" : "reflected table") << '\n';
+            break;
+
+        case GLFW_KEY_G: // switch the terrain between the LOD renderer and the full-resolution chunk mesh
+            if (app->Ground.meshes.empty()) {
+                std::cout << "Terrain: full-resolution mesh was not built, staying in LOD mode\n";
+                break;
+            }
+            app->terrain_lod_enabled = !app->terrain_lod_enabled;
+            std::cout << "Terrain: " << (app->terrain_lod_enabled ? "LOD" : "full resolution") << '\n';
+            break;
+
+        case GLFW_KEY_P: // compare: submit the terrain strips one glDrawElements at a time
+            Mesh::strip_submission = Mesh::strip_submission == Mesh::StripSubmission::MultiDraw
+                ? Mesh::StripSubmission::PerStrip : Mesh::StripSubmission::MultiDraw;
+            std::cout << "Terrain strips: " << (Mesh::strip_submission == Mesh::StripSubmission::MultiDraw
+                ? "one glMultiDrawElements" : "glDrawElements per strip") << '\n';
+            break;
+
+        case GLFW_KEY_O: // compare: draw every scene object and instance without frustum culling
+            app->object_culling = !app->object_culling;
+            std::cout << "Object culling: " << (app->object_culling ? "on" : "off") << '\n';
+            break;
+
+        case GLFW_KEY_K: // compare: draw the opaque scene meshes one glDrawElements each instead of indirect
+            app->indirect_draws = !app->indirect_draws;
+            std::cout << "Opaque scene draws: " << (app->indirect_draws ? "glMultiDrawElementsIndirect" : "one per mesh") << '\n';
+            break;
+
+        case GLFW_KEY_B: // compare: cull the cacti/rocks on the CPU instead of the compute pass
+            if (!app->instance_culler.ready()) {
+                std::cout << "Instance culling: compute program not available, staying on the CPU\n";
+                break;
+            }
+            app->gpu_instance_culling = !app->gpu_instance_culling;
+            std::cout << "Instance culling: " << (app->gpu_instance_culling ? "compute shader" : "CPU") << '\n';
+            break;
+
+        case GLFW_KEY_J: // compare: sort the transparent objects far to near instead of weighted blended OIT
+            if (!app->transparency.ready()) {
+                std::cout << "Transparency: OIT program not available, staying sorted\n";
+                break;
+            }
+            app->order_independent_transparency = !app->order_independent_transparency;
+            std::cout << "Transparency: " << (app->order_independent_transparency ? "weighted blended OIT" : "sorted") << '\n';
+            break;
+
+        case GLFW_KEY_H: // compare: skip the Hi-Z occlusion test of the cacti/rocks
+            if (!app->hiz.ready()) {
+                std::cout << "Occlusion culling: Hi-Z program not available\n";
+                break;
+            }
+            app->occlusion_culling = !app->occlusion_culling;
+            std::cout << "Occlusion culling: " << (app->occlusion_culling ? "on" : "off")
+                << (app->gpu_instance_culling ? "" : " (needs the compute culling, B)") << '\n';
+            break;
+
         case GLFW_KEY_R: // reset camera to a safe default
         {
             glm::vec3 defaultPos = glm::vec3(0.0f, 15.0f, 0.0f);
@@ -191,11 +255,11 @@ void App::mouse_button_callback(GLFWwindow* window, int button, int action, int
         newProj.velocity = forward * 10.0f;
         newProj.solid = false;
 
+        // Thrown rocks are never looked up by name, so they stay out of the name index.
         int id = ++g_projectile_counter;
-        std::string key = std::string("throwable_rock_") + std::to_string(id);
-        app->scene.insert_or_assign(key, newProj);
+        app->scene.add(newProj, {}, Scene::Motion::Ballistic);
 
-        std::cout << "[DEBUG] Inserted " << key << " origin=("
+        std::cout << "[DEBUG] Inserted throwable_rock_" << id << " origin=("
             << newProj.origin.x << "," << newProj.origin.y << "," << newProj.origin.z
             << ") velocity=(" << newProj.velocity.x << "," << newProj.velocity.y << "," << newProj.velocity.z << ")\n";
     }
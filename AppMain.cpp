@@ -52,6 +52,8 @@ int App::run(void)
     
     glCullFace(GL_BACK);  // The default
     glEnable(GL_CULL_FACE); // assume ALL objects are non-transparent 
+
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX); // index 0xFFFFFFFF (Mesh::kRestartIndex) separates the terrain strips
     
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);    // Disable cursor, so that it can not leave window, and we can process movement
     glfwGetCursorPos(window, &cursorLastX, &cursorLastY);           // get first position of mouse cursor
@@ -64,8 +66,6 @@ int App::run(void)
     glm::vec4 my_rgba = glm::vec4(r,g,b,a); // Creatiing the vector for the color input of the object
     a = 0.1f;
     glm::vec4 transparent_rgba = glm::vec4(r, g, b, a);
-    float tile_size = 1.0f / 16;            // Size of one tile on the texture atlas
-    glm::vec2 tile_offset = glm::vec2(0.0f* tile_size, 0.0f * tile_size);   // Setting the position of the desired tile of the texture atlas
 
     // Setting variables for the FPS calculations
     double last_frame_time = glfwGetTime();
@@ -73,101 +73,73 @@ int App::run(void)
     frame_count = 0;
 
     my_shader.activate();   // Because we only have one shader
+    my_shader.setUniform("tex0", 0);    // per-mesh textures are always bound to unit 0 (the atlas array uses unit 1)
 
     // ----- Setting the parameters of the desired lights. (All parameters needs to be set from the s_lights struct for it to work >.<)------
     // Currently these parameters generatte a green and a blue pointlight at the top and bottom of the loaded in textured cube
-    const int maxlights = 4;
     my_shader.setUniform("N_matrix", Ground.normal_matrix); //Needed for light calculations
 
     brightness = 10;
 
-    float terrainY = getTerrainHeight(13.5f, 17.5f, Ground.heightmap);
-
-    glm::vec3 lampTopWorldPos(13.5f, terrainY + 19.0f, 20.5f); // fallback
-    auto itLamp = scene.find("Lamp");
-    if (itLamp != scene.end()) {
-        const Model& lampModel = itLamp->second;
-        float maxY = -std::numeric_limits<float>::infinity();
-        for (auto const& v : lampModel.vertices) {
-            maxY = std::max(maxY, v.position.y);
-        }
-        if (maxY != -std::numeric_limits<float>::infinity()) {
-            lampTopWorldPos.x = lampModel.origin.x;
-            lampTopWorldPos.z = lampModel.origin.z;
-            lampTopWorldPos.y = lampModel.origin.y + maxY * lampModel.scale.y - 0.15f;
-        }
-    }
-
-    for (int i = 0; i < maxlights; ++i) {
-        if (i == 0) {
-            my_shader.setUniform("lights[0].position", glm::vec4(0.0f, 100.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[0].ambientM", glm::vec3(0.2f, 0.2f, 0.2f));
-            my_shader.setUniform("lights[0].diffuseM", glm::vec3(1.0f, 0.95f, 0.8f));
-            my_shader.setUniform("lights[0].specularM", glm::vec3(1.0f, 0.95f, 0.9f));
-            my_shader.setUniform("lights[0].consAttenuation", 1.0f);
-            my_shader.setUniform("lights[0].linAttenuation", 1.0f);
-            my_shader.setUniform("lights[0].quadAttenuation", 1.0f);
-            my_shader.setUniform("lights[0].cutoff", 180.0f);
-            my_shader.setUniform("lights[0].direction", glm::vec3(0.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[0].exponent", 0);
-        }
-        else if (i == 1) {
-            my_shader.setUniform("lights[1].position", glm::vec4(camera.Position, 1.0f));
-            my_shader.setUniform("lights[1].ambientM", glm::vec3(0.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[1].diffuseM", glm::vec3(0.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[1].specularM", glm::vec3(0.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[1].consAttenuation", 1.0f);
-            my_shader.setUniform("lights[1].linAttenuation", 0.09f);
-            my_shader.setUniform("lights[1].quadAttenuation", 0.032f);
-            my_shader.setUniform("lights[1].cutoff", 20.0f);
-            my_shader.setUniform("lights[1].direction", camera.Front);
-            my_shader.setUniform("lights[1].exponent", 20.0f);
-        }
-        else if (i == 2) {
-            my_shader.setUniform("lights[2].position", glm::vec4(lampTopWorldPos, 1.0f));
-            my_shader.setUniform("lights[2].ambientM", glm::vec3(0.15f, 0.08f, 0.03f));
-            my_shader.setUniform("lights[2].diffuseM", glm::vec3(1.0f * brightness, 0.4f * brightness, 0.0f * brightness));
-            my_shader.setUniform("lights[2].specularM", glm::vec3(1.0f * brightness, 0.6f * brightness, 0.2f * brightness));
-            my_shader.setUniform("lights[2].consAttenuation", 1.0f);
-            my_shader.setUniform("lights[2].linAttenuation", 0.09f);
-            my_shader.setUniform("lights[2].quadAttenuation", 0.032f);
-            my_shader.setUniform("lights[2].cutoff", 180.0f);
-            my_shader.setUniform("lights[2].direction", glm::vec3(0.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[2].exponent", 20.0f);
-        }
-        else if (i == 3) {
-            my_shader.setUniform("lights[3].position", glm::vec4(5.0f, 0.5f, 5.0f, 1.0f));
-            my_shader.setUniform("lights[3].ambientM", glm::vec3(0.08f, 0.18f, 0.06f));
-            my_shader.setUniform("lights[3].diffuseM", glm::vec3(0.3f * brightness, 0.95f * brightness, 0.3f * brightness));
-            my_shader.setUniform("lights[3].specularM", glm::vec3(0.6f * brightness, 1.0f * brightness, 0.6f * brightness));
-            my_shader.setUniform("lights[3].consAttenuation", 1.0f);
-            my_shader.setUniform("lights[3].linAttenuation", 0.09f);
-            my_shader.setUniform("lights[3].quadAttenuation", 0.032f);
-            my_shader.setUniform("lights[3].cutoff", 180.0f);
-            my_shader.setUniform("lights[3].direction", glm::vec3(0.0f, 0.0f, 0.0f));
-            my_shader.setUniform("lights[3].exponent", 20.0f);
-        }
-        else if (i == 4) {
-            my_shader.setUniform("lights[4].position", glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
-            my_shader.setUniform("lights[4].ambientM", glm::vec3(0.0f));
-            my_shader.setUniform("lights[4].diffuseM", glm::vec3(1.0f, 1.0f, 0.95f));
-            my_shader.setUniform("lights[4].specularM", glm::vec3(1.0f, 1.0f, 0.95f));
-            my_shader.setUniform("lights[4].consAttenuation", 1.0f);
-            my_shader.setUniform("lights[4].linAttenuation", 0.02f);
-            my_shader.setUniform("lights[4].quadAttenuation", 0.005f);
-            my_shader.setUniform("lights[4].cutoff", 25.0f);
-            my_shader.setUniform("lights[4].direction", glm::vec3(0.0f, -1.0f, 0.0f));
-            my_shader.setUniform("lights[4].exponent", 40.0f);
-        }
-    }
-    // --- Set general parameters for all lights ---
+    float terrainY = getTerrainHeight(13.5f, 17.5f);
+
+    // Fallback until the lamp model has streamed in (its load callback moves the light to the lamp top).
+    glm::vec3 lampTopWorldPos(13.5f, terrainY + 19.0f, 20.5f);
+
+    // The lights live in lights_ubo (uploaded with the frame data below); unset fields keep the
+    // LightStd140 defaults (no attenuation, point light).
+    LightStd140* lights = lights_ubo.data.lights;
+
+    // 0: sun, directional
+    lights[0].position = glm::vec4(0.0f, 100.0f, 0.0f, 0.0f);
+    lights[0].ambientM = glm::vec3(0.2f, 0.2f, 0.2f);
+    lights[0].diffuseM = glm::vec3(1.0f, 0.95f, 0.8f);
+    lights[0].specularM = glm::vec3(1.0f, 0.95f, 0.9f);
+    lights[0].linAttenuation = 1.0f;
+    lights[0].quadAttenuation = 1.0f;
+
+    // 1: flashlight, a spotlight following the camera (dark until F is pressed)
+    lights[1].position = glm::vec4(camera.Position, 1.0f);
+    lights[1].linAttenuation = 0.09f;
+    lights[1].quadAttenuation = 0.032f;
+    lights[1].cutoff = 20.0f;
+    lights[1].direction = camera.Front;
+    lights[1].exponent = 20.0f;
+
+    // 2: lamp
+    lights[2].position = glm::vec4(lampTopWorldPos, 1.0f);
+    lights[2].ambientM = glm::vec3(0.15f, 0.08f, 0.03f);
+    lights[2].diffuseM = glm::vec3(1.0f * brightness, 0.4f * brightness, 0.0f * brightness);
+    lights[2].specularM = glm::vec3(1.0f * brightness, 0.6f * brightness, 0.2f * brightness);
+    lights[2].linAttenuation = 0.09f;
+    lights[2].quadAttenuation = 0.032f;
+    lights[2].exponent = 20.0f;
+
+    // 3: beacon on the plane
+    lights[3].position = glm::vec4(5.0f, 0.5f, 5.0f, 1.0f);
+    lights[3].ambientM = glm::vec3(0.08f, 0.18f, 0.06f);
+    lights[3].diffuseM = glm::vec3(0.3f * brightness, 0.95f * brightness, 0.3f * brightness);
+    lights[3].specularM = glm::vec3(0.6f * brightness, 1.0f * brightness, 0.6f * brightness);
+    lights[3].linAttenuation = 0.09f;
+    lights[3].quadAttenuation = 0.032f;
+    lights[3].exponent = 20.0f;
+
+    // --- Set general parameters for all lights (the LOD terrain shares the fragment shader) ---
     my_shader.setUniform("ambient_intensity", glm::vec3(1.0f, 1.0f, 1.0f));
     my_shader.setUniform("diffuse_intensity", glm::vec3(1.0f, 1.0f, 1.0f));
     my_shader.setUniform("specular_intensity", glm::vec3(1.0f, 1.0f, 1.0f));
     my_shader.setUniform("specular_shinines", 80.0f);
+    if (terrain_lod) {
+        terrain_lod->shader.activate();
+        terrain_lod->shader.setUniform("ambient_intensity", glm::vec3(1.0f, 1.0f, 1.0f));
+        terrain_lod->shader.setUniform("diffuse_intensity", glm::vec3(1.0f, 1.0f, 1.0f));
+        terrain_lod->shader.setUniform("specular_intensity", glm::vec3(1.0f, 1.0f, 1.0f));
+        terrain_lod->shader.setUniform("specular_shinines", 80.0f);
+        my_shader.activate();
+    }
     //------ ------
 
-    std::vector<Model*> transparent;    // temporary, vector of pointers to transparent objects
+    std::vector<std::size_t> transparent;    // temporary, scene indices of the transparent objects
     transparent.reserve(scene.size());  // reserve size for all objects to avoid reallocation
     
     //----- 2D & 3D audio -----    
@@ -216,12 +188,21 @@ int App::run(void)
         glfwSetWindowTitle(window, std::string("FPS: ").append(std::to_string(fps)).append(" Vsync: ").append(std::to_string(vsync_on)).c_str());   //Set the window title to show current FPS of the application and if Vsync is active or not
         glfwSetWindowSizeCallback(window,framebuffer_size_callback);
 
+        // Draw into the offscreen target (its depth feeds the Hi-Z pyramid), or straight to the window without one.
+        int framebuffer_width = 0, framebuffer_height = 0;
+        glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+        const bool offscreen = scene_target.resize(framebuffer_width, framebuffer_height);
+        if (offscreen)
+            scene_target.bind();
+
         if (night) {
             glClearColor(0.02f, 0.02f, 0.08f, 1.0f);
         }
         else { glClearColor(0.53f, 0.81f, 0.92f, 1.0f); }  // sky blue RGBA
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // clear canvas
 
+        update_assets();    // upload streamed-in textures/models within a small per-frame budget
+
         double current_frame_time = glfwGetTime(); //Needed for FPS calculation
 
         double delta_t = current_frame_time - last_frame_time; 
@@ -231,8 +212,11 @@ int App::run(void)
 
         camera.ProcessInput(window, static_cast<float>(delta_t)); 
 
+        if (terrain_streaming)
+            update_terrain_streaming();
+
         // --- Process ground colision ---
-        float terrainY = getTerrainHeight(camera.Position.x, camera.Position.z, Ground.heightmap);
+        float terrainY = getTerrainHeight(camera.Position.x, camera.Position.z);
         float minEyeY = terrainY + eyeHeight;
         if (camera.Position.y < minEyeY) {
             camera.Position.y = minEyeY;
@@ -249,13 +233,17 @@ int App::run(void)
         std::string collidedName;
         glm::vec3 collidedPos(0.0f);
 
-        for (auto const& [name, model] : scene) {
-            if (!model.solid) continue;
-            if (model.intersectsSphere(camera.Position, cameraRadius)) {
-                collision = true;
-                collidedName = name;
-                collidedPos = model.origin;
-                break;
+        // Only the colliders in the grid cells under the camera sphere are tested.
+        if (collision_grid.querySphere(camera.Position, cameraRadius, collision_hits) > 0) {
+            Collider const& hit = colliders[*std::min_element(collision_hits.begin(), collision_hits.end())];
+            collision = true;
+            if (hit.entity.valid()) {
+                collidedName = scene.name(hit.entity);
+                collidedPos = scene.transform(scene.index(hit.entity)).origin;
+            }
+            else {
+                collidedName = *hit.batch_name + ":" + std::to_string(hit.instance);   // e.g. "Cactus:12"
+                collidedPos = (*hit.batch)[hit.instance].origin;
             }
         }
 
@@ -290,18 +278,13 @@ int App::run(void)
             }
         }
 
-        my_shader.setUniform("uV_m", camera.GetViewMatrix());   // Update the view matrix based on the viewmatrix of the camera
-        my_shader.setUniform("uP_m", projection_matrix);        
       
-        // --- Set the color and texture tile (from texture atlas) of the object ---     
-        tile_offset = glm::vec2(14.0f * tile_size, 4.0f * tile_size);
-        my_shader.setUniform("my_color", my_rgba);
-        my_shader.setUniform("tileSize", tile_size);
-        my_shader.setUniform("tileOffset", tile_offset);  
+        // --- Set the color of the objects (atlas tiles are per-model layers of the atlas array) ---
+        my_shader.setUniform(u.color, my_rgba);
 
 
-        my_shader.setUniform("lights[1].position", glm::vec4(camera.Position, 1.0f));
-        my_shader.setUniform("lights[1].direction", glm::vec3(camera.Front.x * delta_t, camera.Front.y * delta_t, camera.Front.z * delta_t));
+        lights[1].position = glm::vec4(camera.Position, 1.0f);
+        lights[1].direction = camera.Front;
 
         // --- make lights[3] red and blinking ---
         {
@@ -332,9 +315,9 @@ int App::run(void)
             glm::vec3 redSpecular = glm::vec3(1.2f * brightness * blinkFactor, 0.2f * blinkFactor, 0.2f * blinkFactor);
 
 
-            my_shader.setUniform("lights[3].ambientM", redAmbient);
-            my_shader.setUniform("lights[3].diffuseM", redDiffuse);
-            my_shader.setUniform("lights[3].specularM", redSpecular);
+            lights[3].ambientM = redAmbient;
+            lights[3].diffuseM = redDiffuse;
+            lights[3].specularM = redSpecular;
         }
         
         // --- set the 3D audio ---
@@ -364,9 +347,19 @@ int App::run(void)
             music = nullptr;
         }
                         
-        // Terrain draw uses opposite winding.
+        // --- Per-frame block data: one upload each for camera/fog and all lights ---
+        frame_ubo.data.view = camera.GetViewMatrix();
+        frame_ubo.data.projection = projection_matrix;
+        frame_ubo.data.camera_position = glm::vec4(camera.Position, 1.0f);
+        frame_ubo.upload();
+        lights_ubo.upload();
+
+        // Terrain draw uses opposite winding; chunks outside the view frustum are skipped.
         glFrontFace(GL_CW);
-        Ground.draw(translate, rotate, scale);
+        if (terrain_lod_enabled && terrain_lod)
+            terrain_lod->draw(projection_matrix, frame_ubo.data.view, camera.Position, height, Ground.atlas_layer);
+        else
+            Ground.draw(projection_matrix * frame_ubo.data.view, translate, rotate, scale);
         glFrontFace(GL_CCW);
 
 
@@ -394,118 +387,181 @@ int App::run(void)
             }
         }
         
-        // Draw non-transparent models first; collect transparent ones for later sorting.
-        transparent.clear();
+        // Scene motion: one pass over the entities, dispatched on their motion component. Projectiles are
+        // collected and stepped together below.
+        airborne.clear();
+        for (std::size_t i = 0; i < scene.size(); ++i) {
+            Scene::Body& body = scene.body(i);
+            if (body.motion == Scene::Motion::Circle) {
+                glm::vec3 const& origin = scene.transform(i).origin;
+                scene.circle(i, static_cast<float>(delta_t), getTerrainHeight(origin.x, origin.z), 90.0f, 0.2f);
+                sync_collider(scene.handle(i));    // follows the plane while it is solid
+                lights[3].position = glm::vec4(origin, 1.0f);   // uploaded with the next frame
+                if (planeSound) {
+                    planeSound->setPosition(irrklang::vec3df(origin.x, origin.y, origin.z));
+                    planeSound->setVelocity(irrklang::vec3df(body.velocity.x, body.velocity.y, body.velocity.z));
+                }
+            }
+            else if (body.motion == Scene::Motion::Ballistic) {
+                airborne.push_back(i);
+            }
+        }
 
-        for (auto& [name, model] : scene) {
-            my_shader.setUniform("N_matrix", model.normal_matrix);
-            if (!model.transparent) {
-                if (name == "my_first_object") {
-                    tile_offset = glm::vec2(4.0f * tile_size, 0.0f * tile_size);
-                    my_shader.setUniform("tileOffset", tile_offset);
-                    model.draw(translate, rotate, scale);
-                }else if (name == "Moving_model") {
-                    tile_offset = glm::vec2(0.0f * tile_size, 3.0f * tile_size);
-                    my_shader.setUniform("tileOffset", tile_offset);
-                    float height = getTerrainHeight(model.origin.x, model.origin.z, Ground.heightmap);
-                    model.circlepath(static_cast<float>(delta_t), height, 90.0f, 0.2f);
-                    my_shader.setUniform("lights[3].position", glm::vec4(model.origin, 1.0f));
-                    if (planeSound) {
-                        planeSound->setPosition(irrklang::vec3df(model.origin.x, model.origin.y, model.origin.z));
-                        planeSound->setVelocity(irrklang::vec3df(model.velocity.x, model.velocity.y, model.velocity.z));
+        // Projectiles get simple physics until they "land" on terrain or on a solid object. They all take the
+        // same substeps, so the terrain under all of them is sampled in one batch per substep.
+        {
+            const float maxStep = 0.02f; // 20 ms per physics substep
+            const float groundEps = 0.01f;
+            auto land = [&](std::size_t i) {
+                scene.body(i).velocity = glm::vec3(0.0f);
+                scene.body(i).motion = Scene::Motion::None;
+                scene.bounds(i).solid = true;
+                sync_collider(scene.handle(i));
+                };
+            auto landed = [&](std::size_t i) { return scene.body(i).motion != Scene::Motion::Ballistic; };
+
+            for (float remaining = static_cast<float>(delta_t); remaining > 0.0f && !airborne.empty(); remaining -= maxStep) {
+                const float step = std::min(remaining, maxStep);
+                airborne_xz.clear();
+                for (std::size_t i : airborne) {
+                    Scene::Body& body = scene.body(i);
+                    const glm::vec3 before = scene.transform(i).origin;
+                    scene.fly(i, step, FaceTracResult);
+                    glm::vec3& origin = scene.transform(i).origin;
+
+                    // Solid objects through the collision grid (the projectile joins it only once it lands):
+                    // back to the last free spot, then drop straight down, or rest there if already dropping.
+                    auto [mn, mx] = scene.worldAABB(i);
+                    const float radius = 0.5f * std::max({ mx.x - mn.x, mx.y - mn.y, mx.z - mn.z });
+                    if (collision_grid.querySphere(0.5f * (mn + mx), radius, collision_hits) > 0) {
+                        origin = before;
+                        if (body.velocity.x == 0.0f && body.velocity.z == 0.0f)
+                            land(i);
+                        body.velocity.x = body.velocity.z = 0.0f;
                     }
-                    model.draw(translate, rotate, scale);
-                }
-                else if (name == "wooden_base") {
-                    tile_offset = glm::vec2(8.0f * tile_size, 1.0f * tile_size);
-                    my_shader.setUniform("tileOffset", tile_offset);
-                    model.draw(translate, rotate, scale);
-                }
-                else if (name == "light_2") {
-                    tile_offset = glm::vec2(1.0f * tile_size, 1.0f * tile_size);
-                    my_shader.setUniform("tileOffset", tile_offset);
-                    model.draw(translate, rotate, scale);
+                    airborne_xz.emplace_back(origin.x, origin.z);
                 }
-                else if (name.rfind("throwable_rock", 0) == 0) {
-                    // Projectiles get simple physics until they "land" on terrain.
-                    const float velocityEps = 1e-4f;
-                    bool inAir = glm::length(model.velocity) > velocityEps;
-
-                    if (inAir) {
-                        float remaining = static_cast<float>(delta_t);
-                        const float maxStep = 0.02f; // 20 ms per physics substep
-                        bool landed = false;
-
-                        while (remaining > 0.0f && !landed) {
-                            float step = std::min(remaining, maxStep);
-                            model.flyghtpath(step, FaceTracResult);
-                            remaining -= step;
-
-                            // check collision with terrain at current XY
-                            float groundY = getTerrainHeight(model.origin.x, model.origin.z, Ground.heightmap);
-                            const float groundEps = 0.01f;
-                            if (model.origin.y <= groundY + groundEps) {
-                                model.origin.y = groundY + groundEps;
-                                model.velocity = glm::vec3(0.0f);
-                                landed = true;
-                                model.solid = true;
-                                model.computeAABB();
-                            }
-                        }
 
-                        model.draw(translate, rotate, scale);
-                    }
-                    else {
-                        model.draw(translate, rotate, scale);
+                // check collision with terrain at the current XZ of every projectile
+                airborne_ground.resize(airborne_xz.size());
+                getTerrainHeights(airborne_xz.data(), airborne_ground.data(), airborne_xz.size());
+                for (std::size_t k = 0; k < airborne.size(); ++k) {
+                    const std::size_t i = airborne[k];
+                    glm::vec3& origin = scene.transform(i).origin;
+                    if (!landed(i) && origin.y <= airborne_ground[k] + groundEps) {
+                        origin.y = airborne_ground[k] + groundEps;
+                        land(i);
                     }
                 }
-                else{
-                    tile_offset = glm::vec2(5.0f * tile_size, 8.0f * tile_size);
-                    my_shader.setUniform("tileOffset", tile_offset);
-                    model.draw(translate, rotate, scale);
-                }
-                
+                airborne.erase(std::remove_if(airborne.begin(), airborne.end(), landed), airborne.end());
             }
-            else
-                transparent.emplace_back(&model); // save pointer for painters algorithm
         }
+        scene.updateMatrices(translate, rotate, scale);
 
-        if (!leftclick) {
-            //scene.erase("throwable_rock");
+        // Frustum culling of the entities and instances; only the visible ones are submitted below.
+        // Instances culled by the compute pass wait until the opaque entities are drawn (Hi-Z test below).
+        const glm::mat4 view_projection = projection_matrix * frame_ubo.data.view;
+        const Frustum view_frustum = object_culling ? Frustum(view_projection) : Frustum();
+        const bool gpu_instances = gpu_instance_culling && instance_culler.ready();
+        {
+            auto cull_start = std::chrono::steady_clock::now();
+            object_cull_stats = {};
+            object_cull_stats.scene_total = scene.size();
+            object_cull_stats.scene_visible = scene.cull(view_frustum);
+            for (auto& [name, batch] : instanced) {
+                object_cull_stats.instances_total += batch.size();
+                if (!gpu_instances)
+                    object_cull_stats.instances_visible += batch.cull(view_frustum);
+            }
+            object_cull_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cull_start).count();
         }
 
-        auto itRock = scene.find("throwable_rock");
-        if (itRock != scene.end()) {
-            const Model& r = itRock->second;
-            std::cout << "[DEBUG] throwable_rock present; origin=("
-                << r.origin.x << "," << r.origin.y << "," << r.origin.z << ") leftclick=" << leftclick << std::endl;
+        // Draw non-transparent models first; collect transparent ones for the transparent pass.
+        // Opaque entities in the geometry arena go out together through scene_draws (K draws them one by one).
+        auto submit_start = std::chrono::steady_clock::now();
+        transparent.clear();
+        for (std::size_t i = 0; i < scene.size(); ++i) {
+            if (!scene.visible(i))
+                continue;
+            if (scene.render(i).transparent) {
+                transparent.push_back(i); // OIT or painter's algorithm below
+                continue;
+            }
+            if (indirect_draws && scene.queue(i, scene_draws))
+                continue;
+            my_shader.setUniform(u.normal_matrix, scene.normalMatrix(i));
+            scene.draw(i);
+        }
+        scene_draws.submit();
+        scene_submit_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
+
+        // Terrain and opaque entities are in the depth buffer now: reduce it to the Hi-Z pyramid and cull the
+        // instances against frustum and pyramid, so props behind hills never reach the lighting shader.
+        // Same-frame depth, so no second terrain pass and no lag when the camera turns.
+        occlusion_active = gpu_instances && occlusion_culling && object_culling && offscreen && hiz.ready();
+        if (gpu_instances) {
+            auto cull_start = std::chrono::steady_clock::now();
+            if (occlusion_active)
+                hiz.build(scene_target.depthTexture(), scene_target.width(), scene_target.height());
+            instance_culler.setOcclusion(occlusion_active ? &hiz : nullptr, view_projection);
+            for (auto& [name, batch] : instanced)
+                batch.cullOnGpu(instance_culler, view_frustum);     // count stays on the GPU
+            my_shader.activate();      // the uniforms below go to the lighting program again
+            object_cull_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cull_start).count();
         }
 
-        tile_offset = glm::vec2(3.0f * tile_size, 4.0f * tile_size);
-        my_shader.setUniform("tileOffset", tile_offset);
-        my_shader.setUniform("my_color", transparent_rgba);
-
-        // SECOND PART - draw only transparent - painter's algorithm (sort by distance from camera, from far to near)
-        std::sort(transparent.begin(), transparent.end(), [&](Model const* a, Model const* b) {
-            glm::vec3 translation_a = glm::vec3(a->model_matrix[3]);  // get 3 values from last column of model matrix = translation
-            glm::vec3 translation_b = glm::vec3(b->model_matrix[3]);  // dtto for model B
-            return glm::distance(camera.Position, translation_a) < glm::distance(camera.Position, translation_b); // sort by distance from camera
-            });
-
-        // set GL for transparent objects // TODO: from lectures
-        glEnable(GL_BLEND);
-        glDepthMask(GL_FALSE); 
-        glDisable(GL_CULL_FACE);
-        // draw sorted transparent
-        for (auto p : transparent) {
-            my_shader.setUniform("N_matrix", p->normal_matrix);
-            my_shader.setUniform("uM_m", p->model_matrix);
-            p->draw();
+        // Cacti and rocks: one instanced draw each over the instances that passed the frustum (and Hi-Z) test.
+        for (auto& [name, batch] : instanced)
+            batch.draw();
+
+        // SECOND PART - transparent objects. With OIT they go out unsorted, queued in one indirect batch (entities
+        // outside the geometry arena one by one), and composite() blends the weighted average over the scene.
+        // Otherwise painter's algorithm: sorted by squared distance from the camera, far to near.
+        auto transparent_start = std::chrono::steady_clock::now();
+        my_shader.activate();
+        my_shader.setUniform(u.color, transparent_rgba);
+        transparent_count = transparent.size();
+        const bool oit = order_independent_transparency && offscreen && !transparent.empty() && transparency.resize(scene_target);
+        if (oit) {
+            transparency.begin();
+            my_shader.setUniform(u.oit, 1);
+            for (std::size_t i : transparent) {
+                if (scene.queue(i, transparent_draws))
+                    continue;
+                my_shader.setUniform(u.normal_matrix, scene.normalMatrix(i));
+                scene.draw(i);
+            }
+            transparent_draws.submit();
+            my_shader.activate();
+            my_shader.setUniform(u.oit, 0);
+            transparency.end();
+            transparency.composite(scene_target);
+        }
+        else {
+            std::sort(transparent.begin(), transparent.end(), [&](std::size_t a, std::size_t b) {
+                glm::vec3 to_a = glm::vec3(scene.modelMatrix(a)[3]) - camera.Position;  // translation column of the model matrix
+                glm::vec3 to_b = glm::vec3(scene.modelMatrix(b)[3]) - camera.Position;
+                return glm::dot(to_a, to_a) > glm::dot(to_b, to_b);    // farther first, no sqrt needed to compare
+                });
+
+            // set GL for transparent objects // TODO: from lectures
+            glEnable(GL_BLEND);
+            glDepthMask(GL_FALSE);
+            glDisable(GL_CULL_FACE);
+            // draw sorted transparent
+            for (std::size_t i : transparent) {
+                my_shader.setUniform(u.normal_matrix, scene.normalMatrix(i));
+                scene.draw(i);
+            }
+            // restore GL properties for non-transparent objects // TODO: from lectures
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+            glEnable(GL_CULL_FACE);
         }
-        // restore GL properties for non-transparent objects // TODO: from lectures
-        glDisable(GL_BLEND);
-        glDepthMask(GL_TRUE);
-        glEnable(GL_CULL_FACE);
+        transparent_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - transparent_start).count();
+
+        if (offscreen)
+            scene_target.present();
 
         updateFPS();
         glfwSwapBuffers(window);        
@@ -514,6 +570,29 @@ int App::run(void)
 
     // Shutdown worker and window resources.
     if (tracker.workerRunning()) tracker.stopWorker();
+    if (assets) assets->shutdown();
+
+    // Drop the shared texture and geometry handles while the GL context still exists.
+    collision_grid.clear();
+    colliders.clear();
+    scene.clear();
+    for (auto& [name, batch] : instanced)
+        batch.clear();
+    instanced.clear();
+    projectile = Model();
+    scene_draws.destroy();
+    transparent_draws.destroy();
+    transparency.destroy();
+    instance_culler.destroy();
+    hiz.destroy();
+    scene_target.destroy();
+    GeometryArena::get().destroy();
+    Ground.meshes.clear();
+    terrain_lod.reset();
+    terrain_tiles.close();
+    atlas_texture.reset();
+    frame_ubo.clear();
+    lights_ubo.clear();
 
     // Close OpenGL window if opened and terminate GLFW
     if (window)
@@ -542,8 +621,22 @@ App::~App()
 App app;
 
 
-int main()
+int main(int argc, char* argv[])
 {
+    // --terrain <heightmap or .tiles file>, --stream-terrain (stream the heightmap tile by tile, see App::terrain_streaming)
+    std::filesystem::path terrain;
+    bool stream_terrain = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--stream-terrain")
+            stream_terrain = true;
+        else if (arg == "--terrain" && i + 1 < argc)
+            terrain = argv[++i];
+        else
+            std::cerr << "Unknown argument: " << arg << '\n';
+    }
+    app.set_terrain(terrain, stream_terrain);
+
     if (!app.init()) {
         std::cerr << "App initialization failed.\n";
         return 3; 
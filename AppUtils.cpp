@@ -1,4 +1,5 @@
 #include "AppUtils.hpp"
+#include "RenderState.hpp"
 
 #include <GLFW/glfw3.h>
 #include <algorithm>
@@ -17,48 +18,269 @@ void App::update_projection_matrix() {  //Update the projection matrix
         0.1f,                // Near clipping plane
         300.0f               // Far clipping plane
     );
-    my_shader.setUniform("uP_m", projection_matrix);
 }
 
 void App::updateFPS() { // Calculate the FPS of the application by counting the frames for 1 second
     frame_count++;
+    terrain_submit_ms += Ground.cull_stats.submit_ms;
 
     TimePoint currentTime = Clock::now();
     float elapsed = std::chrono::duration<float>(currentTime - last_time).count();
 
     if (elapsed >= 1.0f) {
         fps = frame_count;
+
+        // Uniform update cost per frame (U toggles profiling, L switches to per-call glGetUniformLocation).
+        auto& uniforms = ShaderProgram::uniformStats();
+        if (ShaderProgram::profile_uniforms && frame_count > 0) {
+            std::cout << "[Uniforms] " << (uniforms.by_name + uniforms.by_handle) / frame_count << " calls/frame ("
+                << uniforms.by_name / frame_count << " by name, " << uniforms.by_handle / frame_count << " by handle), "
+                << uniforms.cpu_ms * 1000.0 / frame_count << " us/frame CPU, name lookup: "
+                << (ShaderProgram::legacy_uniform_lookup ? "glGetUniformLocation" : "reflected table") << '\n';
+        }
+        uniforms = {};
+
+        // GL binds skipped by RenderState because the state was already set.
+        RenderState& state = RenderState::get();
+        if (ShaderProgram::profile_uniforms && frame_count > 0) {
+            auto const& st = state.stats();
+            std::cout << "[RenderState] " << st.issued / frame_count << " calls/frame issued, "
+                << st.elided() / frame_count << " elided (" << st.elided_programs / frame_count << " program, "
+                << st.elided_vertex_arrays / frame_count << " VAO, " << st.elided_textures / frame_count << " texture, "
+                << st.elided_uniforms / frame_count << " uniform)\n";
+        }
+        state.resetStats();
+
+        // Terrain chunks that passed frustum culling in the last frame (or the LOD selection).
+        if (ShaderProgram::profile_uniforms && terrain_lod_enabled && terrain_lod) {
+            auto const& lod = terrain_lod->stats();
+            std::cout << "[Terrain LOD] " << lod.patches << " patches (" << lod.nodes_visited << " nodes visited, levels 0-"
+                << lod.coarsest_level << " of " << terrain_lod->levels() << "), " << lod.triangles << " triangles, full resolution "
+                << lod.full_res_triangles << ", pixel error " << terrain_lod->pixel_error << "\n";
+        }
+        else if (ShaderProgram::profile_uniforms && frame_count > 0) {
+            // P switches the strip submission, to compare the driver CPU time of both ways.
+            auto const& terrain = Ground.cull_stats;
+            std::cout << "[Terrain] " << terrain.chunks_visible << "/" << terrain.chunks_total << " chunks, "
+                << terrain.triangles_visible << "/" << terrain.triangles_total << " triangles drawn, "
+                << terrain.draw_calls << " draw calls ("
+                << (Mesh::strip_submission == Mesh::StripSubmission::MultiDraw ? "glMultiDrawElements" : "glDrawElements per strip")
+                << "), " << terrain_submit_ms * 1000.0 / frame_count << " us/frame submit CPU\n";
+        }
+        terrain_submit_ms = 0.0;
+
+        // Collision broadphase: grid cells and boxes the camera/projectile queries touched.
+        auto const& grid = collision_grid.stats();
+        if (ShaderProgram::profile_uniforms && frame_count > 0 && grid.queries > 0) {
+            std::cout << "[Collision] " << collision_grid.size() << " colliders in " << collision_grid.cellCount() << " cells, "
+                << grid.queries / frame_count << " queries/frame, " << static_cast<double>(grid.tests) / grid.queries
+                << " boxes tested/query (" << static_cast<double>(grid.cells) / grid.queries << " cells)\n";
+        }
+        collision_grid.resetStats();
+
+        // Scene entities and instances submitted after frustum culling (O switches culling off to compare,
+        // B moves the instances between the compute pass and the CPU).
+        const bool gpu_instances = gpu_instance_culling && instance_culler.ready();
+        if (ShaderProgram::profile_uniforms && frame_count > 0) {
+            auto objects = object_cull_stats;
+            if (gpu_instances) {
+                // Counts of the last dispatches, read back once per report (waits for the GPU).
+                for (auto const& [name, batch] : instanced)
+                    objects.instances_visible += batch.gpuVisibleCount();
+            }
+            std::cout << "[Objects] " << objects.scene_visible + objects.instances_visible << "/"
+                << objects.scene_total + objects.instances_total << " drawn (scene " << objects.scene_visible << "/"
+                << objects.scene_total << ", instances " << objects.instances_visible << "/" << objects.instances_total
+                << (gpu_instances ? " by compute shader" : "") << "), culling " << (object_culling ? "on" : "off") << ", "
+                << object_cull_ms * 1000.0 / frame_count << " us/frame CPU (" << Frustum::simdPath() << ")";
+            if (gpu_instances)
+                std::cout << ", " << instance_culler.stats().dispatches / frame_count << " dispatches/frame";
+            std::cout << '\n';
+        }
+
+        // Frustum-visible instances the Hi-Z test dropped over the interval (H switches it off to compare).
+        if (ShaderProgram::profile_uniforms && frame_count > 0 && gpu_instances) {
+            auto const occlusion = instance_culler.occlusion();
+            std::cout << "[Occlusion] " << (occlusion_active ? "on" : "off") << ", "
+                << occlusion.occluded / frame_count << " of " << occlusion.tested / frame_count
+                << " instances in the frustum hidden per frame (" << (occlusion.tested ? 100.0 * occlusion.occluded / occlusion.tested : 0.0)
+                << "%), Hi-Z " << hiz.size().x << "x" << hiz.size().y << " with " << hiz.levels() << " levels\n";
+        }
+        object_cull_ms = 0.0;
+        instance_culler.resetStats();
+
+        // Opaque scene submission: meshes per glMultiDrawElementsIndirect against one draw call each (K).
+        if (ShaderProgram::profile_uniforms && frame_count > 0) {
+            auto const& draws = scene_draws.stats();
+            auto const& arena = GeometryArena::get().stats();
+            std::cout << "[Indirect] " << (indirect_draws ? "on" : "off") << ", " << draws.draws << " meshes in "
+                << draws.calls << " glMultiDrawElementsIndirect, " << scene_submit_ms * 1000.0 / frame_count
+                << " us/frame opaque submit CPU, arena " << arena.meshes << " meshes, " << arena.vertices << "/"
+                << arena.vertex_capacity << " vertices, " << arena.indices << "/" << arena.index_capacity << " indices\n";
+        }
+        scene_submit_ms = 0.0;
+
+        // Transparent pass: weighted blended OIT in one indirect batch, or the painter's sort (J).
+        if (ShaderProgram::profile_uniforms && frame_count > 0) {
+            const bool oit = order_independent_transparency && transparency.ready() && scene_target.ready();
+            std::cout << "[Transparency] " << (oit ? "weighted blended OIT" : "sorted") << ", " << transparent_count
+                << " objects";
+            if (oit)
+                std::cout << " in " << transparent_draws.stats().calls << " glMultiDrawElementsIndirect";
+            std::cout << ", " << transparent_ms * 1000.0 / frame_count << " us/frame CPU\n";
+        }
+        transparent_ms = 0.0;
+
+        // Streamed terrain: tiles in memory against the budget, and how the window is doing.
+        if (ShaderProgram::profile_uniforms && terrain_tiles.isOpen()) {
+            auto const& tiles = terrain_tiles.stats();
+            std::cout << "[Terrain tiles] " << tiles.resident << "/" << tiles.budget << " tiles resident ("
+                << tiles.resident_bytes / (1024.0 * 1024.0) << " MB), " << tiles.pending << " pending, "
+                << tiles.loads << " loads, " << tiles.evictions << " evictions, window at cell " << terrain_window_first.x
+                << "," << terrain_window_first.y << " with " << terrain_window_fallback << " overview tiles\n";
+        }
+
         frame_count = 0;
         last_time = currentTime;
     }
 }
 
-float App::getTerrainHeight(float x, float z, const std::vector<std::vector<float>>& heightmap) const {
-    int terrainWidth = Ground.width;
-    int terrainHeight = Ground.height;
-    float terrainScale = Ground.scale.x;  // Only need to be changed if the scale of the heightmap is changed
-    float fx = (x + terrainHeight / 2.0f) / terrainScale;
-    float fz = (z + terrainWidth / 2.0f) / terrainScale;
-
-    int ix = static_cast<int>(fx);
-    int iz = static_cast<int>(fz);
-
-    // Clamp to terrain boundaries
-    ix = std::max(0, std::min(ix, terrainWidth - 2));
-    iz = std::max(0, std::min(iz, terrainHeight - 2));
-
-    // Heights of surrounding points
-    float h00 = heightmap[ix][iz];
-    float h10 = heightmap[ix + 1][iz];
-    float h01 = heightmap[ix][iz + 1];
-    float h11 = heightmap[ix + 1][iz + 1];
-
-    // Fractional part for interpolation
-    float fracx = fx - ix;
-    float fracz = fz - iz;
-
-    // Bilinear interpolation
-    float h0 = h00 * (1.0f - fracx) + h10 * fracx;
-    float h1 = h01 * (1.0f - fracx) + h11 * fracx;
-    return h0 * (1.0f - fracz) + h1 * fracz;
+float App::getTerrainHeight(float x, float z) const {
+    // Bilinear sample of the flat height grid (clamped at the terrain border).
+    if (terrain_tiles.isOpen())
+        return terrain_tiles.sample(x, z);
+    return Ground.heights.sample(x, z);
+}
+
+void App::getTerrainHeights(glm::vec2 const* xz, float* out, std::size_t count) const {
+    if (terrain_tiles.isOpen()) {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = terrain_tiles.sample(xz[i].x, xz[i].y);
+        return;
+    }
+    Ground.heights.sample(xz, out, count);
+}
+
+void App::sync_collider(Scene::Handle entity) {
+    if (!scene.alive(entity))
+        return;
+    const std::size_t i = scene.index(entity);
+    Scene::Bounds& bounds = scene.bounds(i);
+
+    if (!bounds.solid) {
+        if (bounds.collider != SpatialHash::kInvalid) {
+            collision_grid.remove(bounds.collider);
+            bounds.collider = SpatialHash::kInvalid;
+        }
+        return;
+    }
+
+    auto [mn, mx] = scene.worldAABB(i);
+    if (bounds.collider != SpatialHash::kInvalid) {
+        collision_grid.update(bounds.collider, mn, mx);
+        return;
+    }
+    bounds.collider = collision_grid.insert(mn, mx);
+    if (colliders.size() <= bounds.collider)
+        colliders.resize(bounds.collider + 1);
+    colliders[bounds.collider] = { entity, nullptr, nullptr, 0 };
+}
+
+void App::add_colliders(std::string const& name) {
+    auto it = instanced.find(name);
+    if (it == instanced.end() || !it->second.solid)
+        return;
+    InstancedModel const& batch = it->second;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        auto [mn, mx] = batch.getWorldAABB(i);
+        SpatialHash::Id id = collision_grid.insert(mn, mx);
+        if (colliders.size() <= id)
+            colliders.resize(id + 1);
+        colliders[id] = { Scene::Handle{}, &it->first, &batch, i };
+    }
+}
+
+void App::set_terrain(std::filesystem::path const& file, bool streamed) {
+    if (!file.empty())
+        terrain_file = file;
+    terrain_streaming = streamed;
+}
+
+void App::update_terrain_streaming() {
+    if (!terrain_tiles.isOpen())
+        return;
+
+    // Ask for every tile the window can reach, nearest first (the budget caps what stays resident).
+    const int T = terrain_tiles.tileSize();
+    const float scale = terrain_tiles.scale();
+    terrain_tiles.update(camera.Position.x, camera.Position.z, kTerrainWindowTiles * T * scale * 0.75f);
+
+    // Window of kTerrainWindowTiles tiles per side, tile-aligned, with the camera's tile in the middle.
+    const int rows = terrain_tiles.rows(), cols = terrain_tiles.cols();
+    const glm::ivec2 window_cells(std::min(kTerrainWindowTiles * T + 1, rows), std::min(kTerrainWindowTiles * T + 1, cols));
+    auto firstCell = [&](float world, int cells, int window) {
+        int camera_tile = static_cast<int>(std::floor((world / scale + cells / 2.0f) / T));
+        int first = (camera_tile - kTerrainWindowTiles / 2) * T;
+        return std::clamp(first, 0, std::max(cells - window, 0));
+        };
+    const glm::ivec2 first(firstCell(camera.Position.x, rows, window_cells.x), firstCell(camera.Position.z, cols, window_cells.y));
+
+    // The window is made once, at its fixed size; its ring has room for every tile it can touch.
+    const glm::ivec2 ring_cells(std::min(kTerrainRingTiles * T, rows), std::min(kTerrainRingTiles * T, cols));
+    const bool created = !terrain_lod;
+    if (created) {
+        terrain_lod = std::make_unique<TerrainLOD>(window_cells, ring_cells, scale,
+            ShaderProgram("terrain_lod.vert", "lighting_shader.frag"), first, glm::ivec2(rows, cols));
+        terrain_ring_tiles.clear();
+    }
+
+    // Update when the camera changed tiles, or when tiles that were missing (overview heights) have arrived.
+    const std::uint64_t loads = terrain_tiles.stats().loads;
+    const bool moved = first != terrain_window_first;
+    const bool refined = terrain_window_fallback > 0 && loads != terrain_window_loads;
+    if (!created && !moved && !refined)
+        return;
+    terrain_lod->moveWindow(first);
+    terrain_window_first = first;
+    terrain_window_loads = loads;
+
+    // Write the tiles under the window that are not in the ring, or only as overview heights while the real
+    // tile is resident now. A tile owns its first T rows/columns; the last tile also owns the map's last ones.
+    auto extent = [&](int t, int tiles, int cells) { return t == tiles - 1 ? cells - t * T : T; };
+    auto overlaps = [](int a, int a_size, int b, int b_size, int n) {
+        const int d = ((b - a) % n + n) % n;
+        return d < a_size || n - d < b_size;
+    };
+    const int tile_rows = terrain_tiles.tileRows(), tile_cols = terrain_tiles.tileCols();
+    const int last_tr = std::min((first.x + window_cells.x - 1) / T, tile_rows - 1);
+    const int last_tc = std::min((first.y + window_cells.y - 1) / T, tile_cols - 1);
+    std::size_t fallback = 0;
+    for (int tr = first.x / T; tr <= last_tr; ++tr)
+        for (int tc = first.y / T; tc <= last_tc; ++tc) {
+            float const* tile = terrain_tiles.tile(tr, tc);
+            auto it = std::find_if(terrain_ring_tiles.begin(), terrain_ring_tiles.end(),
+                [&](RingTile const& t) { return t.tr == tr && t.tc == tc; });
+            if (it != terrain_ring_tiles.end() && (it->exact || !tile)) {
+                fallback += it->exact ? 0 : 1;
+                continue;
+            }
+
+            const glm::ivec2 origin(tr * T, tc * T);
+            const glm::ivec2 size(extent(tr, tile_rows, rows), extent(tc, tile_cols, cols));
+            if (tile)
+                terrain_lod->writeHeights(origin, size, tile, T + 1);
+            else {
+                terrain_tiles.window(origin.x, origin.y, size.x, size.y, terrain_tile_heights);
+                terrain_lod->writeHeights(origin, size, terrain_tile_heights.data(), size.y);
+                ++fallback;
+            }
+
+            // Tiles whose ring texels this write covered are no longer in the ring.
+            terrain_ring_tiles.erase(std::remove_if(terrain_ring_tiles.begin(), terrain_ring_tiles.end(), [&](RingTile const& t) {
+                return overlaps(t.tr * T, extent(t.tr, tile_rows, rows), origin.x, size.x, ring_cells.x)
+                    && overlaps(t.tc * T, extent(t.tc, tile_cols, cols), origin.y, size.y, ring_cells.y);
+                }), terrain_ring_tiles.end());
+            terrain_ring_tiles.push_back({ tr, tc, tile != nullptr });
+        }
+    terrain_window_fallback = fallback;
 }
\ No newline at end of file
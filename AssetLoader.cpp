@@ -0,0 +1,228 @@
+#include "AssetLoader.hpp"
+#include "StartupProfile.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+AssetLoader::AssetLoader(TextureCache& cache, TextureUpload upload_texture, ArrayUpload upload_array,
+    std::size_t max_ready, unsigned int workers)
+    : cache_(cache), upload_texture_(std::move(upload_texture)), upload_array_(std::move(upload_array)), max_ready_(std::max<std::size_t>(1, max_ready)) {
+    if (workers == 0) {
+        const unsigned int hw = std::thread::hardware_concurrency();
+        workers = hw > 1 ? hw - 1 : 1;
+    }
+    workers_.reserve(workers);
+    for (unsigned int i = 0; i < workers; ++i)
+        workers_.emplace_back(&AssetLoader::workerLoop, this);
+}
+
+AssetLoader::~AssetLoader() {
+    shutdown();
+}
+
+void AssetLoader::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        jobs_.clear();
+    }
+    work_cv_.notify_all();
+    ready_cv_.notify_all();
+    for (auto& w : workers_)
+        if (w.joinable()) w.join();
+    workers_.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.clear();
+    waiting_.clear();
+}
+
+void AssetLoader::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (stopping_) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            ++in_flight_;
+        }
+
+        try {
+            job();
+        }
+        catch (std::exception const& e) {
+            std::cerr << "Asset loader: " << e.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        --in_flight_;
+    }
+}
+
+void AssetLoader::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    work_cv_.notify_one();
+}
+
+void AssetLoader::pushReady(Upload upload) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_cv_.wait(lock, [this] { return stopping_ || ready_.size() < max_ready_; });
+    if (stopping_) return;
+    ready_.push_back(std::move(upload));
+}
+
+void AssetLoader::uploadTexture(TextureRef const& texture, cv::Mat& image) {
+    if (!image.empty()) {
+        try {
+            texture->id = upload_texture_(image);
+            texture->bytes = image.total() * image.elemSize();
+        }
+        catch (std::exception const& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    texture->done = true;
+}
+
+AssetLoader::TextureRef AssetLoader::loadTexture(const std::filesystem::path& path) {
+    bool created = false;
+    TextureRef texture = cache_.acquire(path.lexically_normal().generic_string(), created);
+    if (!created)
+        return texture;
+
+    submit([this, path, texture] {
+        std::shared_ptr<const cv::Mat> image;
+        {
+            StartupProfile::Scope timing(StartupProfile::get(), "decode " + path.string());
+            image = cache_.image(path);
+        }
+        if (image->empty())
+            std::cerr << "No texture in file: " << path.string() << std::endl;
+
+        pushReady({ [this, texture, image] {
+            cv::Mat mat = *image;   // header copy, gen_tex does not modify the pixels
+            uploadTexture(texture, mat);
+        }, nullptr });
+    });
+    return texture;
+}
+
+AssetLoader::TextureRef AssetLoader::loadAtlasArray(const std::filesystem::path& path, int tilesPerRow) {
+    bool created = false;
+    TextureRef texture = cache_.acquire(path.lexically_normal().generic_string() + "#array/" + std::to_string(tilesPerRow), created);
+    if (!created)
+        return texture;
+
+    submit([this, path, tilesPerRow, texture] {
+        std::shared_ptr<const cv::Mat> atlas;
+        {
+            StartupProfile::Scope timing(StartupProfile::get(), "decode " + path.string());
+            atlas = cache_.image(path);
+        }
+        if (atlas->empty())
+            std::cerr << "Cannot open atlas: " << path.string() << std::endl;
+
+        pushReady({ [this, texture, atlas, tilesPerRow] {
+            if (!atlas->empty()) {
+                try {
+                    cv::Mat mat = *atlas;
+                    texture->id = upload_array_(mat, tilesPerRow);
+                    texture->bytes = mat.total() * mat.elemSize();
+                }
+                catch (std::exception const& e) {
+                    std::cerr << e.what() << std::endl;
+                }
+            }
+            texture->done = true;
+        }, nullptr });
+    });
+    return texture;
+}
+
+void AssetLoader::loadModel(const std::filesystem::path& path, ShaderProgram shader, TextureRef texture,
+    std::function<void(Model&)> on_ready, bool keep_vertices) {
+    loadModel(path, shader, std::move(texture), -1, std::move(on_ready), keep_vertices);
+}
+
+void AssetLoader::loadModel(const std::filesystem::path& path, ShaderProgram shader, TextureRef texture, int atlas_layer,
+    std::function<void(Model&)> on_ready, bool keep_vertices) {
+    // Atlas layers are sampled from the array bound by the app, the mesh binds no texture of its own.
+    auto finish = [texture, atlas_layer, on_ready](Model& model) {
+        model.texture_ref = texture;
+        model.atlas_layer = atlas_layer;
+        on_ready(model);
+    };
+
+    // Geometry of this file is on the GPU already: no parse, just wait for the texture. Geometry without
+    // the CPU vertices is loaded again when they are wanted.
+    const std::string key = path.lexically_normal().generic_string();
+    GeometryHandle geometry = MeshRegistry::get().find(key);
+    if (geometry && (!keep_vertices || !geometry->vertices.empty())) {
+        waiting_.push_back({ [geometry, shader, texture, atlas_layer, finish] {
+            Model model(geometry, shader, (texture && atlas_layer < 0) ? texture->id : 0);
+            finish(model);
+        }, texture });
+        return;
+    }
+
+    submit([this, path, key, shader, texture, atlas_layer, keep_vertices, finish] {
+        auto data = std::make_shared<MeshData>();
+        Model::loadMeshData(path, *data);
+
+        pushReady({ [data, key, shader, texture, atlas_layer, keep_vertices, finish] {
+            Model model(std::move(*data), shader, (texture && atlas_layer < 0) ? texture->id : 0, keep_vertices);
+            if (GeometryHandle geometry = model.geometry())
+                MeshRegistry::get().add(key, geometry);
+            finish(model);
+        }, texture });
+    });
+}
+
+void AssetLoader::whenDone(TextureRef texture, std::function<void(GLuint)> callback) {
+    waiting_.push_back({ [texture, callback = std::move(callback)] { callback(texture->id); }, texture });
+}
+
+std::size_t AssetLoader::pump(double budget_ms) {
+    const auto start = StartupProfile::Clock::now();
+    auto runnable = [](Upload const& u) { return !u.waits_for || u.waits_for->done; };
+
+    std::size_t ran = 0;
+    for (;;) {
+        Upload next;
+        auto it = std::find_if(waiting_.begin(), waiting_.end(), runnable);
+        if (it != waiting_.end()) {
+            next = std::move(*it);
+            waiting_.erase(it);
+        }
+        else {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (ready_.empty()) break;
+                next = std::move(ready_.front());
+                ready_.pop_front();
+            }
+            ready_cv_.notify_one();
+
+            if (!runnable(next)) {
+                waiting_.push_back(std::move(next));
+                continue;
+            }
+        }
+
+        next.run();
+        ++ran;
+        if (StartupProfile::msSince(start) >= budget_ms) break;
+    }
+    return ran;
+}
+
+bool AssetLoader::idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.empty() && ready_.empty() && in_flight_ == 0 && waiting_.empty();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <GL/glew.h>
+
+#include "Model.hpp"
+#include "ShaderProgram.hpp"
+#include "TextureCache.hpp"
+
+// Streams textures and meshes in the background, so the first frame does not wait for them.
+// Worker threads decode images and parse meshes; everything that touches GL runs on the GL thread
+// in pump(), which drains a bounded queue of finished jobs within a per-frame time budget.
+class AssetLoader {
+public:
+    // GL texture filled in by pump(); shared with every other load of the same file or atlas.
+    using TextureRef = TextureHandle;
+
+    // Create the GL texture from a decoded image (App::gen_tex), or a texture array from an atlas
+    // with `tilesPerRow` tiles per row (App::gen_tex_array).
+    using TextureUpload = std::function<GLuint(cv::Mat&)>;
+    using ArrayUpload = std::function<GLuint(cv::Mat&, int tilesPerRow)>;
+
+    // Decodes go through `cache` (each file once) and textures are shared per file/atlas.
+    // max_ready: finished jobs that may wait for upload before workers block (bounds decoded memory).
+    // workers: 0 = hardware threads - 1 (the GL thread keeps one core), at least one.
+    AssetLoader(TextureCache& cache, TextureUpload upload_texture, ArrayUpload upload_array,
+        std::size_t max_ready = 8, unsigned int workers = 0);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // GL thread. Returns the live handle right away when the file is loaded or loading already.
+    TextureRef loadTexture(const std::filesystem::path& path);
+
+    // Square-tiled atlas as a GL_TEXTURE_2D_ARRAY, tile (x, y) = layer y * tilesPerRow + x.
+    TextureRef loadAtlasArray(const std::filesystem::path& path, int tilesPerRow = 16);
+
+    // Parse the mesh on a worker; once it is uploaded and `texture` (may be null) is done,
+    // on_ready gets the model on the GL thread. The model keeps a reference to the texture.
+    // Files whose geometry is still alive in MeshRegistry are not parsed or uploaded again.
+    // keep_vertices: the model keeps its vertices on the CPU for placement queries (Model::vertices()).
+    void loadModel(const std::filesystem::path& path, ShaderProgram shader, TextureRef texture,
+        std::function<void(Model&)> on_ready, bool keep_vertices = false);
+
+    // Same, textured with one layer of an atlas array from loadAtlasArray().
+    void loadModel(const std::filesystem::path& path, ShaderProgram shader, TextureRef atlas, int atlas_layer,
+        std::function<void(Model&)> on_ready, bool keep_vertices = false);
+
+    // GL thread: call `callback` with the texture id from pump() once `texture` is done.
+    void whenDone(TextureRef texture, std::function<void(GLuint)> callback);
+
+    // GL thread: run finished jobs until none are left or `budget_ms` is used up (at least one runs).
+    // Returns how many ran.
+    std::size_t pump(double budget_ms);
+
+    // True when nothing is decoding, queued or waiting for a texture.
+    bool idle() const;
+
+    // Stop the workers and drop everything not uploaded yet. Call on the GL thread while the context is alive.
+    void shutdown();
+
+private:
+    struct Upload {
+        std::function<void()> run;
+        TextureRef waits_for;   // run only once this texture is done
+    };
+
+    void workerLoop();
+    void submit(std::function<void()> job);
+    void pushReady(Upload upload);  // from workers: blocks while the ready queue is full
+    void uploadTexture(TextureRef const& texture, cv::Mat& image);
+
+    TextureCache& cache_;
+    TextureUpload upload_texture_;
+    ArrayUpload upload_array_;
+    std::size_t max_ready_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable ready_cv_;
+    std::deque<std::function<void()>> jobs_;
+    std::deque<Upload> ready_;
+    std::size_t in_flight_ = 0;     // jobs taken by a worker and not finished yet
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    // GL thread only: finished jobs whose texture is not uploaded yet. Kept outside the bounded
+    // queue, so they can never block the worker that decodes that texture.
+    std::deque<Upload> waiting_;
+};
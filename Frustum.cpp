@@ -0,0 +1,91 @@
+#include "Frustum.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FRUSTUM_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2 1
+#endif
+
+const char* Frustum::simdPath() {
+#if defined(FRUSTUM_AVX2)
+    return "AVX2";
+#elif defined(FRUSTUM_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+std::size_t Frustum::cull(BoxList const& boxes, std::uint8_t* visible) const {
+    const std::size_t count = boxes.size();
+
+    // The p-vertex of intersects() per plane: the sign of each normal component picks the min or max array,
+    // once for all boxes, so the loops below only multiply and add.
+    struct Corner {
+        float const* x;
+        float const* y;
+        float const* z;
+    } corner[Count];
+    for (int p = 0; p < Count; ++p) {
+        glm::vec4 const& n = planes_[p];
+        corner[p] = { (n.x >= 0.0f ? boxes.max_x : boxes.min_x).data(),
+            (n.y >= 0.0f ? boxes.max_y : boxes.min_y).data(),
+            (n.z >= 0.0f ? boxes.max_z : boxes.min_z).data() };
+    }
+
+    std::size_t i = 0;
+    std::size_t inside = 0;
+
+#if defined(FRUSTUM_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 in = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < Count; ++p) {
+            glm::vec4 const& n = planes_[p];
+            __m256 d = _mm256_mul_ps(_mm256_set1_ps(n.x), _mm256_loadu_ps(corner[p].x + i));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(n.y), _mm256_loadu_ps(corner[p].y + i)));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(n.z), _mm256_loadu_ps(corner[p].z + i)));
+            d = _mm256_add_ps(d, _mm256_set1_ps(n.w));
+            in = _mm256_and_ps(in, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(in);
+        for (int k = 0; k < 8; ++k)
+            visible[i + k] = static_cast<std::uint8_t>((mask >> k) & 1);
+        inside += static_cast<std::size_t>(_mm_popcnt_u32(static_cast<unsigned>(mask)));
+    }
+#elif defined(FRUSTUM_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 in = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < Count; ++p) {
+            glm::vec4 const& n = planes_[p];
+            __m128 d = _mm_mul_ps(_mm_set1_ps(n.x), _mm_loadu_ps(corner[p].x + i));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(n.y), _mm_loadu_ps(corner[p].y + i)));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(n.z), _mm_loadu_ps(corner[p].z + i)));
+            d = _mm_add_ps(d, _mm_set1_ps(n.w));
+            in = _mm_and_ps(in, _mm_cmpge_ps(d, _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(in);
+        for (int k = 0; k < 4; ++k) {
+            visible[i + k] = static_cast<std::uint8_t>((mask >> k) & 1);
+            inside += visible[i + k];
+        }
+    }
+#endif
+
+    // Tail (and the scalar build). All paths add in the order of intersects(), so the results match it exactly.
+    for (; i < count; ++i) {
+        bool in = true;
+        for (int p = 0; p < Count; ++p) {
+            glm::vec4 const& n = planes_[p];
+            float d = n.x * corner[p].x[i];
+            d += n.y * corner[p].y[i];
+            d += n.z * corner[p].z[i];
+            d += n.w;
+            in = in && d >= 0.0f;
+        }
+        visible[i] = in ? 1 : 0;
+        inside += visible[i];
+    }
+    return inside;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// View frustum as six planes (n.x * x + n.y * y + n.z * z + d >= 0 inside), extracted from a clip matrix
+// (Gribb/Hartmann). With projection * view the planes are in world space; with projection * view * model
+// they are in that model's local space, so local bounding boxes can be tested without transforming them.
+class Frustum {
+public:
+    enum Plane { Left, Right, Bottom, Top, Near, Far, Count };
+
+    Frustum() = default;
+
+    explicit Frustum(glm::mat4 const& clip) {
+        // glm is column-major: row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]).
+        auto row = [&](int i) { return glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]); };
+        const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+        planes_[Left] = r3 + r0;
+        planes_[Right] = r3 - r0;
+        planes_[Bottom] = r3 + r1;
+        planes_[Top] = r3 - r1;
+        planes_[Near] = r3 + r2;    // OpenGL clip space, z in [-w, w]
+        planes_[Far] = r3 - r2;
+
+        for (auto& p : planes_) {
+            float len = glm::length(glm::vec3(p));
+            if (len > 0.0f) p /= len;
+        }
+    }
+
+    glm::vec4 const& plane(int i) const { return planes_[i]; }
+
+    // World-space boxes with every coordinate in its own array, the layout cull() reads 4/8 boxes at a time from.
+    struct BoxList {
+        std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+
+        std::size_t size() const { return min_x.size(); }
+        void resize(std::size_t n) {
+            for (auto* v : { &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+                v->resize(n);
+        }
+        void set(std::size_t i, glm::vec3 const& mn, glm::vec3 const& mx) {
+            min_x[i] = mn.x; min_y[i] = mn.y; min_z[i] = mn.z;
+            max_x[i] = mx.x; max_y[i] = mx.y; max_z[i] = mx.z;
+        }
+        // Box around the local box [mn, mx] transformed by `m`, rotation included: the center is transformed,
+        // the half extents go through the absolute values of the 3x3 part.
+        void setTransformed(std::size_t i, glm::mat4 const& m, glm::vec3 const& mn, glm::vec3 const& mx) {
+            glm::vec3 c = (mn + mx) * 0.5f, e = (mx - mn) * 0.5f;
+            glm::vec3 wc = glm::vec3(m * glm::vec4(c, 1.0f));
+            glm::vec3 we(0.0f);
+            for (int col = 0; col < 3; ++col)
+                for (int row = 0; row < 3; ++row)
+                    we[row] += std::abs(m[col][row]) * e[col];
+            set(i, wc - we, wc + we);
+        }
+    };
+
+    // visible[i] = 1 if box i passes intersects(), else 0; 8 (AVX2) or 4 (SSE2) boxes per step.
+    // Returns the number of visible boxes.
+    std::size_t cull(BoxList const& boxes, std::uint8_t* visible) const;
+
+    // Instruction set cull() was compiled for ("AVX2", "SSE2" or "scalar").
+    static const char* simdPath();
+
+    // False only if the box lies completely outside one plane. Boxes near a frustum edge may pass
+    // although they are not visible; a visible box is never rejected.
+    bool intersects(glm::vec3 const& mn, glm::vec3 const& mx) const {
+        for (auto const& p : planes_) {
+            // Box corner furthest along the plane normal.
+            glm::vec3 v(p.x >= 0.0f ? mx.x : mn.x,
+                p.y >= 0.0f ? mx.y : mn.y,
+                p.z >= 0.0f ? mx.z : mn.z);
+            if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    glm::vec4 planes_[Count]{};
+};
@@ -0,0 +1,151 @@
+#include "GeometryArena.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "RenderState.hpp"
+
+std::size_t GeometryArena::Ranges::allocate(std::size_t count) {
+    for (auto it = free_.begin(); it != free_.end(); ++it) {
+        if (it->second < count)
+            continue;
+        std::size_t first = it->first;
+        std::size_t rest = it->second - count;
+        free_.erase(it);
+        if (rest > 0)
+            free_.emplace(first + count, rest);
+        return first;
+    }
+    std::size_t first = end_;
+    end_ += count;
+    return first;
+}
+
+void GeometryArena::Ranges::release(std::size_t first, std::size_t count) {
+    if (count == 0)
+        return;
+
+    // Merge with the free neighbours.
+    auto next = free_.lower_bound(first);
+    if (next != free_.end() && first + count == next->first) {
+        count += next->second;
+        next = free_.erase(next);
+    }
+    if (next != free_.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == first) {
+            first = prev->first;
+            count += prev->second;
+            free_.erase(prev);
+        }
+    }
+
+    if (first + count == end_)
+        end_ = first;
+    else
+        free_.emplace(first, count);
+}
+
+void GeometryArena::create(ShaderProgram const& shader, std::size_t vertex_capacity, std::size_t index_capacity) {
+    destroy();
+    program_ = shader.getID();
+
+    glCreateVertexArrays(1, &VAO_);
+    glObjectLabel(GL_VERTEX_ARRAY, VAO_, -1, "ArenaVAO");
+
+    // Same layout as MeshGeometry.
+    GLint position_attrib_location = glGetAttribLocation(program_, "aPos");
+    glVertexArrayAttribFormat(VAO_, position_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(vertex, position));
+    glVertexArrayAttribBinding(VAO_, position_attrib_location, 0);
+    glEnableVertexArrayAttrib(VAO_, position_attrib_location);
+
+    GLint normal_attrib_location = glGetAttribLocation(program_, "aNorm");
+    glVertexArrayAttribFormat(VAO_, normal_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(vertex, normal));
+    glVertexArrayAttribBinding(VAO_, normal_attrib_location, 0);
+    glEnableVertexArrayAttrib(VAO_, normal_attrib_location);
+
+    GLint texture_attrib_location = glGetAttribLocation(program_, "aTex");
+    glVertexArrayAttribFormat(VAO_, texture_attrib_location, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, texcoord));
+    glVertexArrayAttribBinding(VAO_, texture_attrib_location, 0);
+    glEnableVertexArrayAttrib(VAO_, texture_attrib_location);
+
+    reserve(vertex_capacity, 0, index_capacity, 0);
+}
+
+void GeometryArena::destroy() {
+    if (VAO_) {
+        RenderState::get().forgetVertexArray(VAO_);
+        glDeleteVertexArrays(1, &VAO_);
+    }
+    if (VBO_) glDeleteBuffers(1, &VBO_);
+    if (EBO_) glDeleteBuffers(1, &EBO_);
+    VAO_ = VBO_ = EBO_ = 0;
+    program_ = 0;
+    vertex_ranges_.reset();
+    index_ranges_.reset();
+    stats_ = {};
+}
+
+bool GeometryArena::reserve(GLuint& buffer, std::size_t& capacity, std::size_t needed, std::size_t used,
+    std::size_t element_size, const char* label) {
+    if (buffer && needed <= capacity)
+        return false;
+
+    // New buffer, copy what is in use, point the VAO at it.
+    std::size_t new_capacity = std::max(needed, capacity * 2);
+    GLuint grown = 0;
+    glCreateBuffers(1, &grown);
+    glObjectLabel(GL_BUFFER, grown, -1, label);
+    glNamedBufferStorage(grown, static_cast<GLsizeiptr>(new_capacity * element_size), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    if (buffer) {
+        if (used > 0)
+            glCopyNamedBufferSubData(buffer, grown, 0, 0, static_cast<GLsizeiptr>(used * element_size));
+        glDeleteBuffers(1, &buffer);
+        ++stats_.grows;
+    }
+    buffer = grown;
+    capacity = new_capacity;
+    return true;
+}
+
+void GeometryArena::reserve(std::size_t vertices, std::size_t used_vertices, std::size_t indices, std::size_t used_indices) {
+    if (reserve(VBO_, stats_.vertex_capacity, vertices, used_vertices, sizeof(vertex), "ArenaVBO"))
+        glVertexArrayVertexBuffer(VAO_, 0, VBO_, 0, sizeof(vertex));
+    if (reserve(EBO_, stats_.index_capacity, indices, used_indices, sizeof(GLuint), "ArenaEBO"))
+        glVertexArrayElementBuffer(VAO_, EBO_);
+}
+
+GeometryArena::Slot GeometryArena::allocate(vertex const* vertex_data, std::size_t vertex_count,
+    GLuint const* index_data, std::size_t index_count) {
+    Slot slot;
+    if (!VAO_ || vertex_count == 0 || index_count == 0)
+        return slot;
+
+    const std::size_t used_vertices = vertex_ranges_.end(), used_indices = index_ranges_.end();
+    slot.first_vertex = static_cast<GLuint>(vertex_ranges_.allocate(vertex_count));
+    slot.vertex_count = static_cast<GLuint>(vertex_count);
+    slot.first_index = static_cast<GLuint>(index_ranges_.allocate(index_count));
+    slot.index_count = static_cast<GLuint>(index_count);
+
+    reserve(vertex_ranges_.end(), used_vertices, index_ranges_.end(), used_indices);
+
+    glNamedBufferSubData(VBO_, static_cast<GLintptr>(slot.first_vertex * sizeof(vertex)),
+        static_cast<GLsizeiptr>(vertex_count * sizeof(vertex)), vertex_data);
+    glNamedBufferSubData(EBO_, static_cast<GLintptr>(slot.first_index * sizeof(GLuint)),
+        static_cast<GLsizeiptr>(index_count * sizeof(GLuint)), index_data);
+
+    ++stats_.meshes;
+    stats_.vertices += vertex_count;
+    stats_.indices += index_count;
+    return slot;
+}
+
+void GeometryArena::release(Slot const& slot) {
+    if (!slot.valid() || !VAO_)
+        return;
+    vertex_ranges_.release(slot.first_vertex, slot.vertex_count);
+    index_ranges_.release(slot.first_index, slot.index_count);
+    --stats_.meshes;
+    stats_.vertices -= slot.vertex_count;
+    stats_.indices -= slot.index_count;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <GL/glew.h>
+
+#include "assets.hpp"
+#include "ShaderProgram.hpp"
+
+// One vertex buffer and one index buffer, shared by one VAO, that the static triangle meshes of my_shader
+// (OBJ models) are sub-allocated from. Meshes in the arena draw with a first index and base vertex into the
+// shared buffers, so consecutive draws never change the VAO and opaque objects can go out together through
+// glMultiDrawElementsIndirect (IndirectDrawList). The buffers grow by copying on the GPU; the VAO name stays
+// the same. GL thread only.
+class GeometryArena {
+public:
+    // Place of one mesh in the arena, in vertices / indices.
+    struct Slot {
+        GLuint first_vertex = 0, vertex_count = 0;
+        GLuint first_index = 0, index_count = 0;
+        bool valid() const { return index_count > 0; }
+    };
+
+    struct Stats {
+        std::size_t meshes = 0;
+        std::size_t vertices = 0, vertex_capacity = 0;
+        std::size_t indices = 0, index_capacity = 0;
+        std::size_t grows = 0;
+    };
+
+    static GeometryArena& get() {
+        static GeometryArena arena;
+        return arena;
+    }
+
+    // Create the buffers and the VAO with the vertex layout of `shader` (aPos/aNorm/aTex, as MeshGeometry).
+    void create(ShaderProgram const& shader, std::size_t vertex_capacity = 1 << 18, std::size_t index_capacity = 1 << 20);
+    void destroy();
+
+    // Meshes drawn with `shader` can live here.
+    bool accepts(ShaderProgram const& shader) const { return VAO_ != 0 && shader.getID() == program_; }
+
+    // Copy one mesh in (indices stay relative to its own vertices; draws add first_vertex as base vertex).
+    Slot allocate(vertex const* vertex_data, std::size_t vertex_count, GLuint const* index_data, std::size_t index_count);
+    void release(Slot const& slot);
+
+    GLuint vao() const { return VAO_; }
+    Stats const& stats() const { return stats_; }
+
+private:
+    GeometryArena() = default;
+
+    // First-fit allocator over [0, end) with merged free ranges; what is freed at the end shrinks `end`.
+    class Ranges {
+    public:
+        std::size_t allocate(std::size_t count);
+        void release(std::size_t first, std::size_t count);
+        std::size_t end() const { return end_; }
+        void reset() { free_.clear(); end_ = 0; }
+    private:
+        std::map<std::size_t, std::size_t> free_;   // first -> count
+        std::size_t end_ = 0;
+    };
+
+    // Grow a buffer to hold `needed` elements (the first `used` are copied over); true if it was replaced.
+    bool reserve(GLuint& buffer, std::size_t& capacity, std::size_t needed, std::size_t used, std::size_t element_size, const char* label);
+    void reserve(std::size_t vertices, std::size_t used_vertices, std::size_t indices, std::size_t used_indices);
+
+    GLuint VAO_ = 0, VBO_ = 0, EBO_ = 0;
+    GLuint program_ = 0;
+    Ranges vertex_ranges_, index_ranges_;
+    Stats stats_;
+};
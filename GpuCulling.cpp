@@ -0,0 +1,113 @@
+#include "GpuCulling.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "RenderState.hpp"
+
+bool GpuCulling::create(std::filesystem::path const& file) {
+    destroy();
+    try {
+        program_ = ShaderProgram(file);
+    }
+    catch (std::exception const& e) {
+        std::cerr << "GPU culling disabled: " << e.what();
+        program_ = ShaderProgram();
+        return false;
+    }
+    u_planes_ = program_.uniform("planes");
+    u_source_count_ = program_.uniform("source_count");
+    u_command_count_ = program_.uniform("command_count");
+    u_occlusion_ = program_.uniform("occlusion");
+    u_view_projection_ = program_.uniform("view_projection");
+    u_hiz_ = program_.uniform("hiz");
+    u_hiz_size_ = program_.uniform("hiz_size");
+    u_hiz_levels_ = program_.uniform("hiz_levels");
+
+    const Occlusion zero;
+    glCreateBuffers(1, &occlusion_counters_);
+    glObjectLabel(GL_BUFFER, occlusion_counters_, -1, "OcclusionCounters");
+    glNamedBufferData(occlusion_counters_, sizeof(zero), &zero, GL_DYNAMIC_DRAW);
+    return true;
+}
+
+void GpuCulling::destroy() {
+    if (ready())
+        program_.clear();
+    if (occlusion_counters_)
+        glDeleteBuffers(1, &occlusion_counters_);
+    occlusion_counters_ = 0;
+    hiz_ = nullptr;
+    stats_ = {};
+}
+
+void GpuCulling::setOcclusion(HiZPyramid const* hiz, glm::mat4 const& view_projection) {
+    hiz_ = (hiz && hiz->texture() != 0) ? hiz : nullptr;
+    if (!ready())
+        return;
+    RenderState& state = RenderState::get();
+    state.useProgram(program_.getID());
+    program_.setUniform(u_occlusion_, hiz_ ? 1 : 0);
+    if (!hiz_)
+        return;
+    program_.setUniform(u_view_projection_, view_projection);
+    state.setInt(u_hiz_, static_cast<int>(HiZPyramid::kTextureUnit));
+    glProgramUniform2i(program_.getID(), u_hiz_size_.location, hiz_->size().x, hiz_->size().y);
+    program_.setUniform(u_hiz_levels_, hiz_->levels());
+}
+
+GpuCulling::Occlusion GpuCulling::occlusion() const {
+    Occlusion counts;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);     // atomics of the dispatches before the read
+    if (occlusion_counters_)
+        glGetNamedBufferSubData(occlusion_counters_, 0, sizeof(counts), &counts);
+    return counts;
+}
+
+void GpuCulling::resetStats() {
+    stats_ = {};
+    const Occlusion zero;
+    if (occlusion_counters_) {
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glNamedBufferSubData(occlusion_counters_, 0, sizeof(zero), &zero);
+    }
+}
+
+void GpuCulling::run(Frustum const& frustum, GLuint source, std::size_t count, GLuint visible,
+    GLuint commands, IndirectDrawList::Command const* templates, std::size_t command_count) {
+    if (!ready() || command_count == 0)
+        return;
+
+    // Counts start at 0; the compute pass adds one per visible instance.
+    static std::vector<IndirectDrawList::Command> reset;
+    reset.assign(templates, templates + command_count);
+    for (auto& command : reset)
+        command.instance_count = 0;
+    glNamedBufferSubData(commands, 0, static_cast<GLsizeiptr>(command_count * sizeof(IndirectDrawList::Command)), reset.data());
+    if (count == 0)
+        return;
+
+    glm::vec4 planes[Frustum::Count];
+    for (int p = 0; p < Frustum::Count; ++p)
+        planes[p] = frustum.plane(p);
+
+    const GLuint id = program_.getID();
+    RenderState::get().useProgram(id);
+    if (u_planes_.valid())
+        glProgramUniform4fv(id, u_planes_.location, Frustum::Count, &planes[0].x);
+    program_.setUniform(u_source_count_, static_cast<int>(count));
+    program_.setUniform(u_command_count_, static_cast<int>(command_count));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kSourceBinding, source);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibleBinding, visible);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, commands);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kOcclusionBinding, occlusion_counters_);
+    if (hiz_)
+        RenderState::get().bindTextureUnit(HiZPyramid::kTextureUnit, hiz_->texture());
+    glDispatchCompute(static_cast<GLuint>((count + kGroupSize - 1) / kGroupSize), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    ++stats_.dispatches;
+    stats_.instances += count;
+}
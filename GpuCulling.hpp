@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "HiZPyramid.hpp"
+#include "IndirectDrawList.hpp"
+#include "ShaderProgram.hpp"
+
+// Frustum culling of instance batches on the GPU (cull_instances.comp). run() resets the instance counts of a
+// batch's indirect commands, tests every instance's world box in a compute dispatch and appends the visible
+// ones to the batch's instance buffer; the draw then reads the counts with glDrawElementsIndirect. The CPU
+// cost is a few uniforms and one dispatch per batch, whatever the number of instances. With setOcclusion() the
+// instances inside the frustum are also tested against a Hi-Z pyramid of the depth drawn so far. GL thread only.
+class GpuCulling {
+public:
+    static constexpr GLuint kSourceBinding = 3;     // Source in cull_instances.comp
+    static constexpr GLuint kVisibleBinding = 4;    // Visible
+    static constexpr GLuint kCommandBinding = 5;    // Commands
+    static constexpr GLuint kOcclusionBinding = 6;  // Occlusion
+
+    // std430 entry of Source; the normal matrix columns are padded to vec4.
+    struct Instance {
+        glm::mat4 model;
+        glm::vec4 normal[3];
+        glm::vec4 box_min;
+        glm::vec4 box_max;
+    };
+    static_assert(sizeof(Instance) == 144, "Instance must match the std430 layout of Instance in cull_instances.comp");
+
+    // Dispatches and instances tested since the last resetStats() (printed with the U report).
+    struct Stats {
+        std::size_t dispatches = 0;
+        std::size_t instances = 0;
+    };
+
+    // Instances inside the frustum and those of them hidden by the Hi-Z test since the last resetStats().
+    struct Occlusion {
+        GLuint tested = 0;
+        GLuint occluded = 0;
+    };
+
+    // Compile the compute program; false (and culling stays on the CPU) if that fails.
+    bool create(std::filesystem::path const& file = "cull_instances.comp");
+    void destroy();
+    bool ready() const { return program_.getID() != 0; }
+
+    // Cull `count` instances of `source` (Instance entries) into `visible` (Mesh::InstanceData entries, room for
+    // `count`). `commands` holds `command_count` commands; they are overwritten with `templates`, instance
+    // counts set to 0, before the dispatch. Ends with the barrier for the indirect draw and the attribute fetch.
+    void run(Frustum const& frustum, GLuint source, std::size_t count, GLuint visible,
+        GLuint commands, IndirectDrawList::Command const* templates, std::size_t command_count);
+
+    // Test the following run()s against `hiz` (built from the depth under `view_projection`); null switches it off.
+    void setOcclusion(HiZPyramid const* hiz, glm::mat4 const& view_projection = glm::mat4(1.0f));
+
+    Stats const& stats() const { return stats_; }
+    // Reads the counters back and so waits for the GPU: for reports only.
+    Occlusion occlusion() const;
+    void resetStats();
+
+private:
+    static constexpr GLuint kGroupSize = 64;    // local_size_x
+
+    ShaderProgram program_;
+    UniformHandle u_planes_, u_source_count_, u_command_count_;
+    UniformHandle u_occlusion_, u_view_projection_, u_hiz_, u_hiz_size_, u_hiz_levels_;
+    HiZPyramid const* hiz_ = nullptr;
+    GLuint occlusion_counters_ = 0;     // Occlusion
+    Stats stats_;
+};
@@ -0,0 +1,162 @@
+#include "HeightField.hpp"
+
+// The AVX2 path is built for x86 whatever the project's /arch is (MSVC takes the intrinsics anyway, GCC/Clang
+// compile that one function for AVX2) and chosen at run time, so the shipped build uses it on CPUs that have it.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEIGHTFIELD_AVX2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HEIGHTFIELD_TARGET_AVX2
+#else
+#define HEIGHTFIELD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HEIGHTFIELD_SSE2 1
+#endif
+
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "batched sample() loads (x, z) pairs as packed floats");
+
+namespace {
+
+// CPU has AVX2 and the OS saves the YMM registers. Checked once.
+bool hasAVX2() {
+#if !defined(HEIGHTFIELD_AVX2)
+    return false;
+#elif defined(_MSC_VER)
+    static const bool avx2 = [] {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const int osxsave_avx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return avx2;
+#else
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#endif
+}
+
+} // namespace
+
+const char* HeightField::simdPath() {
+    if (hasAVX2())
+        return "AVX2";
+#if defined(HEIGHTFIELD_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void HeightField::sample(glm::vec2 const* xz, float* out, std::size_t count) const {
+    std::size_t i = hasAVX2() ? sampleAVX2(xz, out, count) : sampleSSE2(xz, out, count);
+    for (; i < count; ++i)
+        out[i] = sample(xz[i].x, xz[i].y);
+}
+
+#if defined(HEIGHTFIELD_AVX2)
+HEIGHTFIELD_TARGET_AVX2
+#endif
+std::size_t HeightField::sampleAVX2(glm::vec2 const* xz, float* out, std::size_t count) const {
+    std::size_t i = 0;
+#if defined(HEIGHTFIELD_AVX2)
+    float const* base = heights_.data();
+
+    // 8 positions per step: (x, z) pairs are split into lanes, the four corners come from gathers.
+    const __m256 offset_r = _mm256_set1_ps(offset_r_), offset_c = _mm256_set1_ps(offset_c_);
+    const __m256 inv_scale = _mm256_set1_ps(inv_scale_);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max_r = _mm256_set1_ps(static_cast<float>(rows_ - 1)), max_c = _mm256_set1_ps(static_cast<float>(cols_ - 1));
+    const __m256 last_r = _mm256_set1_ps(static_cast<float>(rows_ - 2)), last_c = _mm256_set1_ps(static_cast<float>(cols_ - 2));
+    const __m256i cols = _mm256_set1_epi32(cols_);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i lanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    for (; i + 8 <= count; i += 8) {
+        // Deinterleave x0 z0 x1 z1 ... into x0..x7 / z0..z7.
+        __m256 a = _mm256_loadu_ps(&xz[i].x);         // x0 z0 x1 z1 x2 z2 x3 z3
+        __m256 b = _mm256_loadu_ps(&xz[i + 4].x);     // x4 z4 ... x7 z7
+        a = _mm256_permutevar8x32_ps(a, lanes);       // x0 x1 x2 x3 z0 z1 z2 z3
+        b = _mm256_permutevar8x32_ps(b, lanes);
+        __m256 x = _mm256_permute2f128_ps(a, b, 0x20);
+        __m256 z = _mm256_permute2f128_ps(a, b, 0x31);
+
+        __m256 fr = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_add_ps(x, offset_r), inv_scale), zero), max_r);
+        __m256 fc = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_add_ps(z, offset_c), inv_scale), zero), max_c);
+        __m256 rf = _mm256_min_ps(_mm256_floor_ps(fr), last_r);
+        __m256 cf = _mm256_min_ps(_mm256_floor_ps(fc), last_c);
+        __m256 tr = _mm256_sub_ps(fr, rf);
+        __m256 tc = _mm256_sub_ps(fc, cf);
+
+        __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(rf), cols), _mm256_cvttps_epi32(cf));
+        __m256i idx_down = _mm256_add_epi32(idx, cols);
+        __m256 h00 = _mm256_i32gather_ps(base, idx, 4);
+        __m256 h01 = _mm256_i32gather_ps(base, _mm256_add_epi32(idx, one), 4);
+        __m256 h10 = _mm256_i32gather_ps(base, idx_down, 4);
+        __m256 h11 = _mm256_i32gather_ps(base, _mm256_add_epi32(idx_down, one), 4);
+
+        __m256 h0 = _mm256_add_ps(h00, _mm256_mul_ps(_mm256_sub_ps(h10, h00), tr));
+        __m256 h1 = _mm256_add_ps(h01, _mm256_mul_ps(_mm256_sub_ps(h11, h01), tr));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(h0, _mm256_mul_ps(_mm256_sub_ps(h1, h0), tc)));
+    }
+    _mm256_zeroupper();     // no AVX-SSE transition penalty in the code compiled without /arch:AVX
+#endif
+    return i;
+}
+
+std::size_t HeightField::sampleSSE2(glm::vec2 const* xz, float* out, std::size_t count) const {
+    std::size_t i = 0;
+#if defined(HEIGHTFIELD_SSE2)
+    float const* base = heights_.data();
+
+    // 4 positions per step. SSE2 has no gather (and no 32-bit multiply), so the corner loads are
+    // scalar; the coordinate math and the interpolation stay in vectors.
+    const __m128 offset_r = _mm_set1_ps(offset_r_), offset_c = _mm_set1_ps(offset_c_);
+    const __m128 inv_scale = _mm_set1_ps(inv_scale_);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max_r = _mm_set1_ps(static_cast<float>(rows_ - 1)), max_c = _mm_set1_ps(static_cast<float>(cols_ - 1));
+    const __m128 last_r = _mm_set1_ps(static_cast<float>(rows_ - 2)), last_c = _mm_set1_ps(static_cast<float>(cols_ - 2));
+    alignas(16) int r[4], c[4];
+    alignas(16) float h00[4], h01[4], h10[4], h11[4];
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(&xz[i].x);            // x0 z0 x1 z1
+        __m128 b = _mm_loadu_ps(&xz[i + 2].x);        // x2 z2 x3 z3
+        __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+        // Clamped to >= 0, so truncation is floor.
+        __m128 fr = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(x, offset_r), inv_scale), zero), max_r);
+        __m128 fc = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(z, offset_c), inv_scale), zero), max_c);
+        __m128 rf = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fr)), last_r);
+        __m128 cf = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fc)), last_c);
+        __m128 tr = _mm_sub_ps(fr, rf);
+        __m128 tc = _mm_sub_ps(fc, cf);
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(r), _mm_cvttps_epi32(rf));
+        _mm_store_si128(reinterpret_cast<__m128i*>(c), _mm_cvttps_epi32(cf));
+        for (int k = 0; k < 4; ++k) {
+            float const* p = base + static_cast<std::size_t>(r[k]) * cols_ + c[k];
+            h00[k] = p[0];
+            h01[k] = p[1];
+            h10[k] = p[cols_];
+            h11[k] = p[cols_ + 1];
+        }
+
+        __m128 v00 = _mm_load_ps(h00), v01 = _mm_load_ps(h01), v10 = _mm_load_ps(h10), v11 = _mm_load_ps(h11);
+        __m128 h0 = _mm_add_ps(v00, _mm_mul_ps(_mm_sub_ps(v10, v00), tr));
+        __m128 h1 = _mm_add_ps(v01, _mm_mul_ps(_mm_sub_ps(v11, v01), tr));
+        _mm_storeu_ps(out + i, _mm_add_ps(h0, _mm_mul_ps(_mm_sub_ps(h1, h0), tc)));
+    }
+#endif
+    return i;
+}
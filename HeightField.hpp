@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Terrain heights in one row-major array, sampled bilinearly in world space.
+// Row r runs along world x, column c along world z (the layout Heightmap builds its mesh with):
+//   r = (x + rows / 2) / scale,  c = (z + cols / 2) / scale
+// Positions outside the grid are clamped to the border. An empty field is a flat 2 x 2 grid at height 0,
+// so sample() needs no emptiness check.
+class HeightField {
+public:
+    HeightField() {
+        setScale(1.0f);
+    }
+
+    HeightField(int rows, int cols, std::vector<float> heights, float scale = 1.0f)
+        : rows_(rows), cols_(cols), heights_(std::move(heights))
+    {
+        if (rows_ < 2 || cols_ < 2 || heights_.size() < static_cast<std::size_t>(rows_) * cols_) {
+            rows_ = cols_ = 2;
+            heights_.assign(4, 0.0f);
+        }
+        setScale(scale);
+    }
+
+    // World units per grid cell (Heightmap::scale.x).
+    void setScale(float scale) {
+        inv_scale_ = 1.0f / scale;
+        offset_r_ = rows_ / 2.0f;
+        offset_c_ = cols_ / 2.0f;
+        max_r_ = static_cast<float>(rows_ - 1);
+        max_c_ = static_cast<float>(cols_ - 1);
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    float at(int r, int c) const { return heights_[static_cast<std::size_t>(r) * cols_ + c]; }
+    float const* data() const { return heights_.data(); }
+
+    // Height at world (x, z).
+    float sample(float x, float z) const {
+        // Clamp the grid position first (ternaries compile to maxss/minss), then the cell index is a plain
+        // truncation and the fraction needs no clamping.
+        float fr = (x + offset_r_) * inv_scale_;
+        float fc = (z + offset_c_) * inv_scale_;
+        fr = fr > 0.0f ? fr : 0.0f;
+        fc = fc > 0.0f ? fc : 0.0f;
+        fr = fr < max_r_ ? fr : max_r_;
+        fc = fc < max_c_ ? fc : max_c_;
+        int r = static_cast<int>(fr);
+        int c = static_cast<int>(fc);
+        r = r < rows_ - 2 ? r : rows_ - 2;
+        c = c < cols_ - 2 ? c : cols_ - 2;
+        float tr = fr - r;
+        float tc = fc - c;
+
+        float const* p = heights_.data() + static_cast<std::size_t>(r) * cols_ + c;
+        float h0 = p[0] * (1.0f - tr) + p[cols_] * tr;             // (r, c) -> (r + 1, c)
+        float h1 = p[1] * (1.0f - tr) + p[cols_ + 1] * tr;         // (r, c + 1) -> (r + 1, c + 1)
+        return h0 * (1.0f - tc) + h1 * tc;
+    }
+
+    // Heights at `count` world (x, z) positions, 8 (AVX2, if the CPU has it) or 4 (SSE2) at a time.
+    void sample(glm::vec2 const* xz, float* out, std::size_t count) const;
+
+    // Instruction set the batched sample() uses on this CPU ("AVX2", "SSE2" or "scalar").
+    static const char* simdPath();
+
+private:
+    // Batched paths; each returns how many positions it did (a multiple of its width, 0 if not built).
+    std::size_t sampleAVX2(glm::vec2 const* xz, float* out, std::size_t count) const;
+    std::size_t sampleSSE2(glm::vec2 const* xz, float* out, std::size_t count) const;
+
+    int rows_ = 2;
+    int cols_ = 2;
+    std::vector<float> heights_ = std::vector<float>(4, 0.0f);
+    float inv_scale_ = 1.0f;
+    float offset_r_ = 0.0f;
+    float offset_c_ = 0.0f;
+    float max_r_ = 0.0f;
+    float max_c_ = 0.0f;
+};
@@ -0,0 +1,385 @@
+#include "HeightTiles.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+static_assert(sizeof(HeightTilesHeader) == 56, "HeightTilesHeader layout changed, bump HeightTiles::kVersion");
+
+namespace {
+
+const char kMagic[4] = { 'I', 'H', 'T', 'L' };
+
+bool sourceStamp(const std::filesystem::path& source, std::uint64_t& size, std::int64_t& mtime) {
+    std::error_code ec;
+    size = static_cast<std::uint64_t>(std::filesystem::file_size(source, ec));
+    if (ec) return false;
+    auto time = std::filesystem::last_write_time(source, ec);
+    if (ec) return false;
+    mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+bool readHeader(const std::filesystem::path& file, HeightTilesHeader& header) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == HeightTiles::kVersion
+        && header.rows >= 2 && header.cols >= 2 && header.tile_size > 0
+        && header.tile_rows == (header.rows - 2) / header.tile_size + 1
+        && header.tile_cols == (header.cols - 2) / header.tile_size + 1
+        && header.tile_rows < 0x10000 && header.tile_cols < 0x10000;
+}
+
+std::uint64_t expectedSize(HeightTilesHeader const& h) {
+    const std::uint64_t overview = static_cast<std::uint64_t>(h.tile_rows + 1) * (h.tile_cols + 1);
+    const std::uint64_t tile = static_cast<std::uint64_t>(h.tile_size + 1) * (h.tile_size + 1);
+    return sizeof(HeightTilesHeader) + (overview + tile * h.tile_rows * h.tile_cols) * sizeof(float);
+}
+
+} // namespace
+
+std::filesystem::path HeightTiles::tilesPathFor(const std::filesystem::path& source) {
+    std::filesystem::path tiles = source;
+    tiles += ".tiles";
+    return tiles;
+}
+
+bool HeightTiles::upToDate(const std::filesystem::path& source) {
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    HeightTilesHeader header;
+    const std::filesystem::path tiles = tilesPathFor(source);
+    std::error_code ec;
+    return sourceStamp(source, size, mtime) && readHeader(tiles, header)
+        && header.source_size == size && header.source_mtime == mtime
+        && std::filesystem::file_size(tiles, ec) == expectedSize(header) && !ec;
+}
+
+bool HeightTiles::write(const std::filesystem::path& source, HeightField const& heights, int tile_size) {
+    HeightTilesHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    if (!sourceStamp(source, header.source_size, header.source_mtime)) {
+        std::cerr << "Height tiles: can not stat source " << source << std::endl;
+        return false;
+    }
+
+    const int rows = heights.rows(), cols = heights.cols();
+    const int T = std::max(tile_size, 1);
+    header.rows = static_cast<std::uint32_t>(rows);
+    header.cols = static_cast<std::uint32_t>(cols);
+    header.tile_size = static_cast<std::uint32_t>(T);
+    header.tile_rows = static_cast<std::uint32_t>((rows - 2) / T + 1);
+    header.tile_cols = static_cast<std::uint32_t>((cols - 2) / T + 1);
+    const float* first = heights.data();
+    auto range = std::minmax_element(first, first + static_cast<std::size_t>(rows) * cols);
+    header.min_height = *range.first;
+    header.max_height = *range.second;
+
+    auto at = [&](int r, int c) { return heights.at(std::min(r, rows - 1), std::min(c, cols - 1)); };
+
+    // Write to a temporary file and rename it, so an interrupted write never leaves a valid-looking file.
+    const std::filesystem::path tiles = tilesPathFor(source);
+    std::filesystem::path tmp = tiles;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Height tiles: can not write " << tmp << std::endl;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<float> buffer;
+        buffer.reserve(static_cast<std::size_t>(header.tile_cols + 1) * (header.tile_rows + 1));
+        for (std::uint32_t tr = 0; tr <= header.tile_rows; ++tr)
+            for (std::uint32_t tc = 0; tc <= header.tile_cols; ++tc)
+                buffer.push_back(at(static_cast<int>(tr) * T, static_cast<int>(tc) * T));
+        out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(float)));
+
+        // Cells past the map edge repeat the border, so every tile has the same size.
+        buffer.resize(static_cast<std::size_t>(T + 1) * (T + 1));
+        for (std::uint32_t tr = 0; tr < header.tile_rows && out; ++tr)
+            for (std::uint32_t tc = 0; tc < header.tile_cols; ++tc) {
+                float* dst = buffer.data();
+                for (int r = 0; r <= T; ++r)
+                    for (int c = 0; c <= T; ++c)
+                        *dst++ = at(static_cast<int>(tr) * T + r, static_cast<int>(tc) * T + c);
+                out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(float)));
+            }
+        if (!out) {
+            std::cerr << "Height tiles: write failed for " << tmp << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, tiles, ec);
+    if (ec) {
+        std::cerr << "Height tiles: can not replace " << tiles << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool HeightTiles::open(const std::filesystem::path& tiles_file, std::size_t budget, float scale) {
+    close();
+
+    HeightTilesHeader header;
+    std::error_code ec;
+    if (!readHeader(tiles_file, header) || std::filesystem::file_size(tiles_file, ec) != expectedSize(header) || ec) {
+        std::cerr << "Height tiles: invalid or missing " << tiles_file << std::endl;
+        return false;
+    }
+
+    overview_.resize(static_cast<std::size_t>(header.tile_rows + 1) * (header.tile_cols + 1));
+    std::ifstream in(tiles_file, std::ios::binary);
+    in.seekg(sizeof(HeightTilesHeader));
+    if (!in.read(reinterpret_cast<char*>(overview_.data()), static_cast<std::streamsize>(overview_.size() * sizeof(float)))) {
+        std::cerr << "Height tiles: can not read the overview of " << tiles_file << std::endl;
+        overview_.clear();
+        return false;
+    }
+
+    header_ = header;
+    path_ = tiles_file;
+    budget_ = std::max<std::size_t>(budget, 1);
+    scale_ = scale;
+    stop_ = false;
+    loader_ = std::thread(&HeightTiles::loaderLoop, this);
+
+    std::cout << "Height tiles: " << path_ << ", " << header_.rows << "x" << header_.cols << " heights in "
+        << header_.tile_rows << "x" << header_.tile_cols << " tiles of " << header_.tile_size << " cells" << std::endl;
+    return true;
+}
+
+void HeightTiles::close() {
+    if (loader_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        loader_.join();
+    }
+
+    header_ = {};
+    overview_.clear();
+    resident_.clear();
+    requested_.clear();
+    failed_.clear();
+    queue_.clear();
+    loaded_.clear();
+    frame_ = loads_ = evictions_ = 0;
+}
+
+std::uint64_t HeightTiles::tileOffset(std::uint32_t k) const {
+    const std::uint64_t tr = k >> 16, tc = k & 0xFFFF;
+    return sizeof(HeightTilesHeader)
+        + static_cast<std::uint64_t>(header_.tile_rows + 1) * (header_.tile_cols + 1) * sizeof(float)
+        + (tr * header_.tile_cols + tc) * tileFloats() * sizeof(float);
+}
+
+void HeightTiles::loaderLoop() {
+    std::ifstream in(path_, std::ios::binary);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (stop_)
+            return;
+        const std::uint32_t k = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+
+        // An empty result marks a failed read.
+        std::vector<float> heights(tileFloats());
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(tileOffset(k)));
+        if (!in.read(reinterpret_cast<char*>(heights.data()), static_cast<std::streamsize>(heights.size() * sizeof(float))))
+            heights.clear();
+
+        lock.lock();
+        loaded_.emplace_back(k, std::move(heights));
+    }
+}
+
+void HeightTiles::collect(std::uint64_t last_used) {
+    std::vector<std::pair<std::uint32_t, std::vector<float>>> loaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loaded.swap(loaded_);
+    }
+    for (auto& [k, heights] : loaded) {
+        requested_.erase(k);
+        if (heights.empty()) {
+            std::cerr << "Height tiles: can not read tile " << (k >> 16) << "," << (k & 0xFFFF) << " of " << path_ << std::endl;
+            failed_.insert(k);
+            continue;
+        }
+        resident_[k] = Tile{ std::move(heights), last_used };
+        ++loads_;
+    }
+}
+
+void HeightTiles::request(float x, float z, float radius) {
+    // Camera in grid units (clamped like sample()); tiles whose rectangle comes within the radius, nearest
+    // first, at most the budget.
+    const float T = static_cast<float>(header_.tile_size);
+    const float fr = std::clamp(x / scale_ + header_.rows / 2.0f, 0.0f, static_cast<float>(header_.rows - 1));
+    const float fc = std::clamp(z / scale_ + header_.cols / 2.0f, 0.0f, static_cast<float>(header_.cols - 1));
+    const float reach = std::max(radius, 0.0f) / scale_;
+
+    auto tileRange = [&](float lo, float hi, std::uint32_t count, int& first, int& last) {
+        first = std::clamp(static_cast<int>(std::floor(lo / T)), 0, static_cast<int>(count) - 1);
+        last = std::clamp(static_cast<int>(std::floor(hi / T)), 0, static_cast<int>(count) - 1);
+    };
+    int tr0, tr1, tc0, tc1;
+    tileRange(fr - reach, fr + reach, header_.tile_rows, tr0, tr1);
+    tileRange(fc - reach, fc + reach, header_.tile_cols, tc0, tc1);
+
+    std::vector<std::pair<float, std::uint32_t>> wanted;
+    for (int tr = tr0; tr <= tr1; ++tr)
+        for (int tc = tc0; tc <= tc1; ++tc) {
+            float dr = std::max({ tr * T - fr, fr - (tr + 1) * T, 0.0f });
+            float dc = std::max({ tc * T - fc, fc - (tc + 1) * T, 0.0f });
+            float d2 = dr * dr + dc * dc;
+            if (d2 <= reach * reach)
+                wanted.emplace_back(d2, key(tr, tc));
+        }
+    std::sort(wanted.begin(), wanted.end());
+    if (wanted.size() > budget_)
+        wanted.resize(budget_);
+
+    // Replace the queue: tiles the camera has moved away from before they were read are dropped.
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::uint32_t k : queue_)
+        requested_.erase(k);
+    queue_.clear();
+    for (auto const& w : wanted) {
+        auto it = resident_.find(w.second);
+        if (it != resident_.end())
+            it->second.last_used = frame_;
+        else if (!requested_.count(w.second) && !failed_.count(w.second)) {
+            queue_.push_back(w.second);
+            requested_.insert(w.second);
+        }
+    }
+    if (!queue_.empty())
+        wake_.notify_one();
+}
+
+void HeightTiles::evict() {
+    // Least recently used first; tiles wanted this frame carry the newest stamp.
+    while (resident_.size() > budget_) {
+        auto oldest = std::min_element(resident_.begin(), resident_.end(),
+            [](auto const& a, auto const& b) { return a.second.last_used < b.second.last_used; });
+        resident_.erase(oldest);
+        ++evictions_;
+    }
+}
+
+void HeightTiles::update(float x, float z, float radius) {
+    if (!isOpen())
+        return;
+    ++frame_;
+    collect(frame_ - 1);
+    request(x, z, radius);
+    evict();
+}
+
+void HeightTiles::prefetch(float x, float z, float radius) {
+    if (!isOpen())
+        return;
+    ++frame_;
+    collect(frame_ - 1);
+    request(x, z, radius);
+    while (!requested_.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        collect(frame_);
+    }
+    evict();
+}
+
+float HeightTiles::heightAt(float r, float c, bool* from_overview) const {
+    const int T = static_cast<int>(header_.tile_size);
+    r = std::clamp(r, 0.0f, static_cast<float>(header_.rows - 1));
+    c = std::clamp(c, 0.0f, static_cast<float>(header_.cols - 1));
+    const int tr = std::min(static_cast<int>(r) / T, static_cast<int>(header_.tile_rows) - 1);
+    const int tc = std::min(static_cast<int>(c) / T, static_cast<int>(header_.tile_cols) - 1);
+
+    auto bilinear = [](float const* p, int stride, float fr, float fc, int max_r, int max_c) {
+        int r0 = std::min(static_cast<int>(fr), max_r), c0 = std::min(static_cast<int>(fc), max_c);
+        float tr = fr - r0, tc = fc - c0;
+        p += static_cast<std::size_t>(r0) * stride + c0;
+        float h0 = p[0] * (1.0f - tr) + p[stride] * tr;
+        float h1 = p[1] * (1.0f - tr) + p[stride + 1] * tr;
+        return h0 * (1.0f - tc) + h1 * tc;
+    };
+
+    auto it = resident_.find(key(tr, tc));
+    if (from_overview)
+        *from_overview = it == resident_.end();
+    if (it != resident_.end())
+        return bilinear(it->second.heights.data(), T + 1, r - tr * T, c - tc * T, T - 1, T - 1);
+
+    // Overview: one height per tile corner, so a missing tile is a single bilinear patch.
+    return bilinear(overview_.data(), static_cast<int>(header_.tile_cols) + 1, r / T, c / T,
+        static_cast<int>(header_.tile_rows) - 1, static_cast<int>(header_.tile_cols) - 1);
+}
+
+float HeightTiles::sample(float x, float z) const {
+    if (!isOpen())
+        return 0.0f;
+    return heightAt(x / scale_ + header_.rows / 2.0f, z / scale_ + header_.cols / 2.0f);
+}
+
+std::size_t HeightTiles::window(int r0, int c0, int rows, int cols, std::vector<float>& out) const {
+    out.resize(static_cast<std::size_t>(std::max(rows, 0)) * std::max(cols, 0));
+    if (!isOpen())
+        return out.size();
+
+    const int T = static_cast<int>(header_.tile_size);
+    std::size_t from_overview = 0;
+    float* dst = out.data();
+    for (int i = 0; i < rows; ++i) {
+        const int r = std::clamp(r0 + i, 0, static_cast<int>(header_.rows) - 1);
+        const int tr = std::min(r / T, static_cast<int>(header_.tile_rows) - 1);
+        for (int j = 0; j < cols;) {
+            // One lookup per run of columns inside the same tile.
+            const int c = std::clamp(c0 + j, 0, static_cast<int>(header_.cols) - 1);
+            const int tc = std::min(c / T, static_cast<int>(header_.tile_cols) - 1);
+            const int run_end = (c0 + j < 0 || c0 + j >= static_cast<int>(header_.cols)) ? j + 1
+                : std::min(cols, j + (tc + 1) * T + 1 - c);
+            auto it = resident_.find(key(tr, tc));
+            for (; j < run_end; ++j, ++dst) {
+                const int cc = std::clamp(c0 + j, 0, static_cast<int>(header_.cols) - 1);
+                if (it != resident_.end())
+                    *dst = it->second.heights[static_cast<std::size_t>(r - tr * T) * (T + 1) + (cc - tc * T)];
+                else {
+                    *dst = heightAt(static_cast<float>(r), static_cast<float>(cc));
+                    ++from_overview;
+                }
+            }
+        }
+    }
+    return from_overview;
+}
+
+HeightTiles::Stats HeightTiles::stats() const {
+    Stats s;
+    s.resident = resident_.size();
+    s.resident_bytes = resident_.size() * tileFloats() * sizeof(float);
+    s.budget = budget_;
+    s.pending = requested_.size();
+    s.loads = loads_;
+    s.evictions = evictions_;
+    s.failed = failed_.size();
+    return s;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "HeightField.hpp"
+
+// Pre-tiled height file written next to a source heightmap ("<file>.tiles"), raw floats, native endianness.
+// Layout: HeightTilesHeader, float overview[(tile_rows + 1) * (tile_cols + 1)] (height at every tile corner),
+// then tile_rows * tile_cols tiles in row-major order, each (tile_size + 1)^2 floats: a tile repeats the first
+// row/column of its neighbours, so bilinear sampling never needs a second tile.
+struct HeightTilesHeader {
+    char magic[4];                  // "IHTL"
+    std::uint32_t version;
+    std::uint64_t source_size;      // source file size in bytes (0 = no source, e.g. written by another tool)
+    std::int64_t source_mtime;      // source last_write_time ticks
+    std::uint32_t rows, cols;       // heights of the whole map (row = world x, column = world z, as HeightField)
+    std::uint32_t tile_size;        // cells along a tile side
+    std::uint32_t tile_rows, tile_cols;
+    float min_height, max_height;
+    std::uint32_t reserved;
+};
+
+// Heights streamed tile by tile around the camera, for maps that do not fit in memory (or should not).
+// A loader thread reads the tiles update() asks for; update() also takes them over on the calling thread and
+// drops the least recently used ones beyond the budget, so sample() and window() need no locking.
+// Where no tile is resident, the overview (tile corners) stands in.
+class HeightTiles {
+public:
+    // Bump when the file layout changes.
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr int kDefaultTileSize = 256;
+
+    struct Stats {
+        std::size_t resident = 0;       // tiles in memory
+        std::size_t resident_bytes = 0;
+        std::size_t budget = 0;         // most tiles kept in memory
+        std::size_t pending = 0;        // requested, not loaded yet
+        std::uint64_t loads = 0;        // tiles read since open()
+        std::uint64_t evictions = 0;
+        std::size_t failed = 0;         // tiles that could not be read (the overview stays in their place)
+    };
+
+    HeightTiles() = default;
+    ~HeightTiles() { close(); }
+
+    HeightTiles(const HeightTiles&) = delete;
+    HeightTiles& operator=(const HeightTiles&) = delete;
+
+    static std::filesystem::path tilesPathFor(const std::filesystem::path& source);
+
+    // True if the tiles of `source` exist and were written from its current version (size + mtime).
+    static bool upToDate(const std::filesystem::path& source);
+
+    // Tile `heights` (loaded from `source`) into tilesPathFor(source). Failures are reported but not fatal.
+    static bool write(const std::filesystem::path& source, HeightField const& heights, int tile_size = kDefaultTileSize);
+
+    // Open a tiles file and start the loader thread. At most `budget` tiles stay in memory.
+    bool open(const std::filesystem::path& tiles_file, std::size_t budget = 64, float scale = 1.0f);
+    void close();
+    bool isOpen() const { return header_.rows != 0; }
+
+    int rows() const { return static_cast<int>(header_.rows); }
+    int cols() const { return static_cast<int>(header_.cols); }
+    int tileSize() const { return static_cast<int>(header_.tile_size); }
+    int tileRows() const { return static_cast<int>(header_.tile_rows); }
+    int tileCols() const { return static_cast<int>(header_.tile_cols); }
+    float scale() const { return scale_; }
+
+    // Once per frame: request the tiles within `radius` world units of (x, z), nearest first, take over
+    // what the loader finished and evict beyond the budget.
+    void update(float x, float z, float radius);
+
+    // Same, but wait until those tiles are loaded (startup: object placement needs real heights).
+    void prefetch(float x, float z, float radius);
+
+    // Height at world (x, z), clamped at the border; same placement as HeightField.
+    float sample(float x, float z) const;
+
+    // Heights of rows [r0, r0 + rows) x columns [c0, c0 + cols) (clamped to the map). Returns the number of
+    // cells that came from the overview because their tile is not resident.
+    std::size_t window(int r0, int c0, int rows, int cols, std::vector<float>& out) const;
+
+    // Heights of resident tile (tr, tc) with its shared border row/column, (tileSize() + 1)^2 floats row-major;
+    // null if the tile is not resident. Valid until the next update().
+    float const* tile(int tr, int tc) const {
+        auto it = resident_.find(key(tr, tc));
+        return it != resident_.end() ? it->second.heights.data() : nullptr;
+    }
+
+    Stats stats() const;
+
+private:
+    struct Tile {
+        std::vector<float> heights;     // (tile_size + 1)^2
+        std::uint64_t last_used = 0;    // update() counter
+    };
+
+    HeightTilesHeader header_{};
+    std::filesystem::path path_;
+    std::vector<float> overview_;
+    float scale_ = 1.0f;
+    std::size_t budget_ = 64;
+
+    // Owned by the calling (main) thread.
+    std::unordered_map<std::uint32_t, Tile> resident_;
+    std::unordered_set<std::uint32_t> requested_;    // queued or being read
+    std::unordered_set<std::uint32_t> failed_;
+    std::uint64_t frame_ = 0;
+    std::uint64_t loads_ = 0, evictions_ = 0;
+
+    // Shared with the loader thread.
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::uint32_t> queue_;
+    std::vector<std::pair<std::uint32_t, std::vector<float>>> loaded_;
+    bool stop_ = false;
+    std::thread loader_;
+
+    static std::uint32_t key(int tr, int tc) { return (static_cast<std::uint32_t>(tr) << 16) | static_cast<std::uint32_t>(tc); }
+    std::size_t tileFloats() const { return static_cast<std::size_t>(header_.tile_size + 1) * (header_.tile_size + 1); }
+    std::uint64_t tileOffset(std::uint32_t k) const;
+
+    void request(float x, float z, float radius);
+    void collect(std::uint64_t last_used);
+    void evict();
+    void loaderLoop();
+
+    // Height at grid position (r, c): resident tile if there is one, else the overview.
+    float heightAt(float r, float c, bool* from_overview = nullptr) const;
+};
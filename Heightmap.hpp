@@ -6,10 +6,17 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
 
 #include "assets.hpp"
 #include "Mesh.hpp"
 #include "ShaderProgram.hpp"
+#include "HeightField.hpp"
+#include "Frustum.hpp"
+#include "StartupProfile.hpp"
 #include "stb_image.h"
 
 class Heightmap {
@@ -26,15 +33,35 @@ public:
     glm::mat3 normal_matrix = glm::identity<glm::mat3>();
 
     GLuint texture_id{ 0 };
+    int atlas_layer{ -1 };      // layer of the atlas texture array, -1 = own texture
     ShaderProgram shader;
 
     std::vector<vertex> vertices{};
-    GLuint NUM_STRIPS = 0;
-    GLuint NUM_VERTS_PER_STRIP = 0;
+
+    // The terrain is split into square chunks of kChunkQuads x kChunkQuads quads (fewer at the far edges).
+    // All chunks share one vertex/index buffer; each owns a run of strips in it and a local-space AABB.
+    static constexpr int kChunkQuads = 64;
+    struct Chunk {
+        glm::vec3 aabb_min{ 0.0f };
+        glm::vec3 aabb_max{ 0.0f };
+        Mesh::StripRange strips;
+    };
+    std::vector<Chunk> chunks;
+
+    // Result of the last culled draw (profiling, printed with the U report).
+    struct CullStats {
+        std::size_t chunks_total = 0;
+        std::size_t chunks_visible = 0;
+        std::size_t triangles_total = 0;
+        std::size_t triangles_visible = 0;
+        std::size_t draw_calls = 0;
+        double submit_ms = 0.0;     // CPU time of the draw calls (driver side; the GPU work is not included)
+    };
+    CullStats cull_stats;
 
     int width = 1;
     int height = 1;
-    std::vector<std::vector<float>> heightmap{};
+    HeightField heights;    // height per vertex for collision / placement queries (App::getTerrainHeight)
 
     // Default setup: empty mesh list + identity transform.
     Heightmap()
@@ -44,92 +71,167 @@ public:
         local_model_matrix(glm::identity<glm::mat4>()),
         normal_matrix(glm::identity<glm::mat3>()),
         texture_id(0),
-        NUM_STRIPS(0),
-        NUM_VERTS_PER_STRIP(0),
         width(1),
         height(1)
     {
     }
 
     // Build a terrain mesh from a grayscale heightmap image (also stores heights for collision queries).
-    Heightmap(const std::filesystem::path& filename, ShaderProgram shader, GLuint const texture_id = 0) {
+    // Without build_mesh only the heights are loaded (the terrain is drawn by TerrainLOD instead).
+    Heightmap(const std::filesystem::path& filename, ShaderProgram shader, GLuint const texture_id = 0, bool build_mesh = true) {
+        StartupProfile& profile = StartupProfile::get();
+        auto step_start = StartupProfile::Clock::now();
 
-        // 1) Load heightmap image (stb_image).
+        // 1) Load heightmap image (stb_image). 16-bit PNGs keep their full precision (256x finer height steps).
         int nChannels;
-        unsigned char* data = stbi_load(filename.string().c_str(), &width, &height, &nChannels, 0);
+        const std::string file = filename.string();
+        const bool sixteen_bit = stbi_is_16_bit(file.c_str()) != 0;
+        void* data = sixteen_bit
+            ? static_cast<void*>(stbi_load_16(file.c_str(), &width, &height, &nChannels, 0))
+            : static_cast<void*>(stbi_load(file.c_str(), &width, &height, &nChannels, 0));
         if (!data) {
             std::cerr << "Failed to load heightmap named: " << filename << std::endl;
             return;
         }
         std::cout << "Loaded heightmap named: " << filename << std::endl;
+        profile.add("heightmap image", StartupProfile::msSince(step_start),
+            std::to_string(width) + "x" + std::to_string(height) + (sixteen_bit ? ", 16 bit" : ", 8 bit"));
+        step_start = StartupProfile::Clock::now();
 
-        // 2) Generate vertices (+ normals) and cache heights for later queries.
-        std::vector<std::vector<float>> getheightmap(height, std::vector<float>(width));
-        float yScale = 64.0f / 255.0f, yShift = 16.0f, xzScale = 1.0f;;  // scale+shift for height data
-
-        for (int i = 0; i < height; i++)
-        {
-            for (int j = 0; j < width; j++)
-            {
-                // Compute normals via central differences on neighboring heights.
-                int xm = std::max(i - 1, 0);
-                int xp = std::min(i + 1, height - 1);
-                int zm = std::max(j - 1, 0);
-                int zp = std::min(j + 1, width - 1);
-
-                auto getHeight = [&](int row, int col) {
-                    row = glm::clamp(row, 0, height - 1);
-                    col = glm::clamp(col, 0, width - 1);
-                    unsigned char* texel = data + (col + width * row) * nChannels;
-                    return static_cast<float>(texel[0]) * yScale - yShift;
-                    };
-
-                float h = getHeight(i, j);
-                getheightmap[i][j] = h;
-
-                float heightscale = 1.0f;
-                glm::vec3 pL = glm::vec3(-height / 2.0f + (i - 1), getHeight(i - 1, j) * heightscale, -width / 2.0f + j);
-                glm::vec3 pR = glm::vec3(-height / 2.0f + (i + 1), getHeight(i + 1, j) * heightscale, -width / 2.0f + j);
-                glm::vec3 pD = glm::vec3(-height / 2.0f + i, getHeight(i, j - 1) * heightscale, -width / 2.0f + (j - 1));
-                glm::vec3 pU = glm::vec3(-height / 2.0f + i, getHeight(i, j + 1) * heightscale, -width / 2.0f + (j + 1));
-
-                glm::vec3 dX = pR - pL;
-                glm::vec3 dZ = pU - pD;
-                glm::vec3 N = glm::normalize(glm::cross(dZ, dX));
-
-                vertex v;
-                v.position = glm::vec3(-height / 2.0f + i, h, -width / 2.0f + j);
-                v.normal = N;
-                v.texcoord = glm::vec2(static_cast<float>(j) / (width - 1), static_cast<float>(i) / (height - 1));
-                vertices.push_back(v);
-            }
-        }
-
-        heightmap = getheightmap;
+        // 2) Heights once into a flat grid, then vertices (+ normals) from it; both passes run over row blocks in parallel.
+        const unsigned threads = buildThreads(height);
+        std::vector<float> grid;
+        if (sixteen_bit)
+            decodeHeights(static_cast<unsigned short const*>(data), width, height, nChannels, grid, threads);
+        else
+            decodeHeights(static_cast<unsigned char const*>(data), width, height, nChannels, grid, threads);
         stbi_image_free(data);
+        if (build_mesh)
+            buildVertices(grid, width, height, vertices, threads);
+        profile.add("heightmap vertices", StartupProfile::msSince(step_start), std::to_string(threads) + " threads");
+
+        heights = HeightField(height, width, std::move(grid), scale.x);
+        if (!build_mesh)
+            return;
+        step_start = StartupProfile::Clock::now();
 
-        // 3) Build indices for triangle strips (one strip per row).
+        // 3) Build indices chunk by chunk: triangle strips (one per quad row) over the chunk's rows [r0, r1]
+        //    and columns [c0, c1], separated by the primitive restart index so a chunk is one index run.
+        //    Neighbouring chunks share their border vertices.
         std::vector<GLuint> indices;
-        for (int i = 0; i < height - 1; ++i)
+        for (int r0 = 0; r0 < height - 1; r0 += kChunkQuads)
         {
-            for (int j = 0; j < width; ++j)
+            for (int c0 = 0; c0 < width - 1; c0 += kChunkQuads)
             {
-                for (int k = 0; k < 2; ++k)
+                int r1 = std::min(r0 + kChunkQuads, height - 1);
+                int c1 = std::min(c0 + kChunkQuads, width - 1);
+
+                Chunk chunk;
+                chunk.strips.first_index = static_cast<GLuint>(indices.size());
+                chunk.strips.strip_count = static_cast<GLuint>(r1 - r0);
+                chunk.strips.verts_per_strip = static_cast<GLuint>((c1 - c0 + 1) * 2);
+
+                for (int i = r0; i < r1; ++i)
                 {
-                    indices.push_back(static_cast<GLuint>(j + width * (i + k)));
+                    if (i > r0)
+                        indices.push_back(Mesh::kRestartIndex);
+                    for (int j = c0; j <= c1; ++j)
+                    {
+                        for (int k = 0; k < 2; ++k)
+                        {
+                            indices.push_back(static_cast<GLuint>(j + width * (i + k)));
+                        }
+                    }
                 }
+
+                // x and z follow from the grid position, y is the height range inside the chunk.
+                float min_y = heights.at(r0, c0), max_y = min_y;
+                for (int i = r0; i <= r1; ++i)
+                    for (int j = c0; j <= c1; ++j) {
+                        float y = heights.at(i, j);
+                        min_y = std::min(min_y, y);
+                        max_y = std::max(max_y, y);
+                    }
+                chunk.aabb_min = glm::vec3(-height / 2.0f + r0, min_y, -width / 2.0f + c0);
+                chunk.aabb_max = glm::vec3(-height / 2.0f + r1, max_y, -width / 2.0f + c1);
+                chunks.push_back(chunk);
             }
         }
 
-        NUM_STRIPS = static_cast<GLuint>(height - 1);
-        NUM_VERTS_PER_STRIP = static_cast<GLuint>(width * 2);
+        profile.add("heightmap chunks", StartupProfile::msSince(step_start), std::to_string(chunks.size()) + " chunks");
 
-        Mesh Mesh(GL_TRIANGLE_STRIP, shader, vertices, indices, origin, orientation, texture_id, NUM_STRIPS, NUM_VERTS_PER_STRIP);
+        Mesh Mesh(GL_TRIANGLE_STRIP, shader, vertices, indices, origin, orientation, texture_id);
         meshes.push_back(std::move(Mesh));
     }
 
-    // Draw all meshes with base transform + optional per-draw offset/rotation/scale.
-    void draw(glm::vec3 const& offset = glm::vec3(0.0f),
+    // Texels map to [-kHeightShift, kHeightRange - kHeightShift], whatever their bit depth.
+    static constexpr float kHeightRange = 64.0f;
+    static constexpr float kHeightShift = 16.0f;
+
+    // Threads for the CPU build: all hardware threads, but no block smaller than kMinRowsPerThread rows.
+    static constexpr int kMinRowsPerThread = 64;
+    static unsigned buildThreads(int rows) {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        return std::max(1u, std::min(hw, static_cast<unsigned>(rows / kMinRowsPerThread)));
+    }
+
+    // Heights of the first channel, row-major (grid[row * width + col]). Texel = unsigned char (stbi_load)
+    // or unsigned short (stbi_load_16).
+    template <typename Texel>
+    static void decodeHeights(Texel const* texels, int width, int height, int channels,
+        std::vector<float>& grid, unsigned threads = 1) {
+        const float height_scale = kHeightRange / static_cast<float>(std::numeric_limits<Texel>::max());
+        grid.resize(static_cast<size_t>(width) * height);
+        forRowBlocks(height, threads, [&](int row_begin, int row_end) {
+            for (int i = row_begin; i < row_end; ++i) {
+                Texel const* texel = texels + static_cast<size_t>(i) * width * channels;
+                float* out = grid.data() + static_cast<size_t>(i) * width;
+                for (int j = 0; j < width; ++j)
+                    out[j] = static_cast<float>(texel[static_cast<size_t>(j) * channels]) * height_scale - kHeightShift;
+            }
+            });
+    }
+
+    // One vertex per height, normals by central differences (neighbours clamped at the border).
+    // Row i lies at x = -height / 2 + i, column j at z = -width / 2 + j.
+    static void buildVertices(std::vector<float> const& grid, int width, int height,
+        std::vector<vertex>& vertices, unsigned threads = 1) {
+        vertices.resize(static_cast<size_t>(width) * height);
+        forRowBlocks(height, threads, [&](int row_begin, int row_end) {
+            // Per row: x/z slopes and 1 / |N| in separate arrays, so the loop over the columns vectorizes.
+            std::vector<float> nx(width), nz(width), inv_len(width);
+            for (int i = row_begin; i < row_end; ++i) {
+                float const* row = grid.data() + static_cast<size_t>(i) * width;
+                float const* below = grid.data() + static_cast<size_t>(std::max(i - 1, 0)) * width;
+                float const* above = grid.data() + static_cast<size_t>(std::min(i + 1, height - 1)) * width;
+
+                // N = normalize(cross(dZ, dX)) with dX = (2, hR - hL, 0), dZ = (0, hU - hD, 2), i.e. (hL - hR, 2, hD - hU).
+                for (int j = 0; j < width; ++j)
+                    nx[j] = below[j] - above[j];
+                nz[0] = row[0] - row[std::min(1, width - 1)];
+                for (int j = 1; j < width - 1; ++j)
+                    nz[j] = row[j - 1] - row[j + 1];
+                if (width > 1)
+                    nz[width - 1] = row[width - 2] - row[width - 1];
+                for (int j = 0; j < width; ++j)
+                    inv_len[j] = 1.0f / std::sqrt(nx[j] * nx[j] + 4.0f + nz[j] * nz[j]);
+
+                vertex* out = vertices.data() + static_cast<size_t>(i) * width;
+                const float x = -height / 2.0f + i;
+                const float v = static_cast<float>(i) / (height - 1);
+                for (int j = 0; j < width; ++j) {
+                    out[j].position = glm::vec3(x, row[j], -width / 2.0f + j);
+                    out[j].normal = glm::vec3(nx[j], 2.0f, nz[j]) * inv_len[j];
+                    out[j].texcoord = glm::vec2(static_cast<float>(j) / (width - 1), v);
+                }
+            }
+            });
+    }
+
+    // Draw the chunks inside the view frustum of `view_projection` (projection * view) with base transform
+    // + optional per-draw offset/rotation/scale.
+    void draw(glm::mat4 const& view_projection,
+        glm::vec3 const& offset = glm::vec3(0.0f),
         glm::vec3 const& rotation = glm::vec3(0.0f),
         glm::vec3 const& scale_change = glm::vec3(1.0f)) {
 
@@ -150,15 +252,55 @@ public:
         glm::mat4 model_matrix = local_model_matrix * m_s * m_rz * m_ry * m_rx * m_off;
         normal_matrix = glm::mat3(glm::inverseTranspose(model_matrix));
 
-        for (auto& mesh : meshes) {
-            mesh.draw(model_matrix);
-        }
+        // Planes in the terrain's local space, so the chunk boxes are tested as they are.
+        Frustum frustum(view_projection * model_matrix);
+        drawChunks(model_matrix, &frustum);
     }
 
-    // Draw using the stored local_model_matrix (no per-draw overrides).
+    // Draw all chunks using the stored local_model_matrix (no per-draw overrides, no culling).
     void draw() {
-        for (auto& mesh : meshes) {
-            mesh.draw(local_model_matrix);
+        drawChunks(local_model_matrix, nullptr);
+    }
+
+private:
+    std::vector<Mesh::StripRange> visible;    // reused every draw
+
+    // fn(row_begin, row_end) over `threads` contiguous row blocks; the calling thread takes the last block.
+    template <typename F>
+    static void forRowBlocks(int rows, unsigned threads, F&& fn) {
+        threads = std::max(1u, std::min(threads, static_cast<unsigned>(std::max(rows, 1))));
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        int begin = 0;
+        for (unsigned t = 0; t + 1 < threads; ++t) {
+            int end = static_cast<int>(static_cast<long long>(rows) * (t + 1) / threads);
+            workers.emplace_back(fn, begin, end);
+            begin = end;
+        }
+        fn(begin, rows);
+        for (auto& w : workers)
+            w.join();
+    }
+
+    void drawChunks(glm::mat4 const& model_matrix, Frustum const* frustum) {
+        visible.clear();
+        cull_stats = {};
+        cull_stats.chunks_total = chunks.size();
+
+        for (auto const& chunk : chunks) {
+            std::size_t triangles = static_cast<std::size_t>(chunk.strips.strip_count) * (chunk.strips.verts_per_strip - 2);
+            cull_stats.triangles_total += triangles;
+            if (frustum && !frustum->intersects(chunk.aabb_min, chunk.aabb_max))
+                continue;
+            visible.push_back(chunk.strips);
+            cull_stats.triangles_visible += triangles;
+        }
+        cull_stats.chunks_visible = visible.size();
+
+        auto submit_start = std::chrono::steady_clock::now();
+        for (auto const& mesh : meshes) {
+            cull_stats.draw_calls += mesh.drawStrips(model_matrix, atlas_layer, visible.data(), visible.size());
         }
+        cull_stats.submit_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
     }
 };
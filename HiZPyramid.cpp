@@ -0,0 +1,92 @@
+#include "HiZPyramid.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "RenderState.hpp"
+
+namespace {
+    // Next mip size: half, at least one texel.
+    glm::ivec2 halved(glm::ivec2 size) {
+        return glm::ivec2(std::max(size.x / 2, 1), std::max(size.y / 2, 1));
+    }
+}
+
+bool HiZPyramid::create(std::filesystem::path const& file) {
+    destroy();
+    try {
+        program_ = ShaderProgram(file);
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Occlusion culling disabled: " << e.what();
+        program_ = ShaderProgram();
+        return false;
+    }
+    u_source_ = program_.uniform("source");
+    u_source_lod_ = program_.uniform("source_lod");
+    u_source_size_ = program_.uniform("source_size");
+    u_target_size_ = program_.uniform("target_size");
+    u_target_ = program_.uniform("target");
+    return true;
+}
+
+void HiZPyramid::destroy() {
+    if (ready())
+        program_.clear();
+    if (texture_) {
+        RenderState::get().forgetTexture(texture_);
+        glDeleteTextures(1, &texture_);
+    }
+    texture_ = 0;
+    size_ = built_for_ = glm::ivec2(0);
+    levels_ = 0;
+}
+
+void HiZPyramid::allocate(int width, int height) {
+    if (texture_) {
+        RenderState::get().forgetTexture(texture_);
+        glDeleteTextures(1, &texture_);
+    }
+    size_ = halved(glm::ivec2(width, height));
+    levels_ = 1;
+    for (int extent = std::max(size_.x, size_.y); extent > 1; extent /= 2)
+        ++levels_;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture_);
+    glObjectLabel(GL_TEXTURE, texture_, -1, "HiZPyramid");
+    glTextureStorage2D(texture_, levels_, GL_R32F, size_.x, size_.y);
+    glTextureParameteri(texture_, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(texture_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(texture_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    built_for_ = glm::ivec2(width, height);
+}
+
+void HiZPyramid::build(GLuint depth_texture, int width, int height) {
+    if (!ready() || depth_texture == 0 || width <= 0 || height <= 0)
+        return;
+    if (built_for_ != glm::ivec2(width, height))
+        allocate(width, height);
+
+    RenderState& state = RenderState::get();
+    state.useProgram(program_.getID());
+    state.setInt(u_source_, static_cast<int>(kTextureUnit));
+    state.setInt(u_target_, 0);     // image unit
+
+    glm::ivec2 source_size(width, height);
+    glm::ivec2 target_size = size_;
+    for (int level = 0; level < levels_; ++level) {
+        // Level 0 reads the depth texture, every further level the one before it.
+        state.bindTextureUnit(kTextureUnit, level == 0 ? depth_texture : texture_);
+        program_.setUniform(u_source_lod_, level == 0 ? 0 : level - 1);
+        glProgramUniform2i(program_.getID(), u_source_size_.location, source_size.x, source_size.y);
+        glProgramUniform2i(program_.getID(), u_target_size_.location, target_size.x, target_size.y);
+        glBindImageTexture(0, texture_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((target_size.x + kGroupSize - 1) / kGroupSize, (target_size.y + kGroupSize - 1) / kGroupSize, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        source_size = target_size;
+        target_size = halved(target_size);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "ShaderProgram.hpp"
+
+// Hierarchical-Z pyramid of a depth texture (hiz_build.comp): an R32F mip chain where every texel holds the
+// farthest depth of the area it covers. Level 0 is half the depth texture's size, every further level halves
+// again down to 1x1. A box whose nearest depth is behind the farthest depth of the texels under it is hidden
+// (GpuCulling tests the instances against it). GL thread only; destroy() while the context is alive.
+class HiZPyramid {
+public:
+    static constexpr GLuint kTextureUnit = 3;   // sampler unit while building and culling (0-2 are the mesh/terrain textures)
+
+    // Compile the reduction program; false (and no occlusion culling) if that fails.
+    bool create(std::filesystem::path const& file = "hiz_build.comp");
+    void destroy();
+    bool ready() const { return program_.getID() != 0; }
+
+    // Reduce `depth_texture` (width x height, depth drawn so far) into the pyramid, reallocated if the size
+    // changed. Ends with the barrier for the texture fetches of the culling pass.
+    void build(GLuint depth_texture, int width, int height);
+
+    GLuint texture() const { return texture_; }
+    glm::ivec2 size() const { return size_; }     // of level 0
+    int levels() const { return levels_; }
+
+private:
+    static constexpr GLuint kGroupSize = 8;     // local_size_x/y
+
+    void allocate(int width, int height);
+
+    ShaderProgram program_;
+    UniformHandle u_source_, u_source_lod_, u_source_size_, u_target_size_, u_target_;
+    GLuint texture_ = 0;
+    glm::ivec2 size_{ 0 };
+    int levels_ = 0;
+    glm::ivec2 built_for_{ 0 };     // depth texture size the pyramid was allocated for
+};
@@ -0,0 +1,96 @@
+#include "IndirectDrawList.hpp"
+
+#include <algorithm>
+
+#include "GeometryArena.hpp"
+#include "RenderState.hpp"
+
+void IndirectDrawList::create(ShaderProgram const& shader) {
+    destroy();
+    program_ = shader.getID();
+    u_indirect_ = shader.uniform("indirect");
+    u_draw_offset_ = shader.uniform("draw_offset");
+    u_instanced_ = shader.uniform("instanced");
+}
+
+void IndirectDrawList::destroy() {
+    if (command_buffer_) glDeleteBuffers(1, &command_buffer_);
+    if (draw_buffer_) glDeleteBuffers(1, &draw_buffer_);
+    command_buffer_ = draw_buffer_ = 0;
+    capacity_ = 0;
+    program_ = 0;
+    queued_.clear();
+}
+
+bool IndirectDrawList::add(Mesh const& mesh, glm::mat4 const& model, glm::mat3 const& normal, int atlas_layer) {
+    if (!accepts(mesh))
+        return false;
+
+    MeshGeometry const& g = *mesh.geometry;
+    Queued q;
+    q.texture = atlas_layer >= 0 ? 0 : mesh.texture_id;
+    q.command = { static_cast<GLuint>(g.index_count), 1, g.first_index, g.base_vertex, 0 };
+    q.data.model = model;
+    for (int col = 0; col < 3; ++col)
+        q.data.normal[col] = glm::vec4(normal[col], 0.0f);
+    q.data.atlas_layer = atlas_layer;
+    queued_.push_back(q);
+    return true;
+}
+
+void IndirectDrawList::submit() {
+    stats_ = {};
+    if (queued_.empty())
+        return;
+
+    // Group by texture; the order inside a group does not matter for opaque meshes.
+    std::stable_sort(queued_.begin(), queued_.end(), [](Queued const& a, Queued const& b) { return a.texture < b.texture; });
+    commands_.clear();
+    draws_.clear();
+    for (auto const& q : queued_) {
+        commands_.push_back(q.command);
+        draws_.push_back(q.data);
+    }
+
+    if (queued_.size() > capacity_) {
+        if (command_buffer_) glDeleteBuffers(1, &command_buffer_);
+        if (draw_buffer_) glDeleteBuffers(1, &draw_buffer_);
+        capacity_ = std::max(queued_.size(), capacity_ * 2);
+        glCreateBuffers(1, &command_buffer_);
+        glObjectLabel(GL_BUFFER, command_buffer_, -1, "IndirectCommands");
+        glNamedBufferStorage(command_buffer_, static_cast<GLsizeiptr>(capacity_ * sizeof(Command)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glCreateBuffers(1, &draw_buffer_);
+        glObjectLabel(GL_BUFFER, draw_buffer_, -1, "IndirectDraws");
+        glNamedBufferStorage(draw_buffer_, static_cast<GLsizeiptr>(capacity_ * sizeof(DrawData)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    glNamedBufferSubData(command_buffer_, 0, static_cast<GLsizeiptr>(commands_.size() * sizeof(Command)), commands_.data());
+    glNamedBufferSubData(draw_buffer_, 0, static_cast<GLsizeiptr>(draws_.size() * sizeof(DrawData)), draws_.data());
+
+    RenderState& state = RenderState::get();
+    state.useProgram(program_);
+    state.setInt(u_instanced_, 0);
+    state.setInt(u_indirect_, 1);
+    state.bindVertexArray(GeometryArena::get().vao());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kDrawBlockBinding, draw_buffer_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+
+    // One call per run of equal textures (unit 0 is only sampled by meshes without an atlas layer).
+    std::size_t first = 0;
+    while (first < queued_.size()) {
+        std::size_t last = first + 1;
+        while (last < queued_.size() && queued_[last].texture == queued_[first].texture)
+            ++last;
+        if (queued_[first].texture)
+            state.bindTextureUnit(0, queued_[first].texture);
+        state.setInt(u_draw_offset_, static_cast<int>(first));
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+            reinterpret_cast<void const*>(first * sizeof(Command)), static_cast<GLsizei>(last - first), 0);
+        ++stats_.calls;
+        first = last;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    state.setInt(u_indirect_, 0);
+    stats_.draws = queued_.size();
+    queued_.clear();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+#include "ShaderProgram.hpp"
+
+// Opaque meshes from the GeometryArena, queued during the frame and submitted with one
+// glMultiDrawElementsIndirect per texture (atlas-textured meshes all share one). The per-draw model matrix,
+// normal matrix and atlas layer go to a storage buffer that lighting_shader.vert reads at
+// draw_offset + gl_DrawID, so the CPU cost of submit() is two buffer uploads and a few calls, whatever
+// the number of meshes. GL thread only.
+class IndirectDrawList {
+public:
+    static constexpr GLuint kDrawBlockBinding = 2;     // `Draws` in lighting_shader.vert
+
+    // std430 entry of `Draws`; the normal matrix columns are padded to vec4.
+    struct DrawData {
+        glm::mat4 model;
+        glm::vec4 normal[3];
+        GLint atlas_layer;
+        GLint pad_[3];
+    };
+    static_assert(sizeof(DrawData) == 128, "DrawData must match the std430 layout of DrawData in lighting_shader.vert");
+
+    // glMultiDrawElementsIndirect command layout.
+    struct Command {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+    static_assert(sizeof(Command) == Mesh::kIndirectCommandSize, "Command must match the GL indirect command layout");
+
+    // Last submit() (printed with the U report).
+    struct Stats {
+        std::size_t draws = 0;          // meshes drawn
+        std::size_t calls = 0;          // glMultiDrawElementsIndirect calls, one per texture
+    };
+
+    // Buffers and the uniforms of `shader` (the program of the queued meshes).
+    void create(ShaderProgram const& shader);
+    void destroy();
+
+    // Meshes in the arena, drawn as GL_TRIANGLES with the list's program; others have to be drawn the usual way.
+    bool accepts(Mesh const& mesh) const {
+        return program_ && mesh.geometry && mesh.geometry->inArena() && mesh.primitive_type == GL_TRIANGLES
+            && mesh.shader.getID() == program_;
+    }
+
+    // Queue one mesh; false (nothing queued) if the list does not accept it.
+    bool add(Mesh const& mesh, glm::mat4 const& model, glm::mat3 const& normal, int atlas_layer);
+    std::size_t size() const { return queued_.size(); }
+
+    // Draw everything queued since the last submit() and empty the list.
+    void submit();
+
+    Stats const& stats() const { return stats_; }
+
+private:
+    struct Queued {
+        GLuint texture;         // 0 = atlas
+        Command command;
+        DrawData data;
+    };
+
+    GLuint program_ = 0;
+    UniformHandle u_indirect_, u_draw_offset_, u_instanced_;
+    GLuint command_buffer_ = 0, draw_buffer_ = 0;
+    std::size_t capacity_ = 0;      // entries both buffers have room for
+
+    std::vector<Queued> queued_;
+    std::vector<Command> commands_;
+    std::vector<DrawData> draws_;
+    Stats stats_;
+};
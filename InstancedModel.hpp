@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Frustum.hpp"
+#include "GpuCulling.hpp"
+#include "Model.hpp"
+
+// Many copies of one model (cacti, rocks) drawn with a single glDrawElementsInstanced per mesh.
+// The template model supplies the (shared) geometry, texture and local AABB; each instance only has a transform.
+// Instance matrices live in one GL buffer that holds only the instances inside the view frustum; it is rewritten
+// when instances were added or moved, or when the visible set changed. With cullOnGpu() a compute pass fills it
+// instead and the draw takes the instance count from indirect commands, so nothing comes back to the CPU.
+class InstancedModel {
+public:
+    struct Instance {
+        glm::vec3 origin{ 0.0f };
+        glm::vec3 orientation{ 0.0f };  // rotation around x/y/z in radians
+        glm::vec3 scale{ 1.0f };
+    };
+
+    Model model;        // shared geometry + texture, its own transform is ignored
+    bool solid{ false };
+
+    InstancedModel() = default;
+
+    // GL thread: takes over the template's meshes and attaches the instance buffer to them.
+    explicit InstancedModel(Model const& source)
+        : model(source)
+    {
+        model.computeAABB();
+        glCreateBuffers(1, &instance_buffer);
+        glObjectLabel(GL_BUFFER, instance_buffer, -1, "InstanceVBO");
+        // Never empty: arena meshes share their VAO, so plain draws of other meshes fetch (and ignore) instance 0.
+        const Mesh::InstanceData identity{ glm::mat4(1.0f), glm::mat3(1.0f) };
+        glNamedBufferData(instance_buffer, sizeof(identity), &identity, GL_DYNAMIC_DRAW);
+        uploaded_capacity = 1;
+        if (model.meshes)
+            for (auto const& mesh : *model.meshes)
+                mesh.attachInstanceBuffer(instance_buffer);
+    }
+
+    void add(Instance const& instance) {
+        instances.push_back(instance);
+        dirty = true;
+    }
+
+    std::size_t size() const { return instances.size(); }
+    Instance const& operator[](std::size_t i) const { return instances[i]; }
+
+    // Mutable access marks the buffer for re-upload before the next draw.
+    Instance& at(std::size_t i) {
+        dirty = true;
+        return instances[i];
+    }
+
+    // Test every instance's world box against the frustum and pack the visible ones into the instance buffer
+    // (only if the set changed). Returns the number of visible instances; a default Frustum keeps all.
+    std::size_t cull(Frustum const& frustum) {
+        if (dirty) rebuild();
+        gpu_culled = false;
+        previous_visible.swap(visible);
+        visible.resize(instances.size());
+        std::size_t count = frustum.cull(boxes, visible.data());
+        if (uploaded_dirty || visible != previous_visible)
+            upload();
+        return count;
+    }
+
+    // Cull with `culler` on the GPU instead of cull(); the instance matrices go up once per change.
+    void cullOnGpu(GpuCulling& culler, Frustum const& frustum) {
+        if (dirty) rebuild();
+        if (instances.empty() || !model.meshes || model.meshes->empty()) return;
+        if (gpu_source_dirty) uploadGpuSource();
+        culler.run(frustum, gpu_source, instances.size(), instance_buffer, gpu_commands, gpu_templates.data(), gpu_templates.size());
+        gpu_culled = true;
+        uploaded_dirty = true;      // the buffer no longer holds what cull() packed
+    }
+
+    // Instances the last cullOnGpu() kept. Reads the count back and so waits for the GPU: for reports only.
+    std::size_t gpuVisibleCount() const {
+        if (!gpu_culled || !gpu_commands) return 0;
+        GLuint count = 0;
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glGetNamedBufferSubData(gpu_commands, offsetof(IndirectDrawList::Command, instance_count), sizeof(count), &count);
+        return count;
+    }
+
+    // The instances kept by the last cull() or cullOnGpu() (all of them without one) in one draw call per mesh.
+    void draw() {
+        if (instances.empty() || !model.meshes) return;
+        if (gpu_culled) {
+            for (std::size_t i = 0; i < model.meshes->size(); ++i)
+                (*model.meshes)[i].drawInstancedIndirect(gpu_commands, i, model.atlas_layer, instance_buffer);
+            return;
+        }
+        if (dirty) cull(Frustum());
+        if (drawn == 0) return;
+        for (auto const& mesh : *model.meshes)
+            mesh.drawInstanced(static_cast<GLsizei>(drawn), model.atlas_layer, instance_buffer);
+    }
+
+    std::size_t drawnCount() const { return drawn; }
+
+    // World AABB of one instance (same approximation as Model::getWorldAABB: scale only, no rotation).
+    std::pair<glm::vec3, glm::vec3> getWorldAABB(std::size_t i) const {
+        Instance const& in = instances[i];
+        glm::vec3 a = in.origin + model.aabb_min_local * in.scale;
+        glm::vec3 b = in.origin + model.aabb_max_local * in.scale;
+        return { glm::min(a, b), glm::max(a, b) };
+    }
+
+    // Free the instance buffer and drop the geometry handle (deleted with its last user).
+    void clear() {
+        model = Model();
+        glDeleteBuffers(1, &instance_buffer);
+        instance_buffer = 0;
+        if (gpu_source) glDeleteBuffers(1, &gpu_source);
+        if (gpu_commands) glDeleteBuffers(1, &gpu_commands);
+        gpu_source = gpu_commands = 0;
+        gpu_templates.clear();
+        gpu_culled = false;
+        instances.clear();
+        all.clear();
+        boxes.resize(0);
+        visible.clear();
+        previous_visible.clear();
+        uploaded_capacity = 0;
+        drawn = 0;
+    }
+
+private:
+    std::vector<Instance> instances;
+    std::vector<Mesh::InstanceData> all;        // matrices of every instance, rebuilt when dirty
+    Frustum::BoxList boxes;                     // world boxes of every instance (rotation included)
+    std::vector<std::uint8_t> visible, previous_visible;
+    std::vector<Mesh::InstanceData> packed;     // visible instances as uploaded
+    GLuint instance_buffer{ 0 };
+    std::size_t uploaded_capacity{ 0 };   // instances the GL buffer has room for
+    std::size_t drawn{ 0 };               // instances in the GL buffer
+    bool dirty{ false };                  // instances changed, matrices and boxes are stale
+    bool uploaded_dirty{ false };         // matrices changed since the last upload
+
+    // GPU culling: matrices and boxes of every instance, one indirect command per mesh.
+    GLuint gpu_source{ 0 }, gpu_commands{ 0 };
+    std::vector<IndirectDrawList::Command> gpu_templates;
+    bool gpu_source_dirty{ true };
+    bool gpu_culled{ false };             // draw() reads the instance count from gpu_commands
+
+    // Same transform order as Model::draw() without per-draw offsets.
+    void rebuild() {
+        all.clear();
+        all.reserve(instances.size());
+        boxes.resize(instances.size());
+        for (std::size_t i = 0; i < instances.size(); ++i) {
+            Instance const& in = instances[i];
+            glm::mat4 m = glm::translate(glm::mat4(1.0f), in.origin);
+            m = glm::rotate(m, in.orientation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+            m = glm::rotate(m, in.orientation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+            m = glm::rotate(m, in.orientation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+            m = glm::scale(m, in.scale);
+            all.push_back({ m, glm::mat3(glm::inverseTranspose(m)) });
+            boxes.setTransformed(i, m, model.aabb_min_local, model.aabb_max_local);
+        }
+        dirty = false;
+        uploaded_dirty = true;
+        gpu_source_dirty = true;
+    }
+
+    void uploadGpuSource() {
+        std::vector<GpuCulling::Instance> source(instances.size());
+        for (std::size_t i = 0; i < instances.size(); ++i) {
+            source[i].model = all[i].model;
+            for (int col = 0; col < 3; ++col)
+                source[i].normal[col] = glm::vec4(all[i].normal[col], 0.0f);
+            source[i].box_min = glm::vec4(boxes.min_x[i], boxes.min_y[i], boxes.min_z[i], 0.0f);
+            source[i].box_max = glm::vec4(boxes.max_x[i], boxes.max_y[i], boxes.max_z[i], 0.0f);
+        }
+        if (!gpu_source) {
+            glCreateBuffers(1, &gpu_source);
+            glObjectLabel(GL_BUFFER, gpu_source, -1, "InstanceCullSource");
+        }
+        glNamedBufferData(gpu_source, static_cast<GLsizeiptr>(source.size() * sizeof(GpuCulling::Instance)), source.data(), GL_STATIC_DRAW);
+
+        // The compute pass may keep every instance.
+        if (instances.size() > uploaded_capacity) {
+            glNamedBufferData(instance_buffer, static_cast<GLsizeiptr>(instances.size() * sizeof(Mesh::InstanceData)), nullptr, GL_DYNAMIC_DRAW);
+            uploaded_capacity = instances.size();
+        }
+
+        gpu_templates.clear();
+        for (auto const& mesh : *model.meshes) {
+            MeshGeometry const* g = mesh.geometry.get();
+            gpu_templates.push_back({ g ? static_cast<GLuint>(g->index_count) : 0u, 0u, g ? g->first_index : 0u,
+                g ? g->base_vertex : 0, 0u });
+        }
+        if (!gpu_commands) {
+            glCreateBuffers(1, &gpu_commands);
+            glObjectLabel(GL_BUFFER, gpu_commands, -1, "InstanceCullCommands");
+        }
+        glNamedBufferData(gpu_commands, static_cast<GLsizeiptr>(gpu_templates.size() * sizeof(IndirectDrawList::Command)), nullptr, GL_DYNAMIC_DRAW);
+        gpu_source_dirty = false;
+    }
+
+    void upload() {
+        packed.clear();
+        for (std::size_t i = 0; i < all.size(); ++i)
+            if (visible[i])
+                packed.push_back(all[i]);
+        drawn = packed.size();
+        uploaded_dirty = false;
+        if (packed.empty())
+            return;
+
+        const GLsizeiptr bytes = static_cast<GLsizeiptr>(packed.size() * sizeof(Mesh::InstanceData));
+        if (packed.size() > uploaded_capacity) {
+            glNamedBufferData(instance_buffer, bytes, packed.data(), GL_DYNAMIC_DRAW);
+            uploaded_capacity = packed.size();
+        }
+        else {
+            glNamedBufferSubData(instance_buffer, 0, bytes, packed.data());
+        }
+    }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+// Read-only memory mapping of a whole file (RAII).
+// Loaders use it to parse file contents in place, without copying them into a stream first.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Map the file; returns false if it can not be opened. Empty files map to (nullptr, 0).
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return opened_; }
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool opened_ = false;
+
+#ifdef _WIN32
+    void* file_ = nullptr;      // HANDLE from CreateFileW
+    void* mapping_ = nullptr;   // HANDLE from CreateFileMappingW
+#endif
+};
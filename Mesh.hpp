@@ -4,16 +4,19 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <memory>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
 #include "assets.hpp"
 #include "ShaderProgram.hpp"
+#include "RenderState.hpp"
+#include "MeshGeometry.hpp"
 
 class Mesh {
 public:
-    // Mesh state: transform + geometry + rendering setup.
+    // Mesh state: transform + shared geometry + rendering setup.
     glm::vec3 origin{};
     glm::vec3 orientation{};
     glm::mat4 model_matrix{};
@@ -22,8 +25,9 @@ public:
     GLenum primitive_type = GL_POINT;
 
     ShaderProgram shader;
-    std::vector<vertex> vertices{};
-    std::vector<GLuint> indices{};
+
+    // GPU buffers + bounds, shared by every copy of this mesh (copying a Mesh never copies geometry).
+    GeometryHandle geometry;
 
     // Extra params used by the heightmap renderer (triangle strips).
     GLuint NUM_STRIPS = 0;
@@ -45,90 +49,160 @@ public:
         GLuint const texture_id = 0,
         GLuint NUM_STRIPS = 0,
         GLuint NUM_VERTS_PER_STRIP = 0)
-        : primitive_type(primitive_type),
-        shader(shader),
-        vertices(vertices),
-        indices(indices),
-        origin(origin),
+        : Mesh(primitive_type, shader, vertices.data(), vertices.size(), indices.data(), indices.size(),
+            origin, orientation, texture_id, NUM_STRIPS, NUM_VERTS_PER_STRIP)
+    {
+    };
+
+    // Same, but upload straight from raw arrays (e.g. a memory-mapped mesh cache).
+    Mesh(GLenum primitive_type,
+        ShaderProgram shader,
+        vertex const* vertex_data, size_t vertex_count,
+        GLuint const* index_data, size_t index_count,
+        glm::vec3 const& origin,
+        glm::vec3 const& orientation,
+        GLuint const texture_id = 0,
+        GLuint NUM_STRIPS = 0,
+        GLuint NUM_VERTS_PER_STRIP = 0)
+        : Mesh(primitive_type, shader,
+            std::make_shared<const MeshGeometry>(shader, vertex_data, vertex_count, index_data, index_count),
+            origin, orientation, texture_id, NUM_STRIPS, NUM_VERTS_PER_STRIP)
+    {
+    };
+
+    // Draw already uploaded geometry (e.g. from MeshRegistry).
+    Mesh(GLenum primitive_type,
+        ShaderProgram shader,
+        GeometryHandle geometry,
+        glm::vec3 const& origin,
+        glm::vec3 const& orientation,
+        GLuint const texture_id = 0,
+        GLuint NUM_STRIPS = 0,
+        GLuint NUM_VERTS_PER_STRIP = 0)
+        : origin(origin),
         orientation(orientation),
         texture_id(texture_id),
+        primitive_type(primitive_type),
+        shader(shader),
+        geometry(std::move(geometry)),
         NUM_STRIPS(NUM_STRIPS),
-        NUM_VERTS_PER_STRIP(NUM_VERTS_PER_STRIP)
+        NUM_VERTS_PER_STRIP(NUM_VERTS_PER_STRIP),
+        u_model_matrix(shader.uniform("uM_m")),
+        u_atlas_layer(shader.uniform("atlasLayer")),
+        u_instanced(shader.uniform("instanced"))
     {
-        glCreateVertexArrays(1, &VAO);
-        glObjectLabel(GL_VERTEX_ARRAY, VAO, -1, "MyMeshVAO");
-
-        // Tell OpenGL how vertex data is laid out (pos/normal/texcoord).
-        GLint position_attrib_location = glGetAttribLocation(shader.getID(), "aPos");
-        glVertexArrayAttribFormat(VAO, position_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(vertex, position));
-        glVertexArrayAttribBinding(VAO, position_attrib_location, 0);
-        glEnableVertexArrayAttrib(VAO, position_attrib_location);
-
-        GLint normal_attrib_location = glGetAttribLocation(shader.getID(), "aNorm");
-        glVertexArrayAttribFormat(VAO, normal_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(vertex, normal));
-        glVertexArrayAttribBinding(VAO, normal_attrib_location, 0);
-        glEnableVertexArrayAttrib(VAO, normal_attrib_location);
-
-        GLint texture_attrib_location = glGetAttribLocation(shader.getID(), "aTex");
-        glVertexArrayAttribFormat(VAO, texture_attrib_location, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, texcoord));
-        glVertexArrayAttribBinding(VAO, texture_attrib_location, 0);
-        glEnableVertexArrayAttrib(VAO, texture_attrib_location);
-
-        // Upload vertex/index buffers.
-        glCreateBuffers(1, &VBO);
-        glObjectLabel(GL_BUFFER, VBO, -1, "MyMeshVBO");
-        glCreateBuffers(1, &EBO);
-        glObjectLabel(GL_BUFFER, EBO, -1, "MyMeshEBO");
-
-        glNamedBufferData(VBO, vertices.size() * sizeof(vertex), vertices.data(), GL_STATIC_DRAW);
-        glNamedBufferData(EBO, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-        glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(vertex));
-        glVertexArrayElementBuffer(VAO, EBO);
     };
 
-    // Render the mesh with the given model matrix and optional single texture.
-    void draw(glm::mat4 const& model_matrix) {
-        if (VAO == 0) {
+    // Render the mesh with the given model matrix and either its own texture or a layer of the atlas array.
+    void draw(glm::mat4 const& model_matrix, int atlas_layer = -1) const {
+        if (!geometry) {
             std::cerr << "VAO not initialized!\n";
             return;
         }
 
-        shader.activate();
-        glObjectLabel(GL_PROGRAM, shader.getID(), -1, "MyMeshShader");
-        shader.setUniform("uM_m", model_matrix);
+        bind(atlas_layer, false);
+        shader.setUniform(u_model_matrix, model_matrix);
 
-        if (texture_id > 0) {
-            int i = 0;
-            glBindTextureUnit(i, texture_id);
-            shader.setUniform("tex0", i);
+        if (primitive_type == GL_TRIANGLE_STRIP) {
+            StripRange all{ 0, NUM_STRIPS, NUM_VERTS_PER_STRIP };
+            submitStrips(&all, 1);
+        }
+        else {
+            glDrawElementsBaseVertex(primitive_type, geometry->index_count, GL_UNSIGNED_INT, geometry->indexOffset(), geometry->base_vertex);
         }
+    }
 
-        glBindVertexArray(VAO);
+    // Strip meshes separate their strips with this index; the app enables GL_PRIMITIVE_RESTART_FIXED_INDEX.
+    static constexpr GLuint kRestartIndex = 0xFFFFFFFFu;
 
-        if (primitive_type == GL_TRIANGLE_STRIP) {
-            GLsizei vertsPerStrip = static_cast<GLsizei>(NUM_VERTS_PER_STRIP);
-            for (GLuint strip = 0; strip < NUM_STRIPS; ++strip)
-            {
-                uintptr_t offset =
-                    static_cast<uintptr_t>(sizeof(unsigned int)) *
-                    static_cast<uintptr_t>(NUM_VERTS_PER_STRIP) *
-                    static_cast<uintptr_t>(strip);
-
-                glDrawElements(GL_TRIANGLE_STRIP, vertsPerStrip, GL_UNSIGNED_INT, reinterpret_cast<void*>(offset));
-            }
+    // Consecutive equal-length triangle strips in the index buffer, e.g. one terrain chunk, each strip
+    // followed by kRestartIndex (except the last).
+    struct StripRange {
+        GLuint first_index = 0;
+        GLuint strip_count = 0;
+        GLuint verts_per_strip = 0;
+
+        GLsizei indexCount() const { return strip_count ? static_cast<GLsizei>(strip_count * (verts_per_strip + 1) - 1) : 0; }
+    };
+
+    // How strip ranges are submitted: one glDrawElements per strip (the old way, kept to compare driver
+    // CPU time) or a single glMultiDrawElements with one restart-separated entry per range.
+    enum class StripSubmission { PerStrip, MultiDraw };
+    static inline StripSubmission strip_submission = StripSubmission::MultiDraw;
+
+    // Draw only some strip ranges of a GL_TRIANGLE_STRIP mesh (the terrain chunks that passed culling), bound once.
+    // Returns the number of draw calls issued.
+    std::size_t drawStrips(glm::mat4 const& model_matrix, int atlas_layer, StripRange const* ranges, std::size_t count) const {
+        if (!geometry || count == 0)
+            return 0;
+
+        bind(atlas_layer, false);
+        shader.setUniform(u_model_matrix, model_matrix);
+        return submitStrips(ranges, count);
+    }
+
+    // Per-instance attributes read by lighting_shader.vert when `instanced` is set: iM_m (model matrix,
+    // locations 3-6) and iN_m (normal matrix, locations 7-9), one InstanceData per instance in `buffer`.
+    struct InstanceData {
+        glm::mat4 model;
+        glm::mat3 normal;
+    };
+    static constexpr GLuint kInstanceBinding = 1;
+
+    // Changes GL state of the shared VAO only; the other attributes are not affected. Arena geometry shares
+    // its VAO with other meshes, so drawInstanced() is given the buffer again and re-attaches it.
+    void attachInstanceBuffer(GLuint buffer) const {
+        if (!geometry) return;
+        const GLuint VAO = geometry->VAO;
+
+        for (GLuint col = 0; col < 4; ++col) {
+            GLuint loc = 3 + col;
+            glVertexArrayAttribFormat(VAO, loc, 4, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstanceData, model) + col * sizeof(glm::vec4)));
+            glVertexArrayAttribBinding(VAO, loc, kInstanceBinding);
+            glEnableVertexArrayAttrib(VAO, loc);
         }
-        else {
-            glDrawElements(primitive_type, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+        for (GLuint col = 0; col < 3; ++col) {
+            GLuint loc = 7 + col;
+            glVertexArrayAttribFormat(VAO, loc, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstanceData, normal) + col * sizeof(glm::vec3)));
+            glVertexArrayAttribBinding(VAO, loc, kInstanceBinding);
+            glEnableVertexArrayAttrib(VAO, loc);
         }
+        glVertexArrayVertexBuffer(VAO, kInstanceBinding, buffer, 0, sizeof(InstanceData));
+        glVertexArrayBindingDivisor(VAO, kInstanceBinding, 1);
+    }
+
+    // Render `count` instances from the attached instance buffer with one draw call (triangle meshes only).
+    void drawInstanced(GLsizei count, int atlas_layer = -1, GLuint instance_buffer = 0) const {
+        if (!geometry || count <= 0)
+            return;
+
+        bind(atlas_layer, true);
+        if (instance_buffer && geometry->inArena())
+            glVertexArrayVertexBuffer(geometry->VAO, kInstanceBinding, instance_buffer, 0, sizeof(InstanceData));
+        glDrawElementsInstancedBaseVertex(primitive_type, geometry->index_count, GL_UNSIGNED_INT, geometry->indexOffset(),
+            count, geometry->base_vertex);
+    }
+
+    // Size of one glDrawElementsIndirect command (count, instance count, first index, base vertex, base instance).
+    static constexpr std::size_t kIndirectCommandSize = 5 * sizeof(GLuint);
+
+    // Same, with the instance count taken from command `command` of `command_buffer` (written by GpuCulling).
+    void drawInstancedIndirect(GLuint command_buffer, std::size_t command, int atlas_layer, GLuint instance_buffer) const {
+        if (!geometry || !command_buffer)
+            return;
+
+        bind(atlas_layer, true);
+        if (instance_buffer && geometry->inArena())
+            glVertexArrayVertexBuffer(geometry->VAO, kInstanceBinding, instance_buffer, 0, sizeof(InstanceData));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+        glDrawElementsIndirect(primitive_type, GL_UNSIGNED_INT, reinterpret_cast<void const*>(command * kIndirectCommandSize));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
     }
 
-    // Free GPU objects, reset render state, and clear CPU-side geometry.
+    // Release the geometry (deleted with its last user) and reset render state. The texture is only borrowed
+    // (its CachedTexture handle deletes it), so the id is just dropped.
     void clear(void) {
-        if (texture_id) {
-            glDeleteTextures(1, &texture_id);
-            texture_id = 0;
-        }
+        texture_id = 0;
 
         primitive_type = GL_POINT;
         ambient_material = glm::vec4(1.0f);
@@ -136,17 +210,56 @@ public:
         specular_material = glm::vec4(1.0f);
         reflectivity = 1.0f;
 
-        vertices.clear();
-        indices.clear();
+        geometry.reset();
         origin = glm::vec3(0.0f);
         orientation = glm::vec3(0.0f);
-
-        glDeleteBuffers(1, &VBO);
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &EBO);
     };
 
 private:
-    // OpenGL object IDs (0 means "not created").
-    unsigned int VAO{ 0 }, VBO{ 0 }, EBO{ 0 };
+    // Uniforms set on every draw, looked up once.
+    UniformHandle u_model_matrix, u_atlas_layer, u_instanced;
+
+    std::size_t submitStrips(StripRange const* ranges, std::size_t count) const {
+        if (strip_submission == StripSubmission::PerStrip) {
+            std::size_t calls = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                StripRange const& range = ranges[i];
+                for (GLuint strip = 0; strip < range.strip_count; ++strip)
+                {
+                    uintptr_t offset =
+                        static_cast<uintptr_t>(sizeof(unsigned int)) *
+                        (static_cast<uintptr_t>(range.first_index) +
+                            static_cast<uintptr_t>(range.verts_per_strip + 1) * static_cast<uintptr_t>(strip));
+
+                    glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLsizei>(range.verts_per_strip), GL_UNSIGNED_INT, reinterpret_cast<void*>(offset));
+                }
+                calls += range.strip_count;
+            }
+            return calls;
+        }
+
+        // Scratch arrays for glMultiDrawElements, reused across draws (GL thread only).
+        static std::vector<GLsizei> counts;
+        static std::vector<void const*> offsets;
+        counts.clear();
+        offsets.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            counts.push_back(ranges[i].indexCount());
+            offsets.push_back(reinterpret_cast<void const*>(static_cast<uintptr_t>(ranges[i].first_index) * sizeof(GLuint)));
+        }
+        glMultiDrawElements(GL_TRIANGLE_STRIP, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(count));
+        return 1;
+    }
+
+    // Program, VAO, texture and layer are usually the same as for the previous mesh; RenderState
+    // skips those calls. `tex0` always samples unit 0 and is set once by the app.
+    void bind(int atlas_layer, bool instanced) const {
+        RenderState& state = RenderState::get();
+        state.useProgram(shader.getID());
+        state.setInt(u_instanced, instanced ? 1 : 0);
+        state.setInt(u_atlas_layer, atlas_layer);
+        if (atlas_layer < 0 && texture_id > 0)
+            state.bindTextureUnit(0, texture_id);
+        state.bindVertexArray(geometry->VAO);
+    }
 };
@@ -0,0 +1,162 @@
+#include "MeshCache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+static_assert(sizeof(MeshCacheHeader) == 64, "MeshCacheHeader layout changed, bump MeshCache::kVersion");
+static_assert(sizeof(vertex) == 8 * sizeof(float), "vertex must stay tightly packed for the mesh cache");
+
+namespace {
+
+const char kMagic[4] = { 'I', 'M', 'S', 'H' };
+
+bool sourceStamp(const std::filesystem::path& source, std::uint64_t& size, std::int64_t& mtime) {
+    std::error_code ec;
+    size = static_cast<std::uint64_t>(std::filesystem::file_size(source, ec));
+    if (ec) return false;
+    auto time = std::filesystem::last_write_time(source, ec);
+    if (ec) return false;
+    mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+bool hashSource(const std::filesystem::path& source, std::uint64_t& hash) {
+    MappedFile src(source);
+    if (!src.isOpen()) return false;
+    hash = MeshCache::hashBytes(src.data(), src.size());
+    return true;
+}
+
+} // namespace
+
+std::filesystem::path MeshCache::cachePathFor(const std::filesystem::path& source) {
+    std::filesystem::path cache = source;
+    cache += ".meshcache";
+    return cache;
+}
+
+std::uint64_t MeshCache::hashBytes(const char* data, std::size_t size) {
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+bool MeshCache::open(const std::filesystem::path& source) {
+    file_.close();
+    header_ = nullptr;
+    vertices_ = nullptr;
+    indices_ = nullptr;
+
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    if (!sourceStamp(source, size, mtime))
+        return false;
+
+    const std::filesystem::path cache = cachePathFor(source);
+    if (!file_.open(cache) || file_.size() < sizeof(MeshCacheHeader)) {
+        file_.close();
+        return false;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+
+    const std::size_t expected = sizeof(MeshCacheHeader)
+        + static_cast<std::size_t>(header.vertex_count) * sizeof(vertex)
+        + static_cast<std::size_t>(header.index_count) * sizeof(GLuint);
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || file_.size() != expected || header.source_size != size) {
+        file_.close();
+        return false;
+    }
+
+    if (header.source_mtime != mtime) {
+        // Touched but maybe not changed: compare content hashes before throwing the cache away.
+        std::uint64_t hash = 0;
+        if (!hashSource(source, hash) || hash != header.source_hash) {
+            file_.close();
+            return false;
+        }
+
+        // Same content: store the new mtime so the next start skips the hash.
+        file_.close();
+        {
+            std::fstream patch(cache, std::ios::in | std::ios::out | std::ios::binary);
+            header.source_mtime = mtime;
+            if (patch) patch.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        if (!file_.open(cache) || file_.size() != expected) {
+            file_.close();
+            return false;
+        }
+    }
+
+    header_ = reinterpret_cast<const MeshCacheHeader*>(file_.data());
+    vertices_ = reinterpret_cast<const vertex*>(file_.data() + sizeof(MeshCacheHeader));
+    indices_ = reinterpret_cast<const GLuint*>(file_.data() + sizeof(MeshCacheHeader)
+        + static_cast<std::size_t>(header_->vertex_count) * sizeof(vertex));
+    return true;
+}
+
+bool MeshCache::write(const std::filesystem::path& source,
+    const std::vector<vertex>& vertices,
+    const std::vector<GLuint>& indices) {
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.vertex_count = static_cast<std::uint32_t>(vertices.size());
+    header.index_count = static_cast<std::uint32_t>(indices.size());
+
+    if (!sourceStamp(source, header.source_size, header.source_mtime) || !hashSource(source, header.source_hash)) {
+        std::cerr << "Mesh cache: can not stat/read source " << source << std::endl;
+        return false;
+    }
+
+    glm::vec3 mn(0.0f), mx(0.0f);
+    if (!vertices.empty()) {
+        mn = mx = vertices[0].position;
+        for (auto const& v : vertices) {
+            mn = glm::min(mn, v.position);
+            mx = glm::max(mx, v.position);
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        header.aabb_min[i] = mn[i];
+        header.aabb_max[i] = mx[i];
+    }
+
+    // Write to a temporary file and rename it, so an interrupted write never leaves a valid-looking cache.
+    const std::filesystem::path cache = cachePathFor(source);
+    std::filesystem::path tmp = cache;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Mesh cache: can not write " << tmp << std::endl;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(vertex)));
+        out.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(GLuint)));
+        if (!out) {
+            std::cerr << "Mesh cache: write failed for " << tmp << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, cache, ec);
+    if (ec) {
+        std::cerr << "Mesh cache: can not replace " << cache << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "assets.hpp"
+#include "MappedFile.hpp"
+
+// Binary mesh cache written next to a source .obj ("<file>.meshcache").
+// Layout: MeshCacheHeader, vertex[vertex_count], GLuint[index_count] (native endianness).
+// Vertices are stored exactly as Model uploads them, so a warm start maps the file and
+// hands the bytes to the GPU without parsing any text.
+struct MeshCacheHeader {
+    char magic[4];                  // "IMSH"
+    std::uint32_t version;
+    std::uint64_t source_size;      // source file size in bytes
+    std::int64_t source_mtime;      // source last_write_time ticks
+    std::uint64_t source_hash;      // FNV-1a 64 of the source bytes
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+    float aabb_min[3];
+    float aabb_max[3];
+};
+
+class MeshCache {
+public:
+    // Bump when the vertex layout or loader conventions (UV flips etc.) change.
+    static constexpr std::uint32_t kVersion = 1;
+
+    static std::filesystem::path cachePathFor(const std::filesystem::path& source);
+
+    // Map the cache of `source` and validate it. Size+mtime match => valid; if only the
+    // mtime moved, the source is rehashed and the cache is kept when the content is the same.
+    bool open(const std::filesystem::path& source);
+
+    // Write (or replace) the cache of `source`. Failures are reported but not fatal.
+    static bool write(const std::filesystem::path& source,
+        const std::vector<vertex>& vertices,
+        const std::vector<GLuint>& indices);
+
+    const vertex* vertices() const { return vertices_; }
+    std::size_t vertexCount() const { return header_ ? header_->vertex_count : 0; }
+    const GLuint* indices() const { return indices_; }
+    std::size_t indexCount() const { return header_ ? header_->index_count : 0; }
+    glm::vec3 aabbMin() const { return glm::vec3(header_->aabb_min[0], header_->aabb_min[1], header_->aabb_min[2]); }
+    glm::vec3 aabbMax() const { return glm::vec3(header_->aabb_max[0], header_->aabb_max[1], header_->aabb_max[2]); }
+
+    static std::uint64_t hashBytes(const char* data, std::size_t size);
+
+private:
+    MappedFile file_;
+    const MeshCacheHeader* header_ = nullptr;
+    const vertex* vertices_ = nullptr;
+    const GLuint* indices_ = nullptr;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "assets.hpp"
+#include "ShaderProgram.hpp"
+#include "RenderState.hpp"
+#include "GeometryArena.hpp"
+
+// Immutable GPU geometry (VAO/VBO/EBO) plus the local AABB, shared by every Mesh/Model copy that
+// draws it. The GL objects are deleted with the last handle, so drop handles while the context is alive.
+// Geometry in the GeometryArena has no buffers of its own: VAO is the arena's, draws start at first_index
+// and add base_vertex, and the slot is given back with the last handle.
+struct MeshGeometry {
+    GLuint VAO{ 0 }, VBO{ 0 }, EBO{ 0 };
+    GLsizei index_count = 0;
+    GLuint first_index = 0;
+    GLint base_vertex = 0;
+    GeometryArena::Slot arena_slot;     // valid only for arena geometry
+
+    // Local-space bounds of the vertices.
+    glm::vec3 aabb_min{ 0.0f };
+    glm::vec3 aabb_max{ 0.0f };
+
+    // CPU copy for placement queries (top of the lamp, centroid, ...); empty unless asked for.
+    std::vector<vertex> vertices;
+
+    // Local bounds known up front (e.g. from the MeshCache header), so the vertices are not scanned.
+    struct Bounds {
+        glm::vec3 min, max;
+    };
+
+    // GL thread: upload the arrays and describe the layout (pos/normal/texcoord) for `shader`'s attributes.
+    MeshGeometry(ShaderProgram const& shader,
+        vertex const* vertex_data, std::size_t vertex_count,
+        GLuint const* index_data, std::size_t index_count,
+        bool keep_vertices = false, std::optional<Bounds> bounds = std::nullopt)
+        : index_count(static_cast<GLsizei>(index_count))
+    {
+        computeBounds(vertex_data, vertex_count, keep_vertices, bounds);
+
+        glCreateVertexArrays(1, &VAO);
+        glObjectLabel(GL_VERTEX_ARRAY, VAO, -1, "MyMeshVAO");
+
+        // Tell OpenGL how vertex data is laid out (pos/normal/texcoord).
+        GLint position_attrib_location = glGetAttribLocation(shader.getID(), "aPos");
+        glVertexArrayAttribFormat(VAO, position_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(vertex, position));
+        glVertexArrayAttribBinding(VAO, position_attrib_location, 0);
+        glEnableVertexArrayAttrib(VAO, position_attrib_location);
+
+        GLint normal_attrib_location = glGetAttribLocation(shader.getID(), "aNorm");
+        glVertexArrayAttribFormat(VAO, normal_attrib_location, 3, GL_FLOAT, GL_FALSE, offsetof(vertex, normal));
+        glVertexArrayAttribBinding(VAO, normal_attrib_location, 0);
+        glEnableVertexArrayAttrib(VAO, normal_attrib_location);
+
+        GLint texture_attrib_location = glGetAttribLocation(shader.getID(), "aTex");
+        glVertexArrayAttribFormat(VAO, texture_attrib_location, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, texcoord));
+        glVertexArrayAttribBinding(VAO, texture_attrib_location, 0);
+        glEnableVertexArrayAttrib(VAO, texture_attrib_location);
+
+        // Upload vertex/index buffers.
+        glCreateBuffers(1, &VBO);
+        glObjectLabel(GL_BUFFER, VBO, -1, "MyMeshVBO");
+        glCreateBuffers(1, &EBO);
+        glObjectLabel(GL_BUFFER, EBO, -1, "MyMeshEBO");
+
+        glNamedBufferData(VBO, vertex_count * sizeof(vertex), vertex_data, GL_STATIC_DRAW);
+        glNamedBufferData(EBO, index_count * sizeof(GLuint), index_data, GL_STATIC_DRAW);
+
+        glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(vertex));
+        glVertexArrayElementBuffer(VAO, EBO);
+    }
+
+    // GL thread: copy the arrays into the arena instead (the arena must accept the mesh's shader).
+    MeshGeometry(GeometryArena& arena,
+        vertex const* vertex_data, std::size_t vertex_count,
+        GLuint const* index_data, std::size_t index_count,
+        bool keep_vertices = false, std::optional<Bounds> bounds = std::nullopt)
+        : index_count(static_cast<GLsizei>(index_count))
+    {
+        computeBounds(vertex_data, vertex_count, keep_vertices, bounds);
+        arena_slot = arena.allocate(vertex_data, vertex_count, index_data, index_count);
+        VAO = arena.vao();
+        first_index = arena_slot.first_index;
+        base_vertex = static_cast<GLint>(arena_slot.first_vertex);
+    }
+
+    MeshGeometry(const MeshGeometry&) = delete;
+    MeshGeometry& operator=(const MeshGeometry&) = delete;
+
+    bool inArena() const { return arena_slot.valid(); }
+
+    // Byte offset of the first index, for glDraw*Elements*.
+    void const* indexOffset() const {
+        return reinterpret_cast<void const*>(static_cast<uintptr_t>(first_index) * sizeof(GLuint));
+    }
+
+    ~MeshGeometry() {
+        if (inArena()) {
+            GeometryArena::get().release(arena_slot);
+            return;
+        }
+        RenderState::get().forgetVertexArray(VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+private:
+    void computeBounds(vertex const* vertex_data, std::size_t vertex_count, bool keep_vertices, std::optional<Bounds> const& bounds) {
+        if (bounds) {
+            aabb_min = bounds->min;
+            aabb_max = bounds->max;
+        }
+        else if (vertex_count > 0) {
+            aabb_min = aabb_max = vertex_data[0].position;
+            for (std::size_t i = 1; i < vertex_count; ++i) {
+                aabb_min = glm::min(aabb_min, vertex_data[i].position);
+                aabb_max = glm::max(aabb_max, vertex_data[i].position);
+            }
+        }
+        if (keep_vertices)
+            vertices.assign(vertex_data, vertex_data + vertex_count);
+    }
+};
+using GeometryHandle = std::shared_ptr<const MeshGeometry>;
+
+// Geometry by source path, so loading the same file again reuses the GPU buffers. Entries are weak:
+// the geometry goes away with its last user. GL thread only.
+class MeshRegistry {
+public:
+    static MeshRegistry& get() {
+        static MeshRegistry registry;
+        return registry;
+    }
+
+    // Live geometry for `key`, or null.
+    GeometryHandle find(const std::string& key) {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return nullptr;
+        if (auto geometry = it->second.lock()) {
+            ++hits_;
+            return geometry;
+        }
+        entries_.erase(it);
+        return nullptr;
+    }
+
+    void add(const std::string& key, GeometryHandle const& geometry) {
+        entries_[key] = geometry;
+    }
+
+    std::size_t hits() const { return hits_; }
+
+private:
+    std::unordered_map<std::string, std::weak_ptr<const MeshGeometry>> entries_;
+    std::size_t hits_ = 0;
+};
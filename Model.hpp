@@ -1,19 +1,42 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
 
 #include "assets.hpp"
 #include "Mesh.hpp"
+#include "MeshGeometry.hpp"
 #include "ShaderProgram.hpp"
 #include "OBJloader.hpp"
+#include "MeshCache.hpp"
+#include "StartupProfile.hpp"
+
+struct CachedTexture;
+
+// CPU-side mesh as Model uploads it (interleaved vertices + triangle indices).
+struct MeshData {
+    std::vector<vertex> vertices;
+    std::vector<GLuint> indices;
+
+    // Warm start: the mapped cache file instead of the vectors (left empty). Its arrays go to the GPU
+    // straight from the mapping and its header has the bounds.
+    std::shared_ptr<const MeshCache> cache;
+
+    vertex const* vertexData() const { return cache ? cache->vertices() : vertices.data(); }
+    std::size_t vertexCount() const { return cache ? cache->vertexCount() : vertices.size(); }
+    GLuint const* indexData() const { return cache ? cache->indices() : indices.data(); }
+    std::size_t indexCount() const { return cache ? cache->indexCount() : indices.size(); }
+};
 
 class Model {
 public:
-    // Model = a container of one or more meshes + a shared transform.
-    std::vector<Mesh> meshes;
+    // Model = one or more meshes + a per-copy transform. The mesh list is immutable and shared, so
+    // copying a Model (projectiles, mini lamp, ...) copies handles only and allocates nothing.
+    using MeshList = std::vector<Mesh>;
+    std::shared_ptr<const MeshList> meshes;
     std::string name;
 
     glm::vec3 origin{ 0.0 };
@@ -25,10 +48,11 @@ public:
     glm::mat3 normal_matrix{};      // derived from model_matrix for lighting
 
     GLuint texture_id{ 0 };
+    int atlas_layer{ -1 };                          // layer of the atlas texture array, -1 = own texture
+    std::shared_ptr<CachedTexture> texture_ref;    // keeps a shared (TextureCache) texture alive, may be null
     ShaderProgram shader;
-    std::vector<vertex> vertices{};
 
-    // Simple physics helpers (used by flyghtpath()).
+    // Initial physics state (Scene::Body takes it over, e.g. for thrown rocks).
     glm::vec3 velocity;
     glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
 
@@ -49,15 +73,57 @@ public:
     {
     }
 
-    // Load an OBJ, build vertices/indices, and create a single mesh for rendering.
-    Model(const std::filesystem::path& filename, ShaderProgram shader, GLuint const texture_id = 0) {
+    // Load a mesh (binary cache if valid, else OBJ parse + cache write) and create a single mesh for rendering.
+    // keep_vertices: also keep a CPU copy of the vertices for placement queries (vertices()).
+    Model(const std::filesystem::path& filename, ShaderProgram shader, GLuint const texture_id = 0, bool keep_vertices = false) {
+        MeshData data;
+        if (loadMeshData(filename, data))
+            upload(std::move(data), shader, texture_id, keep_vertices);
+    }
+
+    // Create the GL mesh from data loaded earlier (e.g. by an AssetLoader worker). GL thread only.
+    Model(MeshData data, ShaderProgram shader, GLuint const texture_id = 0, bool keep_vertices = false) {
+        upload(std::move(data), shader, texture_id, keep_vertices);
+    }
+
+    // Reuse geometry that is already on the GPU (MeshRegistry).
+    Model(GeometryHandle geometry, ShaderProgram shader, GLuint const texture_id = 0) {
+        if (geometry)
+            meshes = std::make_shared<const MeshList>(MeshList{ Mesh(GL_TRIANGLES, shader, std::move(geometry), origin, orientation, texture_id) });
+    }
+
+    // Geometry of the first mesh (what MeshRegistry shares), may be null.
+    GeometryHandle geometry() const {
+        return (meshes && !meshes->empty()) ? meshes->front().geometry : nullptr;
+    }
+
+    // Local-space vertices kept for placement queries (empty unless loaded with keep_vertices).
+    std::vector<vertex> const& vertices() const {
+        static const std::vector<vertex> none;
+        GeometryHandle g = geometry();
+        return g ? g->vertices : none;
+    }
+
+    // CPU half of loading: no GL calls, so it can run on worker threads.
+    static bool loadMeshData(const std::filesystem::path& filename, MeshData& data) {
+        StartupProfile::Scope timing(StartupProfile::get(), "mesh " + filename.string());
+
+        // Warm path: keep the memory-mapped cache, upload() reads the arrays from it.
+        auto cache = std::make_shared<MeshCache>();
+        if (cache->open(filename)) {
+            timing.note = "cache";
+            data.cache = std::move(cache);
+            return true;
+        }
+
         std::vector<glm::vec3> positions;
         std::vector<glm::vec2> texcoords;
         std::vector<glm::vec3> normals;
 
-        if (!loadOBJ(filename.string().c_str(), positions, texcoords, normals)) {
+        if (!loadOBJ(filename.string().c_str(), positions, texcoords, normals, data.indices)) {
             std::cerr << "Failed to load OBJ file: " << filename << std::endl;
-            return;
+            timing.note = "failed";
+            return false;
         }
 
         // Flip UVs to match the texture coordinate convention used in this project.
@@ -66,46 +132,18 @@ public:
             tex.y = 1.0f - tex.y;
         }
 
+        data.vertices.reserve(positions.size());
         for (size_t i = 0; i < positions.size(); ++i) {
             vertex v;
             v.position = positions[i];
             v.normal = (i < normals.size()) ? normals[i] : glm::vec3(0.0f);
             v.texcoord = (i < texcoords.size()) ? texcoords[i] : glm::vec2(0.0f);
-            vertices.push_back(v);
-        }
-
-        // Simple 1:1 indexing (no vertex dedup).
-        std::vector<GLuint> indices(vertices.size());
-        for (GLuint i = 0; i < indices.size(); ++i) {
-            indices[i] = i;
+            data.vertices.push_back(v);
         }
 
-        Mesh Mesh(GL_TRIANGLES, shader, vertices, indices, origin, orientation, texture_id);
-        meshes.push_back(std::move(Mesh));
-    }
-
-    // Move the model on a horizontal circle and rotate it to face the travel direction.
-    float angle = 0.0f;
-    void circlepath(float delta_t, float height, float radius = 70.0f, float angular_speed = 0.2f) {
-        angle += angular_speed * delta_t;
-
-        if (angle > glm::two_pi<float>())
-            angle -= glm::two_pi<float>();
-
-        origin.x = radius * cos(angle);
-        origin.z = radius * sin(angle);
-        origin.y = height + 20.0f;
-
-        float yaw = angle + glm::half_pi<float>();
-        orientation.y = -yaw + 0.95f;
-    }
-
-    // Apply gravity + input to update the model position (rough "flight" movement).
-    void flyghtpath(float delta_t, glm::vec3 input) {
-        velocity += gravity * delta_t;
-        origin.x += input.x + velocity.x * delta_t;
-        origin.y += velocity.y * delta_t;
-        origin.z += velocity.z * delta_t;
+        MeshCache::write(filename, data.vertices, data.indices);
+        timing.note = "parsed";
+        return true;
     }
 
     // Draw model with base transform + optional per-draw offset/rotation/scale.
@@ -131,15 +169,17 @@ public:
         model_matrix = local_model_matrix * m_s * m_rz * m_ry * m_rx * m_off;
         normal_matrix = glm::mat3(glm::inverseTranspose(model_matrix));
 
-        for (auto& mesh : meshes) {
-            mesh.draw(model_matrix);
+        if (!meshes) return;
+        for (auto const& mesh : *meshes) {
+            mesh.draw(model_matrix, atlas_layer);
         }
     }
 
     // Draw model with an external matrix (useful for parent-child transforms).
     void draw(glm::mat4 const& model_matrix) {
-        for (auto& mesh : meshes) {
-            mesh.draw(local_model_matrix * model_matrix);
+        if (!meshes) return;
+        for (auto const& mesh : *meshes) {
+            mesh.draw(local_model_matrix * model_matrix, atlas_layer);
         }
     }
 
@@ -149,24 +189,19 @@ public:
     glm::vec3 aabb_min_local{ 0.0f };
     glm::vec3 aabb_max_local{ 0.0f };
 
-    // Compute local-space AABB from current vertex list.
+    // Local-space AABB over all meshes (the bounds are computed once, when the geometry is uploaded).
     void computeAABB() {
-        if (vertices.empty()) {
-            aabb_min_local = glm::vec3(0.0f);
-            aabb_max_local = glm::vec3(0.0f);
-            return;
-        }
-
-        glm::vec3 mn = vertices[0].position;
-        glm::vec3 mx = vertices[0].position;
-
-        for (auto const& v : vertices) {
-            mn = glm::min(mn, v.position);
-            mx = glm::max(mx, v.position);
+        aabb_min_local = glm::vec3(0.0f);
+        aabb_max_local = glm::vec3(0.0f);
+        if (!meshes) return;
+
+        bool first = true;
+        for (auto const& mesh : *meshes) {
+            if (!mesh.geometry) continue;
+            aabb_min_local = first ? mesh.geometry->aabb_min : glm::min(aabb_min_local, mesh.geometry->aabb_min);
+            aabb_max_local = first ? mesh.geometry->aabb_max : glm::max(aabb_max_local, mesh.geometry->aabb_max);
+            first = false;
         }
-
-        aabb_min_local = mn;
-        aabb_max_local = mx;
     }
 
     // Get world-space AABB from origin + scaled local bounds.
@@ -191,4 +226,22 @@ public:
         float dist2 = glm::dot(closest - center, closest - center);
         return dist2 <= radius * radius;
     }
+
+private:
+    // Upload one mesh (into the GeometryArena when it serves this shader); with keep_vertices its geometry
+    // keeps the vertices for placement queries.
+    void upload(MeshData&& data, ShaderProgram shader, GLuint const texture_id, bool keep_vertices) {
+        if (data.vertexCount() == 0)
+            return;
+        std::optional<MeshGeometry::Bounds> bounds;
+        if (data.cache)
+            bounds = MeshGeometry::Bounds{ data.cache->aabbMin(), data.cache->aabbMax() };
+        GeometryArena& arena = GeometryArena::get();
+        auto geometry = arena.accepts(shader)
+            ? std::make_shared<const MeshGeometry>(arena, data.vertexData(), data.vertexCount(),
+                data.indexData(), data.indexCount(), keep_vertices, bounds)
+            : std::make_shared<const MeshGeometry>(shader, data.vertexData(), data.vertexCount(),
+                data.indexData(), data.indexCount(), keep_vertices, bounds);
+        meshes = std::make_shared<const MeshList>(MeshList{ Mesh(GL_TRIANGLES, shader, std::move(geometry), origin, orientation, texture_id) });
+    }
 };
@@ -5,171 +5,499 @@
 //  f v/vt/vn ...
 // and polygons (triangulates n-gons). Handles negative indices.
 //
-// Rewritten to use std::getline + token parsing instead of fscanf_s so
-// it accepts varied face formats.
-#include <string>
+// The file is memory-mapped and parsed in place with a small hand-written
+// int/float scanner, so there is no per-line stream or string allocation
+// (the old getline + istringstream + std::stoi path dominated startup).
+// Large files are split at line boundaries and parsed by several threads.
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string_view>
+#include <thread>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <iostream>
 #include <glm/glm.hpp>
 
 #include "OBJloader.hpp"
+#include "MappedFile.hpp"
 
-bool loadOBJ(const char * path, std::vector< glm::vec3 > & out_vertices, std::vector< glm::vec2 > & out_uvs, std::vector< glm::vec3 > & out_normals)
-{
-    out_vertices.clear();
-    out_uvs.clear();
-    out_normals.clear();
+namespace {
 
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        std::cerr << "Impossible to open the file: " << path << std::endl;
+// One face corner with resolved 1-based indices into the temp arrays (0 = not present).
+struct ObjCorner {
+    int v = 0;
+    int vt = 0;
+    int vn = 0;
+};
+
+// Raw OBJ contents: attribute pools + triangulated corners (3 per triangle).
+struct ObjData {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;
+};
+
+// Corner whose indices were negative (relative) and got resolved against its chunk's own pools.
+// `fields` bits: 1 = v, 2 = vt, 4 = vn. The merge adds the chunk's base offsets to those fields.
+struct ObjFixup {
+    std::size_t corner;
+    unsigned char fields;
+};
+
+// Files smaller than this are parsed on the calling thread, the thread start-up is not worth it.
+constexpr std::size_t kMinParallelBytes = 512 * 1024;
+// Keep chunks big enough that the per-chunk merge stays negligible.
+constexpr std::size_t kMinChunkBytes = 128 * 1024;
+
+std::atomic<unsigned int> g_parse_threads{ 0 };
+
+//------ In-place scanner ------
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10u; }
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+inline const char* findLineEnd(const char* p, const char* end) {
+    if (p >= end) return end;
+    const void* nl = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+// Prefix keyword must be followed by whitespace or end of line (same as `ss >> prefix`).
+inline bool endsToken(const char* p, const char* end) {
+    return p >= end || isBlank(*p);
+}
+
+bool scanInt(const char*& p, const char* end, int& out) {
+    const char* s = p;
+    bool neg = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        neg = (*s == '-');
+        ++s;
+    }
+    if (s >= end || !isDigit(*s))
         return false;
+
+    int value = 0;
+    while (s < end && isDigit(*s)) {
+        value = value * 10 + (*s - '0');
+        ++s;
+    }
+    out = neg ? -value : value;
+    p = s;
+    return true;
+}
+
+bool scanFloat(const char*& p, const char* end, float& out) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* s = p;
+    bool neg = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        neg = (*s == '-');
+        ++s;
+    }
+
+    // Accumulate up to 19 significant digits; extra digits only shift the exponent.
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+
+    while (s < end && isDigit(*s)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*s - '0');
+            if (mantissa) ++digits;
+        }
+        else {
+            ++exponent;
+        }
+        any = true;
+        ++s;
+    }
+    if (s < end && *s == '.') {
+        ++s;
+        while (s < end && isDigit(*s)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*s - '0');
+                if (mantissa) ++digits;
+                --exponent;
+            }
+            any = true;
+            ++s;
+        }
     }
+    if (!any)
+        return false;
 
-    std::vector<glm::vec3> temp_vertices;
-    std::vector<glm::vec2> temp_uvs;
-    std::vector<glm::vec3> temp_normals;
-
-    // Indices in OBJ are 1-based. We'll collect final indexed lists by unrolling.
-    std::vector<unsigned int> vertexIndices;
-    std::vector<unsigned int> uvIndices;
-    std::vector<unsigned int> normalIndices;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        std::istringstream ss(line);
-        std::string prefix;
-        ss >> prefix;
-        if (prefix == "v") {
-            glm::vec3 v;
-            ss >> v.x >> v.y >> v.z;
-            temp_vertices.push_back(v);
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char* e = s + 1;
+        int exp_value = 0;
+        if (scanInt(e, end, exp_value)) {
+            exponent += exp_value;
+            s = e;
         }
-        else if (prefix == "vt") {
-            glm::vec2 uv;
-            ss >> uv.x >> uv.y;
-            // flip V for OpenGL like before
-            uv.y = 1.0f - uv.y;
-            temp_uvs.push_back(uv);
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0)
+        value = (exponent >= -22) ? value / pow10[-exponent] : value * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        value = (exponent <= 22) ? value * pow10[exponent] : value * std::pow(10.0, exponent);
+
+    out = static_cast<float>(neg ? -value : value);
+    p = s;
+    return true;
+}
+
+// Read up to N floats from the rest of the line; missing values stay 0.
+template <int N>
+void scanFloats(const char* p, const char* end, float (&out)[N]) {
+    for (int i = 0; i < N; ++i) {
+        out[i] = 0.0f;
+    }
+    for (int i = 0; i < N; ++i) {
+        p = skipBlanks(p, end);
+        if (!scanFloat(p, end, out[i])) {
+            out[i] = 0.0f;
+            return;
         }
-        else if (prefix == "vn") {
-            glm::vec3 n;
-            ss >> n.x >> n.y >> n.z;
-            temp_normals.push_back(n);
+    }
+}
+
+// Parse [p, end) into attribute pools and triangulated corners. Negative indices are resolved
+// against the pools of `out` and reported in `fixups` (only matters when `out` is one chunk of a file).
+void parseOBJ(const char* p, const char* end, ObjData& out, std::vector<ObjFixup>& fixups) {
+    std::vector<ObjCorner> face; // reused for every face, so it allocates only when a bigger n-gon shows up
+    face.reserve(16);
+
+    std::vector<unsigned char> relative; // per face corner: which indices were negative
+    relative.reserve(16);
+
+    // convert negative indices to positive (relative to current temp arrays)
+    auto fix = [](int idx, std::size_t size, unsigned char bit, unsigned char& rel) -> int {
+        if (idx < 0) {
+            rel |= bit;
+            return static_cast<int>(size) + idx + 1;
         }
-        else if (prefix == "f") {
-            // read all face tokens (supports triangles, quads, ngons)
-            std::vector<std::string> tokens;
-            std::string tok;
-            while (ss >> tok) tokens.push_back(tok);
-            if (tokens.size() < 3) {
-                // invalid face
-                std::cerr << "Face with fewer than 3 vertices: \"" << line << "\"" << std::endl;
-                continue;
+        return idx;
+    };
+
+    while (p < end) {
+        p = skipBlanks(p, end);
+        const char* line_end = findLineEnd(p, end);
+
+        if (p < line_end) {
+            const char c0 = p[0];
+            if (c0 == 'v' && endsToken(p + 1, line_end)) {
+                float xyz[3];
+                scanFloats(p + 1, line_end, xyz);
+                out.positions.emplace_back(xyz[0], xyz[1], xyz[2]);
+            }
+            else if (c0 == 'v' && p + 1 < line_end && p[1] == 't' && endsToken(p + 2, line_end)) {
+                float uv[2];
+                scanFloats(p + 2, line_end, uv);
+                // flip V for OpenGL like before
+                out.uvs.emplace_back(uv[0], 1.0f - uv[1]);
+            }
+            else if (c0 == 'v' && p + 1 < line_end && p[1] == 'n' && endsToken(p + 2, line_end)) {
+                float xyz[3];
+                scanFloats(p + 2, line_end, xyz);
+                out.normals.emplace_back(xyz[0], xyz[1], xyz[2]);
             }
+            else if (c0 == 'f' && endsToken(p + 1, line_end)) {
+                // read all face tokens (supports triangles, quads, ngons)
+                face.clear();
+                relative.clear();
+                const char* q = p + 1;
+                for (;;) {
+                    q = skipBlanks(q, line_end);
+                    ObjCorner c;
+                    // token can be: v, v/vt, v//vn, v/vt/vn
+                    if (q >= line_end || !scanInt(q, line_end, c.v))
+                        break;
+                    if (q < line_end && *q == '/') {
+                        ++q;
+                        if (q < line_end && *q != '/')
+                            scanInt(q, line_end, c.vt); // empty means missing vt (v//vn)
+                        if (q < line_end && *q == '/') {
+                            ++q;
+                            scanInt(q, line_end, c.vn);
+                        }
+                    }
+                    while (q < line_end && !isBlank(*q)) ++q;
+
+                    unsigned char rel = 0;
+                    c.v = fix(c.v, out.positions.size(), 1, rel);
+                    c.vt = fix(c.vt, out.uvs.size(), 2, rel);
+                    c.vn = fix(c.vn, out.normals.size(), 4, rel);
+                    face.push_back(c);
+                    relative.push_back(rel);
+                }
 
-            // parse tokens into per-face index arrays
-            std::vector<int> f_v, f_vt, f_vn;
-            f_v.reserve(tokens.size());
-            f_vt.reserve(tokens.size());
-            f_vn.reserve(tokens.size());
-
-            for (auto &t : tokens) {
-                int vi = 0, vti = 0, vni = 0;
-                // token can be: v, v/vt, v//vn, v/vt/vn
-                size_t p1 = t.find('/');
-                if (p1 == std::string::npos) {
-                    // only vertex index
-                    vi = std::stoi(t);
+                if (face.size() < 3) {
+                    // invalid face
+                    std::cerr << "Face with fewer than 3 vertices: \""
+                        << std::string_view(p, static_cast<std::size_t>(line_end - p)) << "\"" << std::endl;
                 }
                 else {
-                    std::string a = t.substr(0, p1);
-                    size_t p2 = t.find('/', p1 + 1);
-                    if (p2 == std::string::npos) {
-                        // form v/vt
-                        if (!a.empty()) vi = std::stoi(a);
-                        std::string b = t.substr(p1 + 1);
-                        if (!b.empty()) vti = std::stoi(b);
-                    }
-                    else {
-                        // form v//vn or v/vt/vn
-                        std::string b = t.substr(p1 + 1, p2 - p1 - 1);
-                        std::string c = t.substr(p2 + 1);
-                        if (!a.empty()) vi = std::stoi(a);
-                        if (!b.empty()) vti = std::stoi(b); // empty means missing vt (v//vn)
-                        if (!c.empty()) vni = std::stoi(c);
+                    // triangulate polygon using fan (0, i, i+1)
+                    for (std::size_t i = 1; i + 1 < face.size(); ++i) {
+                        for (std::size_t k : { std::size_t(0), i, i + 1 }) {
+                            if (relative[k]) fixups.push_back({ out.corners.size(), relative[k] });
+                            out.corners.push_back(face[k]);
+                        }
                     }
                 }
-
-                // convert negative indices to positive (relative to current temp arrays)
-                auto fix = [](int idx, size_t size)->int {
-                    if (idx < 0) return static_cast<int>(size) + idx + 1;
-                    return idx;
-                };
-                if (vi != 0) f_v.push_back(fix(vi, temp_vertices.size()));
-                else f_v.push_back(0);
-                if (vti != 0) f_vt.push_back(fix(vti, temp_uvs.size()));
-                else f_vt.push_back(0);
-                if (vni != 0) f_vn.push_back(fix(vni, temp_normals.size()));
-                else f_vn.push_back(0);
             }
+            // ignore other prefixes
+        }
 
-            // triangulate polygon using fan (0, i, i+1)
-            for (size_t i = 1; i + 1 < f_v.size(); ++i) {
-                // vertex indices
-                vertexIndices.push_back(static_cast<unsigned int>(f_v[0]));
-                vertexIndices.push_back(static_cast<unsigned int>(f_v[i]));
-                vertexIndices.push_back(static_cast<unsigned int>(f_v[i+1]));
-
-                // uv indices (may be 0)
-                uvIndices.push_back(static_cast<unsigned int>(f_vt[0]));
-                uvIndices.push_back(static_cast<unsigned int>(f_vt[i]));
-                uvIndices.push_back(static_cast<unsigned int>(f_vt[i+1]));
-
-                // normal indices (may be 0)
-                normalIndices.push_back(static_cast<unsigned int>(f_vn[0]));
-                normalIndices.push_back(static_cast<unsigned int>(f_vn[i]));
-                normalIndices.push_back(static_cast<unsigned int>(f_vn[i+1]));
-            }
+        p = line_end + 1;
+    }
+}
+
+unsigned int parseThreadCount() {
+    unsigned int n = g_parse_threads.load(std::memory_order_relaxed);
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+    return n;
+}
+
+// Split [begin, end) into up to `count` pieces that all start at the beginning of a line.
+std::vector<const char*> splitAtLines(const char* begin, const char* end, unsigned int count) {
+    std::vector<const char*> cuts{ begin };
+    const std::size_t size = static_cast<std::size_t>(end - begin);
+    for (unsigned int i = 1; i < count; ++i) {
+        const char* p = begin + size * i / count;
+        if (p <= cuts.back()) continue;
+        p = findLineEnd(p, end);
+        if (p < end) ++p;
+        if (p > cuts.back() && p < end) cuts.push_back(p);
+    }
+    cuts.push_back(end);
+    return cuts;
+}
+
+// Parse chunks on worker threads, then concatenate them. Positive indices are already absolute;
+// corners listed in a chunk's fixups get that chunk's base offsets added.
+void parseOBJParallel(const char* begin, const char* end, unsigned int threads, ObjData& obj) {
+    const std::vector<const char*> cuts = splitAtLines(begin, end, threads);
+    const std::size_t chunk_count = cuts.size() - 1;
+
+    std::vector<ObjData> chunks(chunk_count);
+    std::vector<std::vector<ObjFixup>> fixups(chunk_count);
+    {
+        std::vector<std::thread> workers;
+        workers.reserve(chunk_count - 1);
+        for (std::size_t i = 1; i < chunk_count; ++i)
+            workers.emplace_back([&, i] { parseOBJ(cuts[i], cuts[i + 1], chunks[i], fixups[i]); });
+        parseOBJ(cuts[0], cuts[1], chunks[0], fixups[0]);
+        for (auto& w : workers) w.join();
+    }
+
+    // Prefix sums: where each chunk lands in the merged arrays.
+    struct Base { std::size_t v = 0, vt = 0, vn = 0, corner = 0; };
+    std::vector<Base> base(chunk_count + 1);
+    for (std::size_t i = 0; i < chunk_count; ++i) {
+        base[i + 1].v = base[i].v + chunks[i].positions.size();
+        base[i + 1].vt = base[i].vt + chunks[i].uvs.size();
+        base[i + 1].vn = base[i].vn + chunks[i].normals.size();
+        base[i + 1].corner = base[i].corner + chunks[i].corners.size();
+    }
+    obj.positions.resize(base[chunk_count].v);
+    obj.uvs.resize(base[chunk_count].vt);
+    obj.normals.resize(base[chunk_count].vn);
+    obj.corners.resize(base[chunk_count].corner);
+
+    // The copies are disjoint, so the merge runs in parallel as well.
+    auto merge = [&](std::size_t i) {
+        const ObjData& c = chunks[i];
+        const Base& b = base[i];
+        std::copy(c.positions.begin(), c.positions.end(), obj.positions.begin() + b.v);
+        std::copy(c.uvs.begin(), c.uvs.end(), obj.uvs.begin() + b.vt);
+        std::copy(c.normals.begin(), c.normals.end(), obj.normals.begin() + b.vn);
+        std::copy(c.corners.begin(), c.corners.end(), obj.corners.begin() + b.corner);
+        for (const ObjFixup& f : fixups[i]) {
+            ObjCorner& corner = obj.corners[b.corner + f.corner];
+            if (f.fields & 1) corner.v += static_cast<int>(b.v);
+            if (f.fields & 2) corner.vt += static_cast<int>(b.vt);
+            if (f.fields & 4) corner.vn += static_cast<int>(b.vn);
         }
-        // ignore other prefixes
+        chunks[i] = ObjData();
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(chunk_count - 1);
+    for (std::size_t i = 1; i < chunk_count; ++i)
+        workers.emplace_back(merge, i);
+    merge(0);
+    for (auto& w : workers) w.join();
+}
+
+// Map + parse `path`; false if the file can not be opened.
+bool parseOBJFile(const char* path, ObjData& obj) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "Impossible to open the file: " << path << std::endl;
+        return false;
     }
 
-    // Unroll indices into direct arrays (matching previous behavior)
-    for (size_t i = 0; i < vertexIndices.size(); ++i) {
-        unsigned int vi = vertexIndices[i];
-        if (vi == 0 || vi > temp_vertices.size()) {
-            std::cerr << "Vertex index out of range in OBJ: " << vi << std::endl;
-            return false;
+    const unsigned int threads = static_cast<unsigned int>(
+        std::min<std::size_t>(parseThreadCount(), std::max<std::size_t>(1, file.size() / kMinChunkBytes)));
+    if (threads > 1 && file.size() >= kMinParallelBytes) {
+        parseOBJParallel(file.begin(), file.end(), threads, obj);
+    }
+    else {
+        std::vector<ObjFixup> fixups; // single chunk: already absolute
+        parseOBJ(file.begin(), file.end(), obj, fixups);
+    }
+    return true;
+}
+
+// Validate a corner: the position must exist; missing or out-of-range uv/normal references become 0.
+bool sanitizeCorner(ObjCorner& c, const ObjData& obj) {
+    if (c.v <= 0 || static_cast<std::size_t>(c.v) > obj.positions.size()) {
+        std::cerr << "Vertex index out of range in OBJ: " << c.v << std::endl;
+        return false;
+    }
+    if (c.vt < 0 || static_cast<std::size_t>(c.vt) > obj.uvs.size()) c.vt = 0;
+    if (c.vn < 0 || static_cast<std::size_t>(c.vn) > obj.normals.size()) c.vn = 0;
+    return true;
+}
+
+// Open-addressing map from a (v, vt, vn) triple to its output vertex index.
+class CornerIndexMap {
+public:
+    explicit CornerIndexMap(std::size_t expected) {
+        std::size_t capacity = 16;
+        while (capacity < expected * 2) capacity <<= 1;
+        slots_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    // Returns the index stored for `c`, or inserts `next_index` and returns it.
+    unsigned int findOrInsert(const ObjCorner& c, unsigned int next_index) {
+        if ((size_ + 1) * 2 > slots_.size())
+            grow();
+
+        Slot& s = probe(c);
+        if (s.index == kEmpty) {
+            s.key = c;
+            s.index = next_index;
+            ++size_;
         }
-        glm::vec3 vertex = temp_vertices[vi - 1];
-        out_vertices.push_back(vertex);
-
-        unsigned int uvi = (i < uvIndices.size()) ? uvIndices[i] : 0;
-        if (uvi != 0) {
-            if (uvi > temp_uvs.size()) {
-                // missing uv index referenced
-                out_uvs.push_back(glm::vec2(0.0f, 0.0f));
-            } else {
-                out_uvs.push_back(temp_uvs[uvi - 1]);
-            }
-        } else {
-            out_uvs.push_back(glm::vec2(0.0f, 0.0f));
+        return s.index;
+    }
+
+private:
+    static constexpr unsigned int kEmpty = ~0u;
+    struct Slot {
+        ObjCorner key;
+        unsigned int index = kEmpty;
+    };
+
+    static std::size_t hash(const ObjCorner& c) {
+        std::uint64_t h = static_cast<std::uint32_t>(c.v) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<std::uint32_t>(c.vt) * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+        h ^= static_cast<std::uint32_t>(c.vn) * 0x165667B19E3779F9ull + (h >> 32);
+        return static_cast<std::size_t>(h ^ (h >> 31));
+    }
+
+    // Slot holding `c`, or the empty slot where it belongs (load factor stays <= 1/2).
+    Slot& probe(const ObjCorner& c) {
+        std::size_t i = hash(c) & mask_;
+        for (;;) {
+            Slot& s = slots_[i];
+            if (s.index == kEmpty || (s.key.v == c.v && s.key.vt == c.vt && s.key.vn == c.vn))
+                return s;
+            i = (i + 1) & mask_;
         }
+    }
 
-        unsigned int ni = (i < normalIndices.size()) ? normalIndices[i] : 0;
-        if (ni != 0) {
-            if (ni > temp_normals.size()) {
-                out_normals.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
-            } else {
-                out_normals.push_back(temp_normals[ni - 1]);
-            }
-        } else {
-            out_normals.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+    void grow() {
+        std::vector<Slot> old(slots_.size() * 2);
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        for (const Slot& s : old) {
+            if (s.index != kEmpty)
+                probe(s.key) = s;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+};
+
+} // namespace
+
+void setOBJLoaderThreads(unsigned int threads)
+{
+    g_parse_threads.store(threads, std::memory_order_relaxed);
+}
+
+bool loadOBJ(const char * path, std::vector< glm::vec3 > & out_vertices, std::vector< glm::vec2 > & out_uvs, std::vector< glm::vec3 > & out_normals)
+{
+    out_vertices.clear();
+    out_uvs.clear();
+    out_normals.clear();
+
+    ObjData obj;
+    if (!parseOBJFile(path, obj))
+        return false;
+
+    // Unroll indices into direct arrays (matching previous behavior)
+    out_vertices.reserve(obj.corners.size());
+    out_uvs.reserve(obj.corners.size());
+    out_normals.reserve(obj.corners.size());
+
+    for (ObjCorner c : obj.corners) {
+        if (!sanitizeCorner(c, obj))
+            return false;
+        out_vertices.push_back(obj.positions[c.v - 1]);
+        out_uvs.push_back(c.vt ? obj.uvs[c.vt - 1] : glm::vec2(0.0f, 0.0f));
+        out_normals.push_back(c.vn ? obj.normals[c.vn - 1] : glm::vec3(0.0f, 0.0f, 0.0f));
+    }
+
+    return true;
+}
+
+bool loadOBJ(const char * path, std::vector< glm::vec3 > & out_vertices, std::vector< glm::vec2 > & out_uvs, std::vector< glm::vec3 > & out_normals, std::vector< unsigned int > & out_indices)
+{
+    out_vertices.clear();
+    out_uvs.clear();
+    out_normals.clear();
+    out_indices.clear();
+
+    ObjData obj;
+    if (!parseOBJFile(path, obj))
+        return false;
+
+    // One output vertex per unique (v, vt, vn) triple; corners keep their face order,
+    // so the index buffer also gets post-transform vertex cache reuse on the GPU.
+    CornerIndexMap unique(obj.positions.size() + obj.corners.size() / 6);
+    out_indices.reserve(obj.corners.size());
+
+    for (ObjCorner c : obj.corners) {
+        if (!sanitizeCorner(c, obj))
+            return false;
+
+        unsigned int next = static_cast<unsigned int>(out_vertices.size());
+        unsigned int index = unique.findOrInsert(c, next);
+        if (index == next) {
+            out_vertices.push_back(obj.positions[c.v - 1]);
+            out_uvs.push_back(c.vt ? obj.uvs[c.vt - 1] : glm::vec2(0.0f, 0.0f));
+            out_normals.push_back(c.vn ? obj.normals[c.vn - 1] : glm::vec3(0.0f, 0.0f, 0.0f));
         }
+        out_indices.push_back(index);
     }
 
     return true;
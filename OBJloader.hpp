@@ -12,4 +12,17 @@ bool loadOBJ(
 	std::vector < glm::vec3 > & out_normals
 );
 
+// Indexed variant: one vertex per unique (v, vt, vn) triple plus a triangle index list.
+bool loadOBJ(
+	const char * path,
+	std::vector < glm::vec3 > & out_vertices,
+	std::vector < glm::vec2 > & out_uvs,
+	std::vector < glm::vec3 > & out_normals,
+	std::vector < unsigned int > & out_indices
+);
+
+// Worker threads for parsing large files (0 = std::thread::hardware_concurrency(), the default).
+// Small files are always parsed on the calling thread.
+void setOBJLoaderThreads(unsigned int threads);
+
 #endif
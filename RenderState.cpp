@@ -0,0 +1,75 @@
+#include "RenderState.hpp"
+
+void RenderState::useProgram(GLuint program) {
+    if (program == program_) {
+        ++stats_.elided_programs;
+        return;
+    }
+    glUseProgram(program);
+    program_ = program;
+    ++stats_.issued;
+}
+
+void RenderState::bindVertexArray(GLuint vao) {
+    if (vao == vertex_array_) {
+        ++stats_.elided_vertex_arrays;
+        return;
+    }
+    glBindVertexArray(vao);
+    vertex_array_ = vao;
+    ++stats_.issued;
+}
+
+void RenderState::bindTextureUnit(GLuint unit, GLuint texture) {
+    if (unit < kMaxTextureUnits) {
+        if (textures_[unit] == texture) {
+            ++stats_.elided_textures;
+            return;
+        }
+        textures_[unit] = texture;
+    }
+    glBindTextureUnit(unit, texture);
+    ++stats_.issued;
+}
+
+void RenderState::setInt(UniformHandle u, int value) {
+    if (!u.valid() || program_ == kUnknown)
+        return;
+
+    auto [it, inserted] = ints_.try_emplace(uniformKey(program_, u.location), value);
+    if (!inserted) {
+        if (it->second == value) {
+            ++stats_.elided_uniforms;
+            return;
+        }
+        it->second = value;
+    }
+    glUniform1i(u.location, value);
+    ++stats_.issued;
+}
+
+void RenderState::forgetProgram(GLuint program) {
+    if (program_ == program)
+        program_ = kUnknown;
+    for (auto it = ints_.begin(); it != ints_.end();) {
+        if (static_cast<GLuint>(it->first >> 32) == program) it = ints_.erase(it);
+        else ++it;
+    }
+}
+
+void RenderState::forgetVertexArray(GLuint vao) {
+    if (vertex_array_ == vao)
+        vertex_array_ = kUnknown;
+}
+
+void RenderState::forgetTexture(GLuint texture) {
+    for (auto& bound : textures_)
+        if (bound == texture) bound = kUnknown;
+}
+
+void RenderState::invalidate() {
+    program_ = kUnknown;
+    vertex_array_ = kUnknown;
+    textures_.fill(kUnknown);
+    ints_.clear();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <GL/glew.h>
+
+#include "ShaderProgram.hpp"
+
+// Shadow copy of the GL binding state the renderer touches every draw: the current program, VAO,
+// the texture on each unit and int uniforms (sampler units, atlas layer) per program.
+// Calls that would set what is already set are skipped. GL thread only; every bind of these
+// objects has to go through here (or be followed by invalidate()), otherwise the copy goes stale.
+class RenderState {
+public:
+    static constexpr GLuint kMaxTextureUnits = 32;
+
+    // Calls since the last resetStats(), reported once per second by App::updateFPS().
+    struct Stats {
+        std::uint64_t issued = 0;               // GL calls actually made
+        std::uint64_t elided_programs = 0;      // glUseProgram
+        std::uint64_t elided_vertex_arrays = 0; // glBindVertexArray
+        std::uint64_t elided_textures = 0;      // glBindTextureUnit
+        std::uint64_t elided_uniforms = 0;      // glUniform1i
+
+        std::uint64_t elided() const { return elided_programs + elided_vertex_arrays + elided_textures + elided_uniforms; }
+    };
+
+    static RenderState& get() {
+        static RenderState state;
+        return state;
+    }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindTextureUnit(GLuint unit, GLuint texture);
+
+    // glUniform1i on the current program, skipped when it already holds `value`.
+    void setInt(UniformHandle u, int value);
+
+    // Objects about to be deleted: GL may hand their names out again, so drop them from the copy.
+    void forgetProgram(GLuint program);
+    void forgetVertexArray(GLuint vao);
+    void forgetTexture(GLuint texture);
+
+    // Forget everything (after GL state was changed behind the tracker's back).
+    void invalidate();
+
+    Stats const& stats() const { return stats_; }
+    void resetStats() { stats_ = {}; }
+
+private:
+    RenderState() { invalidate(); }
+
+    static std::uint64_t uniformKey(GLuint program, GLint location) {
+        return (static_cast<std::uint64_t>(program) << 32) | static_cast<std::uint32_t>(location);
+    }
+
+    // ~0u = unknown, so the first bind is always issued (0 is a valid "unbound" state).
+    static constexpr GLuint kUnknown = ~0u;
+
+    GLuint program_ = kUnknown;
+    GLuint vertex_array_ = kUnknown;
+    std::array<GLuint, kMaxTextureUnits> textures_{};
+    std::unordered_map<std::uint64_t, int> ints_;   // (program, location) -> value
+    Stats stats_;
+};
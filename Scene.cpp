@@ -0,0 +1,224 @@
+#include "Scene.hpp"
+
+#include <algorithm>
+#include <glm/ext.hpp>
+
+Scene::Handle Scene::add(Model const& model, std::string const& name, Motion motion) {
+    Model source = model;
+    source.computeAABB();
+
+    Transform transform{ source.origin, source.orientation, source.scale };
+    Render render{ source.meshes, source.texture_ref, source.atlas_layer, source.transparent };
+    Body body{ motion, source.velocity, source.gravity, 0.0f };
+    Bounds bounds{ source.aabb_min_local, source.aabb_max_local, source.solid, SpatialHash::kInvalid };
+
+    if (!name.empty()) {
+        Handle existing = find(name);
+        if (existing.valid()) {
+            std::size_t i = index(existing);
+            bounds.collider = bounds_[i].collider;  // the caller re-syncs the collision grid
+            transforms_[i] = transform;
+            renders_[i] = std::move(render);
+            bodies_[i] = body;
+            bounds_[i] = bounds;
+            return existing;
+        }
+    }
+
+    std::uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    else {
+        slot = static_cast<std::uint32_t>(slot_index_.size());
+        slot_index_.push_back(kNoSlot);
+        slot_generation_.push_back(0);
+        slot_names_.emplace_back();
+    }
+
+    slot_index_[slot] = static_cast<std::uint32_t>(transforms_.size());
+    index_slot_.push_back(slot);
+    transforms_.push_back(transform);
+    renders_.push_back(std::move(render));
+    bodies_.push_back(body);
+    bounds_.push_back(bounds);
+    model_matrices_.push_back(glm::identity<glm::mat4>());
+    normal_matrices_.push_back(glm::identity<glm::mat3>());
+    visible_.push_back(1);      // drawn until the first cull()
+
+    Handle handle{ slot, slot_generation_[slot] };
+    if (!name.empty()) {
+        slot_names_[slot] = name;
+        by_name_.emplace(name, handle);
+    }
+    return handle;
+}
+
+void Scene::remove(Handle handle) {
+    if (!alive(handle))
+        return;
+
+    // Swap the last entity into the gap so the arrays stay dense.
+    const std::size_t i = index(handle);
+    const std::size_t last = size() - 1;
+    if (i != last) {
+        transforms_[i] = transforms_[last];
+        renders_[i] = std::move(renders_[last]);
+        bodies_[i] = bodies_[last];
+        bounds_[i] = bounds_[last];
+        model_matrices_[i] = model_matrices_[last];
+        normal_matrices_[i] = normal_matrices_[last];
+        visible_[i] = visible_[last];
+        index_slot_[i] = index_slot_[last];
+        slot_index_[index_slot_[i]] = static_cast<std::uint32_t>(i);
+    }
+    transforms_.pop_back();
+    renders_.pop_back();
+    bodies_.pop_back();
+    bounds_.pop_back();
+    model_matrices_.pop_back();
+    normal_matrices_.pop_back();
+    visible_.pop_back();
+    index_slot_.pop_back();
+
+    if (!slot_names_[handle.slot].empty()) {
+        by_name_.erase(slot_names_[handle.slot]);
+        slot_names_[handle.slot].clear();
+    }
+    slot_index_[handle.slot] = kNoSlot;
+    ++slot_generation_[handle.slot];
+    free_slots_.push_back(handle.slot);
+}
+
+void Scene::clear() {
+    transforms_.clear();
+    renders_.clear();
+    bodies_.clear();
+    bounds_.clear();
+    model_matrices_.clear();
+    normal_matrices_.clear();
+    world_boxes_.resize(0);
+    visible_.clear();
+    index_slot_.clear();
+    slot_index_.clear();
+    slot_generation_.clear();
+    free_slots_.clear();
+    by_name_.clear();
+    slot_names_.clear();
+}
+
+Scene::Handle Scene::find(std::string const& name) const {
+    auto it = by_name_.find(name);
+    return it != by_name_.end() ? it->second : Handle{};
+}
+
+std::string const& Scene::name(Handle handle) const {
+    static const std::string none;
+    return alive(handle) ? slot_names_[handle.slot] : none;
+}
+
+Model Scene::model(Handle handle) const {
+    Model m;
+    if (!alive(handle))
+        return m;
+
+    const std::size_t i = index(handle);
+    m.meshes = renders_[i].meshes;
+    m.texture_ref = renders_[i].texture_ref;
+    m.atlas_layer = renders_[i].atlas_layer;
+    m.transparent = renders_[i].transparent;
+    m.origin = transforms_[i].origin;
+    m.orientation = transforms_[i].orientation;
+    m.scale = transforms_[i].scale;
+    m.velocity = bodies_[i].velocity;
+    m.gravity = bodies_[i].gravity;
+    m.solid = bounds_[i].solid;
+    m.aabb_min_local = bounds_[i].min_local;
+    m.aabb_max_local = bounds_[i].max_local;
+    m.model_matrix = model_matrices_[i];
+    m.normal_matrix = normal_matrices_[i];
+    return m;
+}
+
+std::pair<glm::vec3, glm::vec3> Scene::worldAABB(std::size_t i) const {
+    Transform const& t = transforms_[i];
+    glm::vec3 a = t.origin + bounds_[i].min_local * t.scale;
+    glm::vec3 b = t.origin + bounds_[i].max_local * t.scale;
+    return { glm::min(a, b), glm::max(a, b) };
+}
+
+void Scene::circle(std::size_t i, float delta_t, float height, float radius, float angular_speed) {
+    Body& body = bodies_[i];
+    Transform& t = transforms_[i];
+
+    body.angle += angular_speed * delta_t;
+    if (body.angle > glm::two_pi<float>())
+        body.angle -= glm::two_pi<float>();
+
+    t.origin.x = radius * cos(body.angle);
+    t.origin.z = radius * sin(body.angle);
+    t.origin.y = height + 20.0f;
+
+    // Face the travel direction.
+    float yaw = body.angle + glm::half_pi<float>();
+    t.orientation.y = -yaw + 0.95f;
+}
+
+void Scene::fly(std::size_t i, float delta_t, glm::vec3 input) {
+    Body& body = bodies_[i];
+    glm::vec3& origin = transforms_[i].origin;
+    body.velocity += body.gravity * delta_t;
+    origin.x += input.x + body.velocity.x * delta_t;
+    origin.y += body.velocity.y * delta_t;
+    origin.z += body.velocity.z * delta_t;
+}
+
+void Scene::updateMatrices(glm::vec3 const& offset, glm::vec3 const& rotation, glm::vec3 const& scale_change) {
+    glm::mat4 m_off = glm::translate(glm::mat4(1.0f), offset);
+    glm::mat4 m_rx = glm::rotate(glm::mat4(1.0f), rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+    glm::mat4 m_ry = glm::rotate(glm::mat4(1.0f), rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 m_rz = glm::rotate(glm::mat4(1.0f), rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 m_s = glm::scale(glm::mat4(1.0f), scale_change);
+    const glm::mat4 per_draw = m_s * m_rz * m_ry * m_rx * m_off;
+
+    world_boxes_.resize(transforms_.size());
+    for (std::size_t i = 0; i < transforms_.size(); ++i) {
+        Transform const& t = transforms_[i];
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), t.origin);
+        m = glm::rotate(m, t.orientation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+        m = glm::rotate(m, t.orientation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+        m = glm::rotate(m, t.orientation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+        m = glm::scale(m, t.scale);
+        model_matrices_[i] = m * per_draw;
+        normal_matrices_[i] = glm::mat3(glm::inverseTranspose(model_matrices_[i]));
+        world_boxes_.setTransformed(i, model_matrices_[i], bounds_[i].min_local, bounds_[i].max_local);
+    }
+}
+
+std::size_t Scene::cull(Frustum const& frustum) {
+    // Entities added or removed since the last updateMatrices(): the boxes no longer line up, draw everything.
+    if (world_boxes_.size() != visible_.size()) {
+        std::fill(visible_.begin(), visible_.end(), std::uint8_t{ 1 });
+        return visible_.size();
+    }
+    return frustum.cull(world_boxes_, visible_.data());
+}
+
+void Scene::draw(std::size_t i) const {
+    Render const& r = renders_[i];
+    if (!r.meshes) return;
+    for (auto const& mesh : *r.meshes)
+        mesh.draw(model_matrices_[i], r.atlas_layer);
+}
+
+bool Scene::queue(std::size_t i, IndirectDrawList& list) const {
+    Render const& r = renders_[i];
+    if (!r.meshes) return true;
+    for (auto const& mesh : *r.meshes)
+        if (!list.accepts(mesh))
+            return false;
+    for (auto const& mesh : *r.meshes)
+        list.add(mesh, model_matrices_[i], normal_matrices_[i], r.atlas_layer);
+    return true;
+}
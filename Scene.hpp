@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "IndirectDrawList.hpp"
+#include "Model.hpp"
+#include "SpatialHash.hpp"
+
+// Scene objects (crate, lamps, plane, thrown rocks) as entities with their data split into components.
+// Each component lives in its own dense array, all indexed by the same dense index 0..size(), so the
+// per-frame loops (motion, matrices, draw) walk contiguous memory and dispatch on enums instead of names.
+//
+// Dense indices change when an entity is removed (the last one moves into the gap); a Handle stays valid
+// until its entity is removed. Names are optional and only kept for lookups (find() / name()).
+class Scene {
+public:
+    static constexpr std::uint32_t kNoSlot = 0xFFFFFFFFu;
+
+    struct Handle {
+        std::uint32_t slot = kNoSlot;
+        std::uint32_t generation = 0;
+        bool valid() const { return slot != kNoSlot; }
+        bool operator==(Handle const& o) const { return slot == o.slot && generation == o.generation; }
+        bool operator!=(Handle const& o) const { return !(*this == o); }
+    };
+
+    // What moves an entity every frame.
+    enum class Motion : std::uint8_t {
+        None,
+        Circle,         // circles the map center above the terrain (the plane)
+        Ballistic,      // falls under gravity until it lands (thrown rocks)
+    };
+
+    struct Transform {
+        glm::vec3 origin{ 0.0f };
+        glm::vec3 orientation{ 0.0f };  // rotation around x/y/z in radians
+        glm::vec3 scale{ 1.0f };
+    };
+
+    struct Render {
+        std::shared_ptr<const Model::MeshList> meshes;
+        std::shared_ptr<CachedTexture> texture_ref;     // keeps a shared texture alive, may be null
+        int atlas_layer = -1;
+        bool transparent = false;
+    };
+
+    struct Body {
+        Motion motion = Motion::None;
+        glm::vec3 velocity{ 0.0f };
+        glm::vec3 gravity{ 0.0f, -9.81f, 0.0f };
+        float angle = 0.0f;             // Circle: current angle on the path
+    };
+
+    struct Bounds {
+        glm::vec3 min_local{ 0.0f };
+        glm::vec3 max_local{ 0.0f };
+        bool solid = false;
+        SpatialHash::Id collider = SpatialHash::kInvalid;   // id in App::collision_grid while registered
+    };
+
+    // Split a model into components. A name that is already used replaces that entity's data.
+    Handle add(Model const& model, std::string const& name = {}, Motion motion = Motion::None);
+    void remove(Handle handle);
+    void clear();
+
+    std::size_t size() const { return transforms_.size(); }
+    bool alive(Handle handle) const {
+        return handle.slot < slot_generation_.size() && slot_generation_[handle.slot] == handle.generation
+            && slot_index_[handle.slot] != kNoSlot;
+    }
+    std::size_t index(Handle handle) const { return slot_index_[handle.slot]; }
+    Handle handle(std::size_t i) const { return { index_slot_[i], slot_generation_[index_slot_[i]] }; }
+
+    // Name index (cold data, never touched by the per-frame loops).
+    Handle find(std::string const& name) const;
+    std::string const& name(Handle handle) const;
+
+    // Components by dense index.
+    Transform& transform(std::size_t i) { return transforms_[i]; }
+    Transform const& transform(std::size_t i) const { return transforms_[i]; }
+    Render const& render(std::size_t i) const { return renders_[i]; }
+    Body& body(std::size_t i) { return bodies_[i]; }
+    Bounds& bounds(std::size_t i) { return bounds_[i]; }
+    Bounds const& bounds(std::size_t i) const { return bounds_[i]; }
+    glm::mat4 const& modelMatrix(std::size_t i) const { return model_matrices_[i]; }
+    glm::mat3 const& normalMatrix(std::size_t i) const { return normal_matrices_[i]; }
+
+    // Back to a Model (placement code that works on models, e.g. the mini lamp on the block).
+    Model model(Handle handle) const;
+
+    // World AABB from origin + scaled local bounds (as Model::getWorldAABB).
+    std::pair<glm::vec3, glm::vec3> worldAABB(std::size_t i) const;
+
+    // Motion steps: along the plane's circle / one ballistic step (plus steering input on x).
+    void circle(std::size_t i, float delta_t, float height, float radius, float angular_speed);
+    void fly(std::size_t i, float delta_t, glm::vec3 input);
+
+    // Model and normal matrices of every entity, same order of transforms as Model::draw with the per-draw
+    // offset/rotation/scale applied after the entity's own transform.
+    void updateMatrices(glm::vec3 const& offset, glm::vec3 const& rotation, glm::vec3 const& scale_change);
+
+    // Frustum test of every entity's world box (from the last updateMatrices()). Returns the number visible;
+    // a default Frustum passes everything.
+    std::size_t cull(Frustum const& frustum);
+    bool visible(std::size_t i) const { return visible_[i] != 0; }
+
+    // Draw entity i with the matrix from the last updateMatrices().
+    void draw(std::size_t i) const;
+
+    // Queue entity i on `list` instead; false (nothing queued) if one of its meshes can not go through it.
+    bool queue(std::size_t i, IndirectDrawList& list) const;
+
+private:
+    // Dense components, all size() long.
+    std::vector<Transform> transforms_;
+    std::vector<Render> renders_;
+    std::vector<Body> bodies_;
+    std::vector<Bounds> bounds_;
+    std::vector<glm::mat4> model_matrices_;
+    std::vector<glm::mat3> normal_matrices_;
+    Frustum::BoxList world_boxes_;              // local bounds through the model matrix, rebuilt by updateMatrices()
+    std::vector<std::uint8_t> visible_;         // result of the last cull()
+    std::vector<std::uint32_t> index_slot_;     // dense index -> slot
+
+    // Slots: dense index (or kNoSlot) and generation, bumped on remove so old handles go stale.
+    std::vector<std::uint32_t> slot_index_;
+    std::vector<std::uint32_t> slot_generation_;
+    std::vector<std::uint32_t> free_slots_;
+
+    std::unordered_map<std::string, Handle> by_name_;
+    std::vector<std::string> slot_names_;
+};
@@ -0,0 +1,63 @@
+#include "SceneTarget.hpp"
+
+#include <iostream>
+
+#include "RenderState.hpp"
+
+bool SceneTarget::resize(int width, int height) {
+    if (width <= 0 || height <= 0)
+        return false;
+    if (ready() && width == width_ && height == height_)
+        return true;
+    destroy();
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &color_);
+    glObjectLabel(GL_TEXTURE, color_, -1, "SceneColor");
+    glTextureStorage2D(color_, 1, GL_RGBA8, width, height);
+
+    // Sampled by HiZPyramid with texelFetch: no filtering, no compare mode.
+    glCreateTextures(GL_TEXTURE_2D, 1, &depth_);
+    glObjectLabel(GL_TEXTURE, depth_, -1, "SceneDepth");
+    glTextureStorage2D(depth_, 1, GL_DEPTH_COMPONENT32F, width, height);
+    glTextureParameteri(depth_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(depth_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(depth_, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    glCreateFramebuffers(1, &fbo_);
+    glObjectLabel(GL_FRAMEBUFFER, fbo_, -1, "SceneFBO");
+    glNamedFramebufferTexture(fbo_, GL_COLOR_ATTACHMENT0, color_, 0);
+    glNamedFramebufferTexture(fbo_, GL_DEPTH_ATTACHMENT, depth_, 0);
+
+    GLenum status = glCheckNamedFramebufferStatus(fbo_, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Scene framebuffer incomplete (0x" << std::hex << status << std::dec << "), drawing to the window\n";
+        destroy();
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+void SceneTarget::destroy() {
+    if (fbo_) glDeleteFramebuffers(1, &fbo_);
+    for (GLuint texture : { color_, depth_ })
+        if (texture) {
+            RenderState::get().forgetTexture(texture);
+            glDeleteTextures(1, &texture);
+        }
+    fbo_ = color_ = depth_ = 0;
+    width_ = height_ = 0;
+}
+
+void SceneTarget::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, width_, height_);
+}
+
+void SceneTarget::present() const {
+    if (!ready())
+        return;
+    glBlitNamedFramebuffer(fbo_, 0, 0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
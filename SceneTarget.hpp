@@ -0,0 +1,27 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Offscreen framebuffer the frame is drawn into: RGBA8 color plus a depth texture that can be sampled, so
+// HiZPyramid can reduce the depth of the occluders drawn so far. present() blits the color to the window.
+// GL thread only; destroy() while the context is alive.
+class SceneTarget {
+public:
+    // (Re)create the attachments when the size changed; false (and nothing to draw into) if incomplete.
+    bool resize(int width, int height);
+    void destroy();
+    bool ready() const { return fbo_ != 0; }
+
+    // Draw into the target (framebuffer and viewport).
+    void bind() const;
+    // Copy the color to the default framebuffer and bind that again.
+    void present() const;
+
+    GLuint depthTexture() const { return depth_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+private:
+    GLuint fbo_ = 0, color_ = 0, depth_ = 0;
+    int width_ = 0, height_ = 0;
+};
@@ -2,11 +2,14 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
 #include "ShaderProgram.hpp"
+#include "RenderState.hpp"
 
 // set uniform according to name 
 // https://docs.gl/gl4/glUniform
@@ -20,75 +23,187 @@ ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file, const std::fi
 
 	// link all compiled shaders into shader_program 
     ID = link_shader(shader_ids);
+	glObjectLabel(GL_PROGRAM, ID, -1, VS_file.stem().string().c_str());	// labelled once, for debuggers
+	reflectUniforms();
 }
 
-void ShaderProgram::setUniform(const std::string& name, const float val) {
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
+ShaderProgram::ShaderProgram(const std::filesystem::path& CS_file) {
+	ID = link_shader({ compile_shader(CS_file, GL_COMPUTE_SHADER) });
+	glObjectLabel(GL_PROGRAM, ID, -1, CS_file.stem().string().c_str());
+	reflectUniforms();
+}
+
+void ShaderProgram::activate(void) const {
+	RenderState::get().useProgram(ID);
+}
+
+void ShaderProgram::deactivate(void) const {
+	RenderState::get().useProgram(0);
+}
+
+void ShaderProgram::clear(void) {
+	deactivate();
+	RenderState::get().forgetProgram(ID);
+	glDeleteProgram(ID);
+	ID = 0;
+	uniforms_.reset();
+}
+
+namespace {
+
+// Counts one setUniform call and, while profiling, adds its duration to the stats.
+class UniformTimer {
+public:
+	explicit UniformTimer(bool by_name) {
+		auto& stats = ShaderProgram::uniformStats();
+		if (by_name) ++stats.by_name;
+		else ++stats.by_handle;
+		if (ShaderProgram::profile_uniforms) start_ = std::chrono::steady_clock::now();
+	}
+	~UniformTimer() {
+		if (ShaderProgram::profile_uniforms && start_ != std::chrono::steady_clock::time_point{})
+			ShaderProgram::uniformStats().cpu_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
 	}
-	glUniform1f(loc, val);
+
+private:
+	std::chrono::steady_clock::time_point start_{};
+};
+
+} // namespace
+
+ShaderProgram::UniformStats& ShaderProgram::uniformStats() {
+	static UniformStats stats;
+	return stats;
 }
 
-void ShaderProgram::setUniform(const std::string& name, const int val) {
-    // TODO: implement
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
+void ShaderProgram::reflectUniforms(void) {
+	auto table = std::make_shared<std::unordered_map<std::string, GLint>>();
+
+	GLint count = 0, max_length = 0;
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_length);
+	std::vector<char> name(static_cast<size_t>(std::max(max_length, 1)));
+
+	const GLenum props[] = { GL_LOCATION, GL_ARRAY_SIZE };
+	for (GLint i = 0; i < count; ++i) {
+		GLint values[2] = { -1, 1 };
+		glGetProgramResourceiv(ID, GL_UNIFORM, i, 2, props, 2, NULL, values);
+		if (values[0] < 0) continue;	// member of a uniform block, set through the buffer instead
+
+		GLsizei length = 0;
+		glGetProgramResourceName(ID, GL_UNIFORM, i, static_cast<GLsizei>(name.size()), &length, name.data());
+		std::string n(name.data(), static_cast<size_t>(length));
+		(*table)[n] = values[0];
+
+		// Arrays of basic types are reported once as "name[0]": also accept "name" and every "name[i]".
+		if (n.size() > 3 && n.compare(n.size() - 3, 3, "[0]") == 0) {
+			std::string base = n.substr(0, n.size() - 3);
+			(*table)[base] = values[0];
+			for (GLint e = 1; e < values[1]; ++e)
+				(*table)[base + "[" + std::to_string(e) + "]"] = values[0] + e;
+		}
 	}
-	glUniform1i(loc, val);
+
+	uniforms_ = std::move(table);
 }
 
-void ShaderProgram::setUniform(const std::string& name, const glm::vec2 val) {
-	//TODO: get location
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
+UniformHandle ShaderProgram::uniform(const std::string& name) const {
+	if (uniforms_) {
+		auto it = uniforms_->find(name);
+		if (it != uniforms_->end()) return { it->second };
 	}
-	glUniform2fv(loc, 1, glm::value_ptr(val));
+	return {};
 }
 
-void ShaderProgram::setUniform(const std::string& name, const glm::vec3 val) {
-    //TODO: get location
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
+GLint ShaderProgram::locationOf(const std::string& name) const {
+	GLint loc = -1;
+	if (legacy_uniform_lookup) {
+		loc = glGetUniformLocation(ID, name.c_str());
+	}
+	else if (uniforms_) {
+		auto it = uniforms_->find(name);
+		if (it != uniforms_->end()) loc = it->second;
 	}
-	glUniform3fv(loc, 1, glm::value_ptr(val));
+	if (loc == -1)
+		std::cerr << "no uniform with name:" << name << '\n';
+	return loc;
+}
+
+void ShaderProgram::setUniform(const std::string& name, const float val) {
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniform1f(loc, val);
+}
+
+void ShaderProgram::setUniform(const std::string& name, const int val) {
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniform1i(loc, val);
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::vec2 val) {
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniform2fv(loc, 1, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(const std::string& name, const glm::vec3 val) {
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniform3fv(loc, 1, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::vec4 in_vec4) {
-    // TODO: implement
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
-	}
-	glUniform4fv(loc, 1, glm::value_ptr(in_vec4));
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniform4fv(loc, 1, glm::value_ptr(in_vec4));
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::mat3 val) {
-    //TODO: get location
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
-	}
-	glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(val));
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(val));
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::mat4 val) {
-    // TODO: implement
-	auto loc = glGetUniformLocation(ID, name.c_str());
-	if (loc == -1) {
-		std::cerr << "no uniform with name:" << name << '\n';
-		return;
-	}
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(val));
+	UniformTimer timer(true);
+	auto loc = locationOf(name);
+	if (loc != -1) glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const float val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniform1f(u.location, val);
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const int val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniform1i(u.location, val);
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const glm::vec2 val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniform2fv(u.location, 1, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const glm::vec3 val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniform3fv(u.location, 1, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const glm::vec4 val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniform4fv(u.location, 1, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const glm::mat3 val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniformMatrix3fv(u.location, 1, GL_FALSE, glm::value_ptr(val));
+}
+
+void ShaderProgram::setUniform(UniformHandle u, const glm::mat4 val) const {
+	UniformTimer timer(false);
+	if (u.valid()) glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(val));
 }
 
 std::string ShaderProgram::getShaderInfoLog(const GLuint obj) {
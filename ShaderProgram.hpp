@@ -1,24 +1,36 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <GL/glew.h> 
+#include <glm/glm.hpp>
+
+// Location of an active uniform: look it up once with ShaderProgram::uniform() and reuse it in hot paths.
+struct UniformHandle {
+    GLint location = -1;
+    bool valid() const { return location >= 0; }
+};
 
 class ShaderProgram {
 public:
 	// you can add more constructors for pipeline with GS, TS etc.
 	ShaderProgram(void) = default; //does nothing
 	ShaderProgram(const std::filesystem::path & VS_file, const std::filesystem::path & FS_file); // TODO: implementation of load, compile, and link shader
+	explicit ShaderProgram(const std::filesystem::path & CS_file);   // compute program (e.g. GpuCulling)
+
+	// Binds go through RenderState, so activating the program that is already current costs nothing.
+	void activate(void) const;      // activate shader
+	void deactivate(void) const;    // deactivate current shader program (i.e. activate shader no. 0)
 
-	void activate(void) const { glUseProgram(ID); };    // activate shader
-	void deactivate(void) { glUseProgram(0); };   // deactivate current shader program (i.e. activate shader no. 0)
+	void clear(void);   //deallocate shader program
 
-	void clear(void) { 	//deallocate shader program
-		deactivate();
-		glDeleteProgram(ID);
-		ID = 0;
-	}
+    // Handle of an active uniform (e.g. "uM_m", "lights[2].position"); invalid if the program has none.
+    UniformHandle uniform(const std::string & name) const;
     
     // set uniform according to name 
     // https://docs.gl/gl4/glUniform
@@ -30,10 +42,34 @@ public:
     void setUniform(const std::string & name, const glm::mat3 val);   
     void setUniform(const std::string & name, const glm::mat4 val);  // TODO: implement
 
+    // Same by handle: no string hashing, invalid handles are ignored. Const: they only touch GL state.
+    void setUniform(UniformHandle u, const float val) const;
+    void setUniform(UniformHandle u, const int val) const;
+    void setUniform(UniformHandle u, const glm::vec2 val) const;
+    void setUniform(UniformHandle u, const glm::vec3 val) const;
+    void setUniform(UniformHandle u, const glm::vec4 val) const;
+    void setUniform(UniformHandle u, const glm::mat3 val) const;
+    void setUniform(UniformHandle u, const glm::mat4 val) const;
+
+    // setUniform statistics over all programs (GL thread only), reported once per second by App::updateFPS().
+    struct UniformStats {
+        std::uint64_t by_name = 0;      // setUniform(name, ...) calls
+        std::uint64_t by_handle = 0;    // setUniform(handle, ...) calls
+        double cpu_ms = 0.0;            // time spent inside setUniform (only while profiling)
+    };
+    static UniformStats& uniformStats();
+    static inline bool profile_uniforms = false;        // time every setUniform call (two clock reads each)
+    static inline bool legacy_uniform_lookup = false;   // by-name calls use glGetUniformLocation like before (for comparison)
+
     GLuint getID() const { return ID; }
     
 private:
 	GLuint ID{0}; // default = 0, empty shader
+
+    // Active uniforms reflected after linking; shared, so copies of the program (every Mesh has one) stay cheap.
+    std::shared_ptr<const std::unordered_map<std::string, GLint>> uniforms_;
+    void reflectUniforms(void);
+    GLint locationOf(const std::string & name) const;
 	std::string getShaderInfoLog(const GLuint obj);   // TODO implement: print compiler output  
 	std::string getProgramInfoLog(const GLuint obj);  // TODO implement: print linker output
 
@@ -0,0 +1,125 @@
+#include "SpatialHash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::CellRange SpatialHash::cellRange(glm::vec3 const& mn, glm::vec3 const& mx) const {
+    CellRange r;
+    r.x0 = static_cast<int>(std::floor(mn.x * inv_cell_size_));
+    r.z0 = static_cast<int>(std::floor(mn.z * inv_cell_size_));
+    r.x1 = static_cast<int>(std::floor(mx.x * inv_cell_size_));
+    r.z1 = static_cast<int>(std::floor(mx.z * inv_cell_size_));
+    return r;
+}
+
+void SpatialHash::link(Id id, CellRange const& range) {
+    for (int x = range.x0; x <= range.x1; ++x)
+        for (int z = range.z0; z <= range.z1; ++z)
+            cells_[cellKey(x, z)].push_back(id);
+}
+
+void SpatialHash::unlink(Id id, CellRange const& range) {
+    for (int x = range.x0; x <= range.x1; ++x)
+        for (int z = range.z0; z <= range.z1; ++z) {
+            auto it = cells_.find(cellKey(x, z));
+            if (it == cells_.end())
+                continue;
+            auto& ids = it->second;
+            auto pos = std::find(ids.begin(), ids.end(), id);
+            if (pos != ids.end()) {
+                *pos = ids.back();
+                ids.pop_back();
+            }
+            if (ids.empty())
+                cells_.erase(it);
+        }
+}
+
+SpatialHash::Id SpatialHash::insert(glm::vec3 const& mn, glm::vec3 const& mx) {
+    Id id;
+    if (!free_.empty()) {
+        id = free_.back();
+        free_.pop_back();
+    }
+    else {
+        id = static_cast<Id>(entries_.size());
+        entries_.emplace_back();
+        visited_.push_back(0);
+    }
+
+    Entry& e = entries_[id];
+    e.mn = glm::min(mn, mx);
+    e.mx = glm::max(mn, mx);
+    e.cells = cellRange(e.mn, e.mx);
+    e.alive = true;
+    link(id, e.cells);
+    return id;
+}
+
+void SpatialHash::update(Id id, glm::vec3 const& mn, glm::vec3 const& mx) {
+    if (!contains(id))
+        return;
+
+    Entry& e = entries_[id];
+    e.mn = glm::min(mn, mx);
+    e.mx = glm::max(mn, mx);
+    CellRange range = cellRange(e.mn, e.mx);
+    if (range == e.cells)
+        return;     // still in the same cells, only the box changed
+
+    unlink(id, e.cells);
+    e.cells = range;
+    link(id, e.cells);
+}
+
+void SpatialHash::remove(Id id) {
+    if (!contains(id))
+        return;
+    unlink(id, entries_[id].cells);
+    entries_[id].alive = false;
+    free_.push_back(id);
+}
+
+void SpatialHash::clear() {
+    entries_.clear();
+    free_.clear();
+    cells_.clear();
+    visited_.clear();
+    query_stamp_ = 0;
+}
+
+std::size_t SpatialHash::querySphere(glm::vec3 const& center, float radius, std::vector<Id>& out) const {
+    out.clear();
+    ++stats_.queries;
+    if (cells_.empty())
+        return 0;
+
+    // New stamp per query; on wrap-around the old stamps have to go.
+    if (++query_stamp_ == 0) {
+        std::fill(visited_.begin(), visited_.end(), 0u);
+        query_stamp_ = 1;
+    }
+
+    const CellRange range = cellRange(center - glm::vec3(radius), center + glm::vec3(radius));
+    const float radius2 = radius * radius;
+    for (int x = range.x0; x <= range.x1; ++x)
+        for (int z = range.z0; z <= range.z1; ++z) {
+            auto it = cells_.find(cellKey(x, z));
+            if (it == cells_.end())
+                continue;
+            ++stats_.cells;
+            for (Id id : it->second) {
+                if (visited_[id] == query_stamp_)
+                    continue;
+                visited_[id] = query_stamp_;
+                ++stats_.tests;
+
+                Entry const& e = entries_[id];
+                glm::vec3 closest = glm::clamp(center, e.mn, e.mx);
+                if (glm::dot(closest - center, closest - center) <= radius2)
+                    out.push_back(id);
+            }
+        }
+    stats_.hits += out.size();
+    return out.size();
+}
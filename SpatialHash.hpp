@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Broadphase for sphere queries against many world-space AABBs (camera and projectile collision).
+// Boxes are bucketed on a uniform grid in x/z (the scene is spread over the terrain, height hardly separates
+// anything); a box is listed in every cell it overlaps, and only non-empty cells are stored. A query visits the
+// cells under the sphere's bounds, so its cost depends on the local density and not on the object count.
+class SpatialHash {
+public:
+    using Id = std::uint32_t;
+    static constexpr Id kInvalid = 0xFFFFFFFFu;
+
+    // Work done by querySphere() since the last resetStats() (printed with the U report).
+    struct Stats {
+        std::size_t queries = 0;
+        std::size_t cells = 0;          // non-empty cells visited
+        std::size_t tests = 0;          // distinct boxes tested against the sphere
+        std::size_t hits = 0;
+    };
+
+    explicit SpatialHash(float cell_size = 4.0f) : cell_size_(cell_size), inv_cell_size_(1.0f / cell_size) {}
+
+    // Add a box; ids of removed boxes are reused.
+    Id insert(glm::vec3 const& mn, glm::vec3 const& mx);
+
+    // Move a box. Cells are only touched if the range of cells it covers changed.
+    void update(Id id, glm::vec3 const& mn, glm::vec3 const& mx);
+
+    void remove(Id id);
+    void clear();
+
+    bool contains(Id id) const { return id < entries_.size() && entries_[id].alive; }
+    std::size_t size() const { return entries_.size() - free_.size(); }
+    std::size_t cellCount() const { return cells_.size(); }
+    float cellSize() const { return cell_size_; }
+
+    // Ids of the boxes touching the sphere (closest point within radius), each once, in no particular order.
+    // `out` is cleared first. Returns the number of hits.
+    std::size_t querySphere(glm::vec3 const& center, float radius, std::vector<Id>& out) const;
+
+    Stats const& stats() const { return stats_; }
+    void resetStats() { stats_ = {}; }
+
+private:
+    struct CellRange {
+        int x0 = 0, z0 = 0, x1 = -1, z1 = -1;   // inclusive
+        bool operator==(CellRange const& o) const { return x0 == o.x0 && z0 == o.z0 && x1 == o.x1 && z1 == o.z1; }
+    };
+    struct Entry {
+        glm::vec3 mn{ 0.0f }, mx{ 0.0f };
+        CellRange cells;
+        bool alive = false;
+    };
+
+    float cell_size_;
+    float inv_cell_size_;
+    std::vector<Entry> entries_;
+    std::vector<Id> free_;
+    std::unordered_map<std::uint64_t, std::vector<Id>> cells_;
+
+    // Query dedup: a box listed in several visited cells is tested once per query.
+    mutable std::vector<std::uint32_t> visited_;
+    mutable std::uint32_t query_stamp_ = 0;
+    mutable Stats stats_;
+
+    static std::uint64_t cellKey(int x, int z) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(z);
+    }
+    CellRange cellRange(glm::vec3 const& mn, glm::vec3 const& mx) const;
+    void link(Id id, CellRange const& range);
+    void unlink(Id id, CellRange const& range);
+};
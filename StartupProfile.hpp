@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Collects wall-clock timings of startup steps (asset loading etc.) and prints them as one report.
+// Shared by the app and by loaders that have no App reference (Model, Heightmap).
+// Thread-safe: asset loader workers record into it while the GL thread renders.
+class StartupProfile {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string label;
+        double ms = 0.0;
+        std::string note;   // e.g. "cache" / "parsed"
+    };
+
+    // RAII timer: records its lifetime under `label` when destroyed.
+    class Scope {
+    public:
+        Scope(StartupProfile& profile, std::string label)
+            : profile_(profile), label_(std::move(label)), start_(Clock::now()) {}
+        ~Scope() { profile_.add(label_, msSince(start_), note); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        std::string note;
+
+    private:
+        StartupProfile& profile_;
+        std::string label_;
+        Clock::time_point start_;
+    };
+
+    static StartupProfile& get() {
+        static StartupProfile profile;
+        return profile;
+    }
+
+    static double msSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void add(std::string label, double ms, std::string note = {}) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.push_back({ std::move(label), ms, std::move(note) });
+    }
+
+    // Count entries carrying a given note (e.g. how many meshes came from the cache).
+    int count(const std::string& note) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int n = 0;
+        for (auto const& e : entries_) n += (e.note == note);
+        return n;
+    }
+
+    void report(std::ostream& out = std::cout) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out << "[Startup] ---- startup timing report ----\n";
+        for (auto const& e : entries_) {
+            out << "[Startup] " << e.label << ": " << e.ms << " ms";
+            if (!e.note.empty()) out << " (" << e.note << ")";
+            out << '\n';
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
@@ -0,0 +1,401 @@
+#include "TerrainLOD.hpp"
+#include "RenderState.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+TerrainLOD::TerrainLOD(HeightField const& heights, float scale, ShaderProgram program)
+    : shader(program), scale_(scale), map_cells_(heights.rows(), heights.cols())
+{
+    init(heights.rows(), heights.cols(), map_cells_, GL_CLAMP_TO_EDGE);
+    buildTree(heights);
+    glTextureSubImage2D(height_texture_, 0, 0, 0, cols_, rows_, GL_RED, GL_FLOAT, heights.data());
+
+    std::cout << "TerrainLOD: " << rows_ << "x" << cols_ << " cells, " << levels_ << " levels" << std::endl;
+}
+
+TerrainLOD::TerrainLOD(glm::ivec2 window_cells, glm::ivec2 ring_cells, float scale, ShaderProgram program,
+    glm::ivec2 first_cell, glm::ivec2 map_cells)
+    : shader(program), scale_(scale), first_cell_(first_cell), map_cells_(map_cells),
+      ring_cells_(glm::max(ring_cells, window_cells))
+{
+    // The ring wraps, so the texture repeats; heightAt() in terrain_lod.vert clamps to the window itself.
+    init(window_cells.x, window_cells.y, ring_cells_, GL_REPEAT);
+    ring_.assign(static_cast<std::size_t>(ring_cells_.x) * ring_cells_.y, 0.0f);
+    const float zero = 0.0f;
+    glClearTexImage(height_texture_, 0, GL_RED, GL_FLOAT, &zero);
+    leaf_dirty_.assign(min_max_[0].size(), 1);
+    tree_dirty_ = true;
+
+    std::cout << "TerrainLOD: streamed window of " << rows_ << "x" << cols_ << " cells (ring " << ring_cells_.x << "x"
+        << ring_cells_.y << ") over " << map_cells_.x << "x" << map_cells_.y << ", " << levels_ << " levels" << std::endl;
+}
+
+void TerrainLOD::init(int rows, int cols, glm::ivec2 texture_cells, GLint wrap) {
+    rows_ = rows;
+    cols_ = cols;
+
+    // Enough levels for the root node to cover the whole map.
+    levels_ = 1;
+    while (levels_ < kMaxLevels && nodeCells(levels_ - 1) < std::max(rows_, cols_) - 1)
+        ++levels_;
+
+    sizeTree();
+    createPatch();
+
+    // Heights as one R32F texel per cell: x = column, y = row (same layout as HeightField).
+    glCreateTextures(GL_TEXTURE_2D, 1, &height_texture_);
+    glObjectLabel(GL_TEXTURE, height_texture_, -1, "TerrainHeights");
+    glTextureStorage2D(height_texture_, 1, GL_R32F, texture_cells.y, texture_cells.x);
+    glTextureParameteri(height_texture_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(height_texture_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(height_texture_, GL_TEXTURE_WRAP_S, wrap);
+    glTextureParameteri(height_texture_, GL_TEXTURE_WRAP_T, wrap);
+
+    // Texture units follow the app: tex0 on 0, the atlas array on 1.
+    u_morph_range = shader.uniform("morph_range");
+    u_atlas_layer = shader.uniform("atlasLayer");
+    shader.activate();
+    shader.setUniform("tex0", 0);
+    shader.setUniform("atlas", 1);
+    shader.setUniform("heights", static_cast<int>(kHeightTextureUnit));
+    shader.setUniform("terrain_cells", glm::vec2(static_cast<float>(rows_), static_cast<float>(cols_)));
+    shader.setUniform("terrain_texture_cells", glm::vec2(texture_cells));
+    shader.setUniform("terrain_scale", scale_);
+    shader.setUniform("terrain_first_cell", glm::vec2(first_cell_));
+    shader.setUniform("terrain_map_cells", glm::vec2(map_cells_));
+}
+
+TerrainLOD::~TerrainLOD() {
+    RenderState& state = RenderState::get();
+    state.forgetTexture(height_texture_);
+    state.forgetVertexArray(VAO_);
+    glDeleteTextures(1, &height_texture_);
+    glDeleteBuffers(1, &VBO_);
+    glDeleteBuffers(1, &EBO_);
+    glDeleteBuffers(1, &instance_buffer_);
+    glDeleteVertexArrays(1, &VAO_);
+}
+
+void TerrainLOD::sizeTree() {
+    min_max_.assign(levels_, {});
+    node_rows_.assign(levels_, 0);
+    node_cols_.assign(levels_, 0);
+
+    for (int level = 0; level < levels_; ++level) {
+        int cells = nodeCells(level);
+        node_rows_[level] = std::max(1, (rows_ - 1 + cells - 1) / cells);
+        node_cols_[level] = std::max(1, (cols_ - 1 + cells - 1) / cells);
+        min_max_[level].resize(static_cast<std::size_t>(node_rows_[level]) * node_cols_[level]);
+    }
+}
+
+void TerrainLOD::buildTree(HeightField const& heights) {
+    // Leaves from the heights (a node includes its far border row/column), parents from their children.
+    for (int nr = 0; nr < node_rows_[0]; ++nr)
+        for (int nc = 0; nc < node_cols_[0]; ++nc) {
+            int r0 = nr * kLeafCells, r1 = std::min(r0 + kLeafCells, rows_ - 1);
+            int c0 = nc * kLeafCells, c1 = std::min(c0 + kLeafCells, cols_ - 1);
+            glm::vec2 range(heights.at(r0, c0));
+            for (int r = r0; r <= r1; ++r)
+                for (int c = c0; c <= c1; ++c) {
+                    float h = heights.at(r, c);
+                    range.x = std::min(range.x, h);
+                    range.y = std::max(range.y, h);
+                }
+            min_max_[0][static_cast<std::size_t>(nr) * node_cols_[0] + nc] = range;
+        }
+    buildParents();
+}
+
+void TerrainLOD::buildParents() {
+    for (int level = 1; level < levels_; ++level)
+        for (int nr = 0; nr < node_rows_[level]; ++nr)
+            for (int nc = 0; nc < node_cols_[level]; ++nc) {
+                glm::vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+                for (int q = 0; q < 4; ++q) {
+                    int cr = nr * 2 + (q >> 1), cc = nc * 2 + (q & 1);
+                    if (cr >= node_rows_[level - 1] || cc >= node_cols_[level - 1]) continue;
+                    glm::vec2 child = min_max_[level - 1][static_cast<std::size_t>(cr) * node_cols_[level - 1] + cc];
+                    range.x = std::min(range.x, child.x);
+                    range.y = std::max(range.y, child.y);
+                }
+                min_max_[level][static_cast<std::size_t>(nr) * node_cols_[level] + nc] = range;
+            }
+}
+
+namespace {
+    int wrapped(int cell, int size) { return ((cell % size) + size) % size; }
+}
+
+void TerrainLOD::refitLeaves() {
+    for (int nr = 0; nr < node_rows_[0]; ++nr)
+        for (int nc = 0; nc < node_cols_[0]; ++nc) {
+            const std::size_t leaf = static_cast<std::size_t>(nr) * node_cols_[0] + nc;
+            if (!leaf_dirty_[leaf])
+                continue;
+            leaf_dirty_[leaf] = 0;
+            int r0 = nr * kLeafCells, r1 = std::min(r0 + kLeafCells, rows_ - 1);
+            int c0 = nc * kLeafCells, c1 = std::min(c0 + kLeafCells, cols_ - 1);
+            glm::vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+            for (int r = r0; r <= r1; ++r) {
+                float const* row = ring_.data() + static_cast<std::size_t>(wrapped(first_cell_.x + r, ring_cells_.x)) * ring_cells_.y;
+                for (int c = c0; c <= c1; ++c) {
+                    float h = row[wrapped(first_cell_.y + c, ring_cells_.y)];
+                    range.x = std::min(range.x, h);
+                    range.y = std::max(range.y, h);
+                }
+            }
+            min_max_[0][leaf] = range;
+        }
+}
+
+void TerrainLOD::markLeaves(int r0, int c0, int r1, int c1) {
+    // Window cells [r0, r1] x [c0, c1]; a leaf includes its far border row/column, so a cell on a leaf
+    // boundary belongs to both leaves.
+    r0 = std::max(r0, 0);
+    c0 = std::max(c0, 0);
+    r1 = std::min(r1, rows_ - 1);
+    c1 = std::min(c1, cols_ - 1);
+    if (r0 > r1 || c0 > c1)
+        return;
+    const int nr0 = std::max(r0 - 1, 0) / kLeafCells, nr1 = std::min(r1 / kLeafCells, node_rows_[0] - 1);
+    const int nc0 = std::max(c0 - 1, 0) / kLeafCells, nc1 = std::min(c1 / kLeafCells, node_cols_[0] - 1);
+    for (int nr = nr0; nr <= nr1; ++nr)
+        for (int nc = nc0; nc <= nc1; ++nc)
+            leaf_dirty_[static_cast<std::size_t>(nr) * node_cols_[0] + nc] = 1;
+    tree_dirty_ = true;
+}
+
+void TerrainLOD::moveWindow(glm::ivec2 first_cell) {
+    if (ring_.empty() || first_cell == first_cell_)
+        return;
+    const glm::ivec2 delta = first_cell - first_cell_;
+    first_cell_ = first_cell;
+    shader.activate();
+    shader.setUniform("terrain_first_cell", glm::vec2(first_cell_));
+
+    // Moved by whole leaves (the usual tile step): keep the bounds of the leaves still in the window.
+    // The last leaf row/column may be cut short by the window edge, so it is always recomputed.
+    const int leaf_rows = node_rows_[0], leaf_cols = node_cols_[0];
+    if (delta.x % kLeafCells != 0 || delta.y % kLeafCells != 0) {
+        leaf_dirty_.assign(leaf_dirty_.size(), 1);
+        tree_dirty_ = true;
+        return;
+    }
+    const glm::ivec2 shift = delta / kLeafCells;
+    std::vector<glm::vec2> leaves(min_max_[0].size());
+    std::vector<std::uint8_t> dirty(leaf_dirty_.size(), 1);
+    for (int nr = 0; nr < leaf_rows - 1; ++nr)
+        for (int nc = 0; nc < leaf_cols - 1; ++nc) {
+            const int sr = nr + shift.x, sc = nc + shift.y;
+            if (sr < 0 || sc < 0 || sr >= leaf_rows - 1 || sc >= leaf_cols - 1)
+                continue;
+            const std::size_t from = static_cast<std::size_t>(sr) * leaf_cols + sc, to = static_cast<std::size_t>(nr) * leaf_cols + nc;
+            leaves[to] = min_max_[0][from];
+            dirty[to] = leaf_dirty_[from];
+        }
+    min_max_[0].swap(leaves);
+    leaf_dirty_.swap(dirty);
+    tree_dirty_ = true;
+}
+
+void TerrainLOD::writeHeights(glm::ivec2 first_cell, glm::ivec2 size, float const* heights, int stride) {
+    if (ring_.empty() || size.x <= 0 || size.y <= 0)
+        return;
+    size = glm::min(size, ring_cells_);
+
+    // CPU copy first, so the texture pieces can be uploaded straight from it.
+    const int row0 = wrapped(first_cell.x, ring_cells_.x), col0 = wrapped(first_cell.y, ring_cells_.y);
+    for (int i = 0; i < size.x; ++i) {
+        float* row = ring_.data() + static_cast<std::size_t>(wrapped(row0 + i, ring_cells_.x)) * ring_cells_.y;
+        float const* src = heights + static_cast<std::size_t>(i) * stride;
+        const int first_run = std::min(size.y, ring_cells_.y - col0);
+        std::copy(src, src + first_run, row + col0);
+        std::copy(src + first_run, src + size.y, row);
+    }
+
+    // Up to four rectangles where the block wraps around the ring.
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, ring_cells_.y);
+    const int row_runs[2][2] = { { row0, std::min(size.x, ring_cells_.x - row0) }, { 0, size.x - std::min(size.x, ring_cells_.x - row0) } };
+    const int col_runs[2][2] = { { col0, std::min(size.y, ring_cells_.y - col0) }, { 0, size.y - std::min(size.y, ring_cells_.y - col0) } };
+    for (auto const& rows : row_runs)
+        for (auto const& cols : col_runs)
+            if (rows[1] > 0 && cols[1] > 0)
+                glTextureSubImage2D(height_texture_, 0, cols[0], rows[0], cols[1], rows[1], GL_RED, GL_FLOAT,
+                    ring_.data() + static_cast<std::size_t>(rows[0]) * ring_cells_.y + cols[0]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    const glm::ivec2 local = first_cell - first_cell_;
+    markLeaves(local.x, local.y, local.x + size.x - 1, local.y + size.y - 1);
+}
+
+void TerrainLOD::createPatch() {
+    // (kPatchQuads + 1)^2 integer grid positions; x runs along the heightmap rows (world x), y along the columns.
+    std::vector<glm::vec2> grid;
+    grid.reserve((kPatchQuads + 1) * (kPatchQuads + 1));
+    for (int i = 0; i <= kPatchQuads; ++i)
+        for (int j = 0; j <= kPatchQuads; ++j)
+            grid.emplace_back(static_cast<float>(i), static_cast<float>(j));
+
+    // Same winding as the Heightmap strips (front faces are clockwise from above, drawn with glFrontFace(GL_CW)).
+    std::vector<GLuint> indices;
+    indices.reserve(kPatchQuads * kPatchQuads * 6);
+    auto vertexIndex = [](int i, int j) { return static_cast<GLuint>(i * (kPatchQuads + 1) + j); };
+    for (int i = 0; i < kPatchQuads; ++i)
+        for (int j = 0; j < kPatchQuads; ++j) {
+            indices.insert(indices.end(), { vertexIndex(i, j), vertexIndex(i + 1, j), vertexIndex(i, j + 1) });
+            indices.insert(indices.end(), { vertexIndex(i + 1, j), vertexIndex(i + 1, j + 1), vertexIndex(i, j + 1) });
+        }
+    index_count_ = static_cast<GLsizei>(indices.size());
+
+    glCreateVertexArrays(1, &VAO_);
+    glObjectLabel(GL_VERTEX_ARRAY, VAO_, -1, "TerrainPatchVAO");
+    glCreateBuffers(1, &VBO_);
+    glCreateBuffers(1, &EBO_);
+    glCreateBuffers(1, &instance_buffer_);
+    glObjectLabel(GL_BUFFER, instance_buffer_, -1, "TerrainPatchInstances");
+
+    glNamedBufferStorage(VBO_, grid.size() * sizeof(glm::vec2), grid.data(), 0);
+    glNamedBufferStorage(EBO_, indices.size() * sizeof(GLuint), indices.data(), 0);
+
+    // location 0: aGrid (per vertex), location 1: iPatch (per instance).
+    glVertexArrayAttribFormat(VAO_, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(VAO_, 0, 0);
+    glEnableVertexArrayAttrib(VAO_, 0);
+    glVertexArrayVertexBuffer(VAO_, 0, VBO_, 0, sizeof(glm::vec2));
+
+    glVertexArrayAttribFormat(VAO_, 1, 4, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(VAO_, 1, 1);
+    glEnableVertexArrayAttrib(VAO_, 1);
+    glVertexArrayBindingDivisor(VAO_, 1, 1);
+
+    glVertexArrayElementBuffer(VAO_, EBO_);
+}
+
+void TerrainLOD::updateRanges(glm::mat4 const& projection, int viewport_height) {
+    // Level 0 vertices are one cell apart; at distance d that spacing covers
+    // scale * (viewport_height / 2) * projection[1][1] / d pixels. Range 0 ends where it drops to pixel_error.
+    float pixels_at_unit_distance = 0.5f * static_cast<float>(std::max(viewport_height, 1)) * projection[1][1];
+    float range = scale_ * pixels_at_unit_distance / std::max(pixel_error, 0.1f);
+
+    // A node has to fit between its own range and the next finer one, or levels would skip. With doubling
+    // ranges that holds if range 0 is at least 3 leaf sizes.
+    range = std::max(range, 3.0f * kLeafCells * scale_);
+
+    float previous = 0.0f;
+    for (int level = 0; level < levels_; ++level) {
+        if (level == levels_ - 1) {
+            // The root is always in range and never morphs.
+            ranges_[level] = std::numeric_limits<float>::max();
+            morph_[level] = glm::vec2(std::numeric_limits<float>::max() * 0.5f, std::numeric_limits<float>::max());
+            break;
+        }
+        ranges_[level] = range;
+        morph_[level] = glm::vec2(range - kMorphFraction * (range - previous), range);
+        previous = range;
+        range *= 2.0f;
+    }
+}
+
+bool TerrainLOD::nodeBox(int level, int nr, int nc, glm::vec3& mn, glm::vec3& mx) const {
+    if (nr >= node_rows_[level] || nc >= node_cols_[level])
+        return false;
+
+    int cells = nodeCells(level);
+    int r0 = nr * cells, r1 = std::min(r0 + cells, rows_ - 1);
+    int c0 = nc * cells, c1 = std::min(c0 + cells, cols_ - 1);
+    glm::vec2 range = min_max_[level][static_cast<std::size_t>(nr) * node_cols_[level] + nc];
+
+    mn = glm::vec3(cellX(r0), range.x, cellZ(c0));
+    mx = glm::vec3(cellX(r1), range.y, cellZ(c1));
+    return true;
+}
+
+void TerrainLOD::addQuadrant(int level, int nr, int nc, int quadrant) {
+    int half = nodeCells(level) / 2;
+    int r0 = nr * nodeCells(level) + (quadrant >> 1) * half;
+    int c0 = nc * nodeCells(level) + (quadrant & 1) * half;
+    if (r0 >= rows_ - 1 || c0 >= cols_ - 1)
+        return;     // quadrant beyond the map edge
+
+    instances_.emplace_back(cellX(r0), cellZ(c0),
+        scale_ * static_cast<float>(1 << level), static_cast<float>(level));
+    stats_.coarsest_level = std::max(stats_.coarsest_level, level);
+}
+
+// CDLOD node selection. Returns false if the node is out of its level's range, so the parent has to cover
+// that area itself; true if the node was drawn, culled or does not exist.
+bool TerrainLOD::select(int level, int nr, int nc, Frustum const& frustum, glm::vec3 const& camera) {
+    glm::vec3 mn, mx;
+    if (!nodeBox(level, nr, nc, mn, mx))
+        return true;
+
+    auto inRange = [&](float range) {
+        glm::vec3 closest = glm::clamp(camera, mn, mx);
+        return glm::dot(closest - camera, closest - camera) <= range * range;
+        };
+
+    ++stats_.nodes_visited;
+    if (!inRange(ranges_[level]))
+        return false;
+    if (!frustum.intersects(mn, mx))
+        return true;
+
+    // Finest level, or nothing of the node is close enough for the next finer level: draw all of it here.
+    if (level == 0 || !inRange(ranges_[level - 1])) {
+        for (int q = 0; q < 4; ++q)
+            addQuadrant(level, nr, nc, q);
+        return true;
+    }
+
+    // Children that are out of their range are drawn as quadrants of this node.
+    for (int q = 0; q < 4; ++q) {
+        if (!select(level - 1, nr * 2 + (q >> 1), nc * 2 + (q & 1), frustum, camera))
+            addQuadrant(level, nr, nc, q);
+    }
+    return true;
+}
+
+void TerrainLOD::draw(glm::mat4 const& projection, glm::mat4 const& view, glm::vec3 const& camera_position,
+    int viewport_height, int atlas_layer) {
+    if (!VAO_ || levels_ == 0)
+        return;
+
+    if (tree_dirty_) {
+        refitLeaves();
+        buildParents();
+        tree_dirty_ = false;
+    }
+    updateRanges(projection, viewport_height);
+
+    instances_.clear();
+    stats_ = {};
+    stats_.full_res_triangles = static_cast<std::size_t>(rows_ - 1) * (cols_ - 1) * 2;
+    select(levels_ - 1, 0, 0, Frustum(projection * view), camera_position);
+
+    stats_.patches = instances_.size();
+    stats_.triangles = stats_.patches * kPatchQuads * kPatchQuads * 2;
+    if (instances_.empty())
+        return;
+
+    // Orphan + refill; the buffer only grows.
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(instances_.size() * sizeof(glm::vec4));
+    if (instances_.size() > instance_capacity_) {
+        instance_capacity_ = instances_.size() * 2;
+        glNamedBufferData(instance_buffer_, static_cast<GLsizeiptr>(instance_capacity_ * sizeof(glm::vec4)), nullptr, GL_STREAM_DRAW);
+        glVertexArrayVertexBuffer(VAO_, 1, instance_buffer_, 0, sizeof(glm::vec4));
+    }
+    glNamedBufferSubData(instance_buffer_, 0, bytes, instances_.data());
+
+    if (u_morph_range.valid())
+        glProgramUniform2fv(shader.getID(), u_morph_range.location, levels_, &morph_[0].x);
+
+    RenderState& state = RenderState::get();
+    state.useProgram(shader.getID());
+    state.setInt(u_atlas_layer, atlas_layer);
+    state.bindTextureUnit(kHeightTextureUnit, height_texture_);
+    state.bindVertexArray(VAO_);
+    glDrawElementsInstanced(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(instances_.size()));
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "HeightField.hpp"
+#include "ShaderProgram.hpp"
+#include "Frustum.hpp"
+
+// Continuous distance-dependent LOD terrain (CDLOD) for heightmaps too big for the full-resolution mesh.
+//
+// The heightmap is covered by a quadtree: a leaf node spans kLeafCells x kLeafCells cells at full resolution,
+// every level up doubles the node size and the vertex spacing. Each frame the tree is walked from the root
+// and a node is drawn at the coarsest level whose distance range still contains it, so the triangle count
+// depends on the ranges (derived from an on-screen vertex spacing, `pixel_error`) and not on the map size.
+//
+// All nodes are drawn as quadrants with the same kPatchQuads x kPatchQuads grid, in one instanced draw.
+// Heights come from a float texture in terrain_lod.vert, which also morphs the odd grid vertices onto the
+// next coarser grid over the last part of a level's range, so neighbouring levels meet without cracks.
+class TerrainLOD {
+public:
+    static constexpr int kLeafCells = 32;                  // heightmap cells along a leaf node
+    static constexpr int kPatchQuads = kLeafCells / 2;     // quads along one drawn quadrant
+    static constexpr int kMaxLevels = 16;                  // matches morph_range[] in terrain_lod.vert
+    static constexpr GLuint kHeightTextureUnit = 2;        // 0 = tex0, 1 = atlas
+    static constexpr float kMorphFraction = 0.3f;          // part of a level's range used for morphing
+
+    // Target on-screen spacing of neighbouring vertices, in pixels. Larger = fewer triangles.
+    float pixel_error = 4.0f;
+
+    ShaderProgram shader;   // terrain_lod.vert + lighting_shader.frag, fragment uniforms are set by the app
+
+    struct Stats {
+        std::size_t nodes_visited = 0;
+        std::size_t patches = 0;                // quadrants drawn (instances)
+        std::size_t triangles = 0;
+        std::size_t full_res_triangles = 0;     // what the full-resolution mesh would draw
+        int coarsest_level = 0;                 // coarsest level drawn this frame
+    };
+
+    // GL thread: uploads the heights as a texture and builds the min/max tree. `scale` = world units per cell.
+    TerrainLOD(HeightField const& heights, float scale, ShaderProgram program);
+
+    // Window of `window_cells` over a bigger `map_cells` map (HeightTiles streaming), starting at cell `first_cell`
+    // (row, column). The GL objects are made once for the whole run: heights live in a ring texture of
+    // `ring_cells` (at least the window plus a tile), addressed by map cell modulo its size, so moveWindow()
+    // only changes uniforms and writeHeights() uploads just the tiles that came into view. Heights start at 0.
+    TerrainLOD(glm::ivec2 window_cells, glm::ivec2 ring_cells, float scale, ShaderProgram program,
+        glm::ivec2 first_cell, glm::ivec2 map_cells);
+    ~TerrainLOD();
+
+    TerrainLOD(const TerrainLOD&) = delete;
+    TerrainLOD& operator=(const TerrainLOD&) = delete;
+
+    // Select and draw the visible nodes for this camera (world space; the terrain has no model transform).
+    void draw(glm::mat4 const& projection, glm::mat4 const& view, glm::vec3 const& camera_position,
+        int viewport_height, int atlas_layer);
+
+    // Streamed window only. Start the window at map cell `first_cell`; leaf bounds that are still inside it are
+    // kept (shifted), the others are recomputed from the ring on the next draw.
+    void moveWindow(glm::ivec2 first_cell);
+
+    // Streamed window only. Heights of map cells [first_cell, first_cell + size) into the ring (CPU copy and
+    // texture, split where it wraps); `stride` = floats per row of `heights`. The leaves they touch are refit.
+    void writeHeights(glm::ivec2 first_cell, glm::ivec2 size, float const* heights, int stride);
+
+    int levels() const { return levels_; }
+    Stats const& stats() const { return stats_; }
+
+private:
+    int rows_ = 0, cols_ = 0;
+    float scale_ = 1.0f;
+    glm::ivec2 first_cell_{ 0 }, map_cells_{ 0 };
+    int levels_ = 0;
+
+    // Streamed window: heights by map cell modulo ring_cells_ (same layout as the texture), and the leaves
+    // whose bounds have to be recomputed from it. Empty for the whole-map terrain.
+    glm::ivec2 ring_cells_{ 0 };
+    std::vector<float> ring_;
+    std::vector<std::uint8_t> leaf_dirty_;
+    bool tree_dirty_ = false;
+
+    // Height range per node, level 0 = leaves. Nodes are stored row-major, node_rows_[l] x node_cols_[l].
+    std::vector<std::vector<glm::vec2>> min_max_;
+    std::vector<int> node_rows_, node_cols_;
+
+    // Selection distance and morph start/end per level, recomputed from the projection every frame.
+    float ranges_[kMaxLevels]{};
+    glm::vec2 morph_[kMaxLevels]{};
+
+    GLuint height_texture_{ 0 };
+    GLuint VAO_{ 0 }, VBO_{ 0 }, EBO_{ 0 }, instance_buffer_{ 0 };
+    GLsizei index_count_ = 0;
+    std::size_t instance_capacity_ = 0;
+
+    // Per drawn quadrant: world x/z of its corner, vertex spacing, level (iPatch in terrain_lod.vert).
+    std::vector<glm::vec4> instances_;
+    Stats stats_;
+
+    UniformHandle u_morph_range, u_atlas_layer;
+
+    void init(int rows, int cols, glm::ivec2 texture_cells, GLint wrap);
+    void sizeTree();
+    void buildTree(HeightField const& heights);
+    void buildParents();
+    void refitLeaves();
+    void markLeaves(int r0, int c0, int r1, int c1);
+    void createPatch();
+    void updateRanges(glm::mat4 const& projection, int viewport_height);
+
+    int nodeCells(int level) const { return kLeafCells << level; }
+    // World x of a row / z of a column of the heights; same placement as Heightmap for the whole map.
+    float cellX(int r) const { return (first_cell_.x + r - map_cells_.x / 2.0f) * scale_; }
+    float cellZ(int c) const { return (first_cell_.y + c - map_cells_.y / 2.0f) * scale_; }
+    bool nodeBox(int level, int nr, int nc, glm::vec3& mn, glm::vec3& mx) const;
+    void addQuadrant(int level, int nr, int nc, int quadrant);
+    bool select(int level, int nr, int nc, Frustum const& frustum, glm::vec3 const& camera);
+};
@@ -0,0 +1,76 @@
+#include "TextureCache.hpp"
+
+namespace {
+
+std::size_t imageBytes(const cv::Mat& image) {
+    return image.total() * image.elemSize();
+}
+
+} // namespace
+
+std::shared_ptr<const cv::Mat> TextureCache::image(const std::filesystem::path& path) {
+    const std::string key = path.lexically_normal().generic_string();
+
+    std::promise<std::shared_ptr<const cv::Mat>> promise;
+    ImageFuture future;
+    bool decode = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = images_.find(key);
+        if (it != images_.end()) {
+            future = it->second;
+        }
+        else {
+            future = promise.get_future().share();
+            images_.emplace(key, future);
+            decode = true;
+            ++stats_.image_misses;
+        }
+    }
+
+    if (decode) {
+        // Decode outside the lock; other threads asking for the same file wait on the future.
+        promise.set_value(std::make_shared<const cv::Mat>(cv::imread(path.string(), cv::IMREAD_UNCHANGED)));
+        return future.get();
+    }
+
+    std::shared_ptr<const cv::Mat> image = future.get();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.image_hits;
+    stats_.decode_bytes_saved += imageBytes(*image);
+    return image;
+}
+
+void TextureCache::releaseImages() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    images_.clear();
+}
+
+TextureHandle TextureCache::acquire(const std::string& key, bool& created) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto texture = textures_[key].lock()) {
+        created = false;
+        ++stats_.texture_hits;
+        stats_.upload_bytes_saved += texture->bytes;
+        return texture;
+    }
+
+    created = true;
+    ++stats_.texture_misses;
+    auto texture = std::make_shared<CachedTexture>();
+    textures_[key] = texture;
+    return texture;
+}
+
+TextureCache::Stats TextureCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void TextureCache::report(std::ostream& out) const {
+    const Stats s = stats();
+    out << "[TextureCache] images: " << s.image_hits << " hits, " << s.image_misses << " misses, "
+        << s.decode_bytes_saved / 1024 << " KiB of decoding saved\n"
+        << "[TextureCache] textures: " << s.texture_hits << " hits, " << s.texture_misses << " misses, "
+        << s.upload_bytes_saved / 1024 << " KiB of uploads saved\n";
+}
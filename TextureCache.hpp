@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+#include <GL/glew.h>
+
+#include "RenderState.hpp"
+
+// One GL texture shared by every user of the same file (or atlas array).
+// `id` is 0 until it is uploaded; `done` is also set when loading failed. The GL texture is
+// deleted together with the last handle, so drop handles while the context is still alive.
+struct CachedTexture {
+    GLuint id = 0;
+    bool done = false;
+    std::size_t bytes = 0;      // decoded size, for the "bytes saved" statistics
+
+    CachedTexture() = default;
+    CachedTexture(const CachedTexture&) = delete;
+    CachedTexture& operator=(const CachedTexture&) = delete;
+    ~CachedTexture() {
+        if (id) {
+            RenderState::get().forgetTexture(id);
+            glDeleteTextures(1, &id);
+        }
+    }
+};
+using TextureHandle = std::shared_ptr<CachedTexture>;
+
+// Path-keyed cache owned by the app:
+//  - decoded images: each file is decoded once, also when several workers ask for it at the same time,
+//    and kept until releaseImages() (so every texture made from an atlas shares one decode);
+//  - GL textures: one refcounted handle per key (file path or atlas array), reused while anyone holds it.
+class TextureCache {
+public:
+    struct Stats {
+        std::size_t image_hits = 0;
+        std::size_t image_misses = 0;
+        std::size_t texture_hits = 0;
+        std::size_t texture_misses = 0;
+        std::size_t decode_bytes_saved = 0;     // decoded bytes served from the cache instead of imread
+        std::size_t upload_bytes_saved = 0;     // texel bytes not uploaded again thanks to texture hits
+    };
+
+    // Decoded image (cv::IMREAD_UNCHANGED); empty if the file can not be read. Thread-safe.
+    std::shared_ptr<const cv::Mat> image(const std::filesystem::path& path);
+
+    // Forget decoded images (call once nothing is being cut from them any more). Thread-safe.
+    void releaseImages();
+
+    // GL thread: live handle for `key` (file path, or path + "#..." for derived textures),
+    // or a new empty one (`created` = true) that the caller uploads.
+    TextureHandle acquire(const std::string& key, bool& created);
+
+    Stats stats() const;
+    void report(std::ostream& out = std::cout) const;
+
+private:
+    using ImageFuture = std::shared_future<std::shared_ptr<const cv::Mat>>;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ImageFuture> images_;
+    std::unordered_map<std::string, std::weak_ptr<CachedTexture>> textures_;
+    Stats stats_;
+};
@@ -0,0 +1,120 @@
+#include "TransparencyPass.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+#include "RenderState.hpp"
+
+bool TransparencyPass::create(std::filesystem::path const& vertex_file, std::filesystem::path const& fragment_file) {
+    destroy();
+    try {
+        program_ = ShaderProgram(vertex_file, fragment_file);
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Order-independent transparency disabled: " << e.what();
+        program_ = ShaderProgram();
+        return false;
+    }
+    u_accum_ = program_.uniform("accum");
+    u_revealage_ = program_.uniform("revealage");
+    glCreateVertexArrays(1, &empty_vao_);
+    glObjectLabel(GL_VERTEX_ARRAY, empty_vao_, -1, "OitCompositeVAO");
+    return true;
+}
+
+void TransparencyPass::destroy() {
+    destroyTargets();
+    if (ready())
+        program_.clear();
+    if (empty_vao_) {
+        RenderState::get().forgetVertexArray(empty_vao_);
+        glDeleteVertexArrays(1, &empty_vao_);
+    }
+    empty_vao_ = 0;
+}
+
+void TransparencyPass::destroyTargets() {
+    if (fbo_) glDeleteFramebuffers(1, &fbo_);
+    for (GLuint texture : { accum_, revealage_ })
+        if (texture) {
+            RenderState::get().forgetTexture(texture);
+            glDeleteTextures(1, &texture);
+        }
+    fbo_ = accum_ = revealage_ = depth_ = 0;
+    width_ = height_ = 0;
+}
+
+bool TransparencyPass::resize(SceneTarget const& scene) {
+    if (!ready() || !scene.ready())
+        return false;
+    if (fbo_ && depth_ == scene.depthTexture() && width_ == scene.width() && height_ == scene.height())
+        return true;
+    destroyTargets();
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &accum_);
+    glObjectLabel(GL_TEXTURE, accum_, -1, "OitAccum");
+    glTextureStorage2D(accum_, 1, GL_RGBA16F, scene.width(), scene.height());
+    glCreateTextures(GL_TEXTURE_2D, 1, &revealage_);
+    glObjectLabel(GL_TEXTURE, revealage_, -1, "OitRevealage");
+    glTextureStorage2D(revealage_, 1, GL_R8, scene.width(), scene.height());
+
+    glCreateFramebuffers(1, &fbo_);
+    glObjectLabel(GL_FRAMEBUFFER, fbo_, -1, "OitFBO");
+    glNamedFramebufferTexture(fbo_, GL_COLOR_ATTACHMENT0, accum_, 0);
+    glNamedFramebufferTexture(fbo_, GL_COLOR_ATTACHMENT1, revealage_, 0);
+    glNamedFramebufferTexture(fbo_, GL_DEPTH_ATTACHMENT, scene.depthTexture(), 0);
+    const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(fbo_, 2, buffers);
+
+    GLenum status = glCheckNamedFramebufferStatus(fbo_, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "OIT framebuffer incomplete (0x" << std::hex << status << std::dec << "), transparency stays sorted\n";
+        destroyTargets();
+        return false;
+    }
+    depth_ = scene.depthTexture();
+    width_ = scene.width();
+    height_ = scene.height();
+    return true;
+}
+
+void TransparencyPass::begin() {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat one[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glClearNamedFramebufferfv(fbo_, GL_COLOR, 0, zero);
+    glClearNamedFramebufferfv(fbo_, GL_COLOR, 1, one);
+
+    // Sum of the weighted colors; revealage multiplied by (1 - alpha) of every fragment.
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+}
+
+void TransparencyPass::end() {
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);     // as set up in App::init()
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_CULL_FACE);
+}
+
+void TransparencyPass::composite(SceneTarget const& scene) {
+    scene.bind();
+    RenderState& state = RenderState::get();
+    state.useProgram(program_.getID());
+    state.setInt(u_accum_, static_cast<int>(kAccumUnit));
+    state.setInt(u_revealage_, static_cast<int>(kRevealageUnit));
+    state.bindTextureUnit(kAccumUnit, accum_);
+    state.bindTextureUnit(kRevealageUnit, revealage_);
+    state.bindVertexArray(empty_vao_);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_BLEND);
+}
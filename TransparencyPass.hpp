@@ -0,0 +1,44 @@
+#pragma once
+
+#include <filesystem>
+#include <GL/glew.h>
+
+#include "SceneTarget.hpp"
+#include "ShaderProgram.hpp"
+
+// Weighted blended order-independent transparency (McGuire & Bavoil 2013). Between begin() and end() transparent
+// meshes are drawn in any order into two targets that share the scene's depth (tested, not written): an RGBA16F
+// sum of weighted premultiplied colors and an R8 product of (1 - alpha). composite() resolves them onto the
+// scene's color. The lighting shader writes both outputs when its `oit` uniform is set.
+// GL thread only; destroy() while the context is alive.
+class TransparencyPass {
+public:
+    static constexpr GLuint kAccumUnit = 4;         // sampler units of the composite (0-3 are the mesh/terrain/Hi-Z textures)
+    static constexpr GLuint kRevealageUnit = 5;
+
+    // Compile the composite program; false (and transparency stays sorted) if that fails.
+    bool create(std::filesystem::path const& vertex_file = "oit_composite.vert",
+        std::filesystem::path const& fragment_file = "oit_composite.frag");
+    void destroy();
+    bool ready() const { return program_.getID() != 0; }
+
+    // (Re)create the targets for `scene` (same size, its depth attached); false if incomplete.
+    bool resize(SceneTarget const& scene);
+
+    // Bind the targets, clear them and set the blend state; end() restores what the opaque pass expects.
+    void begin();
+    void end();
+
+    // Blend the resolved transparency onto `scene`'s color (`scene` stays bound).
+    void composite(SceneTarget const& scene);
+
+private:
+    void destroyTargets();
+
+    ShaderProgram program_;
+    UniformHandle u_accum_, u_revealage_;
+    GLuint fbo_ = 0, accum_ = 0, revealage_ = 0;
+    GLuint empty_vao_ = 0;          // the full-screen triangle has no attributes
+    GLuint depth_ = 0;              // scene depth texture the targets were made for
+    int width_ = 0, height_ = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// CPU mirrors of the std140 uniform blocks in lighting_shader.vert/.frag.
+// Binding points are fixed in the shaders, so every program sees the same buffers.
+constexpr GLuint kFrameBlockBinding = 0;
+constexpr GLuint kLightsBlockBinding = 1;
+constexpr int kMaxLights = 4;   // MAX_LIGHTS in lighting_shader.frag
+
+// One `s_lights` entry; each vec3 shares its 16-byte slot with the float after it.
+struct LightStd140 {
+    glm::vec4 position{ 0.0f };             // w == 0 directional, 1 point/spot
+    glm::vec3 ambientM{ 0.0f };
+    float consAttenuation = 1.0f;
+    glm::vec3 diffuseM{ 0.0f };
+    float linAttenuation = 0.0f;
+    glm::vec3 specularM{ 0.0f };
+    float quadAttenuation = 0.0f;
+    glm::vec3 direction{ 0.0f };
+    float cutoff = 180.0f;                  // degrees, 180 = point light
+    float exponent = 0.0f;
+    float pad_[3]{};
+};
+static_assert(sizeof(LightStd140) == 96, "LightStd140 must match the std140 layout of s_lights");
+
+struct LightsStd140 {
+    LightStd140 lights[kMaxLights];
+};
+
+// Block "Frame": camera and fog, written once per frame.
+struct FrameStd140 {
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::vec4 camera_position{ 0.0f };
+    glm::vec4 fog_color{ glm::vec3(0.85f), 1.0f };
+    float near_plane = 0.1f;
+    float far_plane = 300.0f;
+    float pad_[2]{};
+};
+static_assert(sizeof(FrameStd140) == 176, "FrameStd140 must match the std140 layout of the Frame block");
+
+// Uniform buffer holding one block: edit `data` freely, upload() sends it with a single glNamedBufferSubData.
+template <typename Block>
+class UniformBuffer {
+public:
+    Block data{};
+
+    // Create the buffer and bind it to its binding point for good.
+    void create(GLuint binding, const char* label) {
+        glCreateBuffers(1, &ID);
+        glObjectLabel(GL_BUFFER, ID, -1, label);
+        glNamedBufferStorage(ID, sizeof(Block), &data, GL_DYNAMIC_STORAGE_BIT);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+    }
+
+    void upload() const {
+        if (ID) glNamedBufferSubData(ID, 0, sizeof(Block), &data);
+    }
+
+    void clear() {
+        glDeleteBuffers(1, &ID);
+        ID = 0;
+    }
+
+    GLuint getID() const { return ID; }
+
+private:
+    GLuint ID{ 0 };
+};
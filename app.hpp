@@ -7,13 +7,29 @@
 #include <opencv2/opencv.hpp>
 #include <unordered_map>
 #include <chrono>
+#include <memory>
 #include <irrKlang/irrKlang.h>
 
 #include "assets.hpp"
 #include "Model.hpp"
+#include "InstancedModel.hpp"
 #include "camera.hpp"
 #include "Heightmap.hpp"
+#include "TerrainLOD.hpp"
+#include "HeightTiles.hpp"
+#include "SpatialHash.hpp"
+#include "Scene.hpp"
+#include "GeometryArena.hpp"
+#include "IndirectDrawList.hpp"
+#include "GpuCulling.hpp"
+#include "HiZPyramid.hpp"
+#include "SceneTarget.hpp"
+#include "TransparencyPass.hpp"
 #include "FaceTracker.hpp"
+#include "AssetLoader.hpp"
+#include "TextureCache.hpp"
+#include "StartupProfile.hpp"
+#include "UniformBlocks.hpp"
 
 class App {
 public:
@@ -30,6 +46,9 @@ public:
     // Load models/textures/sounds and prepare the scene.
     void init_assets(void);
 
+    // Per frame: upload streamed assets within a time budget (objects appear in `scene` when ready).
+    void update_assets(void);
+
     // Update FPS counter and (usually) update the window title/debug output.
     void updateFPS(void);
 
@@ -39,8 +58,24 @@ public:
     // Toggle between windowed and fullscreen and keep last window placement.
     void switch_to_fullscreen(void);
 
-    // Sample terrain height from the heightmap for world position (x,z).
-    float getTerrainHeight(float x, float z, const std::vector<std::vector<float>>& heightmap) const;
+    // Sample terrain height from the heightmap (or the streamed tiles) for world position (x,z).
+    float getTerrainHeight(float x, float z) const;
+
+    // Heights at `count` world (x, z) positions in one batch (HeightField's SIMD sample()).
+    void getTerrainHeights(glm::vec2 const* xz, float* out, std::size_t count) const;
+
+    // Before init(): terrain from `file` (a heightmap or a .tiles file; empty keeps terrain_file), streamed tile by
+    // tile if `streamed` (a .tiles file always is). From the command line: --terrain <file>, --stream-terrain.
+    void set_terrain(std::filesystem::path const& file, bool streamed);
+
+    // Per frame with terrain_streaming: load/evict tiles around the camera and move the LOD window with it.
+    void update_terrain_streaming(void);
+
+    // Keep a scene entity in the collision grid: added once it is solid, moved with it, dropped when it is not.
+    void sync_collider(Scene::Handle entity);
+
+    // Add every instance of a solid instanced[name] to the collision grid (instances do not move).
+    void add_colliders(std::string const& name);
 
     //------ Texture helpers ------
     // Load texture from disk and upload it to GPU.
@@ -49,6 +84,9 @@ public:
     // Create a GL texture from an OpenCV Mat.
     GLuint gen_tex(cv::Mat& image);
 
+    // Create a GL_TEXTURE_2D_ARRAY (one layer + mip chain per tile) from a square-tiled atlas.
+    GLuint gen_tex_array(cv::Mat& atlas, int tilesPerRow);
+
     // Clean up all resources (GL, audio, capture, etc.).
     ~App();
 
@@ -113,6 +151,7 @@ private:
     TimePoint last_time;
     int frame_count;
     int fps = 0;
+    double terrain_submit_ms = 0.0;    // terrain draw call CPU time summed over the current FPS interval
 
     //------ 3D sound ------
     // irrKlang engines for positional audio and background music.
@@ -123,6 +162,9 @@ private:
     glm::vec3 throw_start = glm::vec3(0.0f);
     glm::vec3 throw_dir = glm::vec3(0.0f);
     Model projectile;
+    std::vector<std::size_t> airborne;      // per frame: scene indices of the projectiles in flight
+    std::vector<glm::vec2> airborne_xz;     // per substep: their (x, z), and the terrain height under them
+    std::vector<float> airborne_ground;
 
     // Latest face tracking output mapped into world-space-ish direction/position.
     glm::vec3 FaceTracResult = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -141,13 +183,114 @@ protected:
     Camera camera;
     ShaderProgram my_shader;
 
+    // my_shader uniforms updated per object, looked up once after the shader is built.
+    struct SceneUniforms {
+        UniformHandle model, normal_matrix, color, oit;
+    } u;
+
+    // Camera/fog and light blocks shared by every program; edit `data`, run() uploads both once per frame.
+    UniformBuffer<FrameStd140> frame_ubo;
+    UniformBuffer<LightsStd140> lights_ubo;
+
     // Main texture used by the scene (or UI) if only one is needed.
     GLuint my_texture;
 
     Heightmap Ground;
 
-    // All scene objects addressable by a string key.
-    std::unordered_map<std::string, Model> scene;
+    // Terrain source; large maps (e.g. resources/heightmaps/iceland_heightmap.png) should start in LOD mode,
+    // or streamed (set_terrain(), i.e. --terrain <file> --stream-terrain).
+    std::filesystem::path terrain_file = "resources/heightmaps/ground_v1.png";
+
+    // CDLOD terrain drawn instead of Ground's chunk mesh (G toggles). On at startup, the full mesh is never built.
+    bool terrain_lod_enabled = false;
+    std::unique_ptr<TerrainLOD> terrain_lod;
+
+    // Streamed terrain for maps that should not be held whole (e.g. 16-bit or float maps of 8k+ cells): heights
+    // come tile by tile from `<terrain_file>.tiles` (written on the first start, or terrain_file is a .tiles
+    // file) within the tile budget, and terrain_lod covers a window of kTerrainWindowTiles^2 tiles around the
+    // camera. The window is made once; moving it only writes the tiles that came into view into its ring texture.
+    bool terrain_streaming = false;
+    static constexpr int kTerrainWindowTiles = 5;
+    static constexpr int kTerrainRingTiles = kTerrainWindowTiles + 2;  // a window off the tile grid touches one more, plus a border row
+    static constexpr std::size_t kTerrainTileBudget = 48;
+    HeightTiles terrain_tiles;
+    glm::ivec2 terrain_window_first{ -1 };          // first cell (row, column) of terrain_lod's window
+    std::size_t terrain_window_fallback = 0;        // tiles of that window still drawn from the overview
+    std::uint64_t terrain_window_loads = 0;         // terrain_tiles loads at the last update of the window
+
+    // Tiles whose heights are in terrain_lod's ring, and whether they were the real tile or the overview.
+    struct RingTile {
+        int tr = 0, tc = 0;
+        bool exact = false;
+    };
+    std::vector<RingTile> terrain_ring_tiles;
+    std::vector<float> terrain_tile_heights;        // scratch for overview-filled tiles
+
+    // Single scene objects (crate, lamps, plane, thrown rocks) as entities; names only for lookups.
+    Scene scene;
+
+    // Repeated objects (cacti, rocks): one instanced draw per entry, collision goes through the instances.
+    std::unordered_map<std::string, InstancedModel> instanced;
+
+    // View-frustum culling of the scene entities and instances by their world boxes (O toggles, to compare).
+    // Counts are from the last frame, the culling time is summed over the current FPS interval.
+    bool object_culling = true;
+    struct ObjectCullStats {
+        std::size_t scene_total = 0, scene_visible = 0;
+        std::size_t instances_total = 0, instances_visible = 0;
+    } object_cull_stats;
+    double object_cull_ms = 0.0;
+
+    // Instance culling in a compute pass (B switches to the CPU test above, to compare). Off if the compute
+    // program did not build.
+    bool gpu_instance_culling = true;
+    GpuCulling instance_culler;
+
+    // Hi-Z occlusion of the instances (H toggles, to compare). The frame is drawn into scene_target; after the
+    // terrain and the opaque entities its depth is reduced into `hiz`, and the compute pass above drops the
+    // instances hidden behind it. Needs the compute culling and the offscreen target.
+    bool occlusion_culling = true;
+    bool occlusion_active = false;      // the test ran in the last frame (toggle, O, target and program all allow it)
+    SceneTarget scene_target;
+    HiZPyramid hiz;
+
+    // Transparent entities through weighted blended OIT, unsorted and queued in one indirect batch (J switches
+    // back to the painter's sort, to compare; also used without the offscreen target). CPU time for sorting and
+    // submitting them summed over the current FPS interval.
+    bool order_independent_transparency = true;
+    TransparencyPass transparency;
+    IndirectDrawList transparent_draws;
+    std::size_t transparent_count = 0;      // last frame
+    double transparent_ms = 0.0;
+
+    // Opaque scene meshes from the geometry arena, one glMultiDrawElementsIndirect per texture (K toggles,
+    // to compare with one draw call per mesh). Submission CPU time summed over the current FPS interval.
+    bool indirect_draws = true;
+    IndirectDrawList scene_draws;
+    double scene_submit_ms = 0.0;
+
+    // Collision broadphase over the solid scene models and instances, keyed by their world AABBs.
+    // Grid ids map to the objects through `colliders` (instanced nodes never move, so the pointers hold).
+    struct Collider {
+        Scene::Handle entity;                       // scene entity, or
+        std::string const* batch_name = nullptr;    // one instance of a batch
+        InstancedModel const* batch = nullptr;
+        std::size_t instance = 0;
+    };
+    static constexpr float kCollisionCellSize = 4.0f;
+    SpatialHash collision_grid{ kCollisionCellSize };
+    std::vector<Collider> colliders;                            // by SpatialHash::Id
+    std::vector<SpatialHash::Id> collision_hits;                // query scratch
+
+    // Decoded images + shared GL textures, keyed by path (declared before `assets`, which uses it).
+    TextureCache texture_cache;
+    TextureHandle atlas_texture;       // atlas array, bound to texture unit 1 once loaded
+
+    // Background texture/mesh loading started by init_assets() and pumped by update_assets().
+    std::unique_ptr<AssetLoader> assets;
+    StartupProfile::Clock::time_point assets_start{};
+    bool first_frame_reported = false;
+    bool assets_reported = false;
 
     FaceTracker tracker;
 };
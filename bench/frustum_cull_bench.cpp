@@ -0,0 +1,88 @@
+// Object culling benchmark: Frustum::intersects() once per box (one AABB at a time, as the terrain chunks are
+// tested) against Frustum::cull() over a Frustum::BoxList, for growing object counts scattered like the cacti
+// and rocks around a camera that turns on the spot. The visible flags of both ways are compared.
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -I. bench/frustum_cull_bench.cpp Frustum.cpp -o frustum_cull_bench
+// (add -mavx2 for the AVX2 path; the GLM include path of the app has to be on the include path as well).
+// Options: --area N (side of the square the objects are scattered over, default 400), --frames N (default 2000).
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Frustum.hpp"
+
+int main(int argc, char** argv) {
+    float area = 400.0f;
+    int frames = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--area" && i + 1 < argc) area = std::max(10.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (arg == "--frames" && i + 1 < argc) frames = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: frustum_cull_bench [--area N] [--frames N]\n";
+            return 1;
+        }
+    }
+
+    // App::update_projection_matrix at 16:9.
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    std::cout << std::fixed << std::setprecision(3) << "objects over " << area << " x " << area << ", " << frames
+        << " frames, cull() path " << Frustum::simdPath() << "\n";
+
+    bool ok = true;
+    for (int count : { 140, 1000, 10000, 100000 }) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> pos(-area * 0.5f, area * 0.5f), size(0.2f, 3.0f);
+
+        std::vector<glm::vec3> mins(static_cast<std::size_t>(count)), maxs(mins.size());
+        Frustum::BoxList boxes;
+        boxes.resize(mins.size());
+        for (std::size_t i = 0; i < mins.size(); ++i) {
+            glm::vec3 c(pos(rng), 0.0f, pos(rng));
+            glm::vec3 half(size(rng) * 0.5f, size(rng), size(rng) * 0.5f);
+            mins[i] = c - half;
+            maxs[i] = c + half;
+            boxes.set(i, mins[i], maxs[i]);
+        }
+
+        std::vector<std::uint8_t> expected(mins.size()), visible(mins.size());
+        std::size_t total_visible = 0;
+        double single_s = 0.0, batch_s = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            float yaw = static_cast<float>(f) * 0.01f;
+            glm::vec3 eye(0.0f, 15.0f, 0.0f);
+            glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(std::cos(yaw), -0.2f, std::sin(yaw)), glm::vec3(0, 1, 0));
+            const Frustum frustum(projection * view);
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < mins.size(); ++i)
+                expected[i] = frustum.intersects(mins[i], maxs[i]) ? 1 : 0;
+            auto t1 = std::chrono::steady_clock::now();
+            total_visible += frustum.cull(boxes, visible.data());
+            auto t2 = std::chrono::steady_clock::now();
+
+            single_s += std::chrono::duration<double>(t1 - t0).count();
+            batch_s += std::chrono::duration<double>(t2 - t1).count();
+            if (visible != expected)
+                ok = false;
+        }
+
+        std::cout << std::setw(7) << count << " objects: intersects " << single_s * 1e6 / frames << " us/frame, cull "
+            << batch_s * 1e6 / frames << " us/frame (x" << single_s / batch_s << "), "
+            << static_cast<double>(total_visible) / frames << " visible/frame\n";
+    }
+
+    if (!ok) {
+        std::cerr << "MISMATCH\n";
+        return 1;
+    }
+    return 0;
+}
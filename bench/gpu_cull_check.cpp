@@ -0,0 +1,322 @@
+// Check of the GPU instance culling (GpuCulling + cull_instances.comp) against the CPU test (Frustum::cull) on a
+// headless EGL context, so it also runs on Mesa llvmpipe in CI. Random instances with rotated and scaled boxes
+// are culled by both for a camera that turns on the spot; the instance count in every indirect command and the
+// set of matrices written to the visible buffer have to match the CPU result. Every frame the culled instances
+// are then drawn with Mesh::drawInstancedIndirect (bench/gpu_cull_check.vert records the matrix each drawn
+// instance fetched), which has to give 12 triangles per visible instance and the same matrices. Then the Hi-Z
+// occlusion test (HiZPyramid + hiz_build.comp): the depth of a wall is cleared into a SceneTarget, once over the
+// whole screen (everything behind it has to go, everything in front of it has to stay) and once over the left
+// half only (nothing that reaches past the wall or into the right half may go). Exits with 1 on any mismatch.
+//
+// Standalone program, not part of my_app.vcxproj; .github/workflows/gpu-cull-check.yml builds and runs it on
+// ubuntu-24.04 (libglew-dev libglm-dev libegl-dev libgl-dev libgl1-mesa-dri). From the repo root:
+//   mkdir -p _ci/GL && echo '#include <GL/glew.h>' > _ci/GL/wglew.h     # assets.hpp wants the Windows header
+//   g++ -O2 -std=c++17 -I_ci -I. bench/gpu_cull_check.cpp GpuCulling.cpp HiZPyramid.cpp SceneTarget.cpp \
+//       ShaderProgram.cpp RenderState.cpp Frustum.cpp GeometryArena.cpp -lGLEW -lEGL -lGL -o gpu_cull_check
+//   LIBGL_ALWAYS_SOFTWARE=1 ./gpu_cull_check
+// Options: --count N (instances, default 20000), --frames N (default 32).
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Frustum.hpp"
+#include "GpuCulling.hpp"
+#include "HiZPyramid.hpp"
+#include "Mesh.hpp"
+#include "SceneTarget.hpp"
+
+namespace {
+
+// Surfaceless core 4.5 context (what llvmpipe offers; the compute pass needs nothing newer).
+bool makeContext() {
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    EGLDisplay display = getPlatformDisplay
+        ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+        : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API))
+        return false;
+
+    const EGLint attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        return false;
+
+    // GLEW built for GLX loads the GL entry points first and only then fails to find a GLX display.
+    glewExperimental = GL_TRUE;
+    GLenum err = glewInit();
+    return err == GLEW_OK || err == GLEW_ERROR_NO_GLX_DISPLAY;
+}
+
+// Translation column of a matrix, rounded, to compare the GPU's unordered output with the CPU's list.
+std::array<long long, 3> key(glm::mat4 const& m) {
+    return { std::llround(m[3][0] * 1000.0f), std::llround(m[3][1] * 1000.0f), std::llround(m[3][2] * 1000.0f) };
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int count = 20000;
+    int frames = 32;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--count" && i + 1 < argc) count = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--frames" && i + 1 < argc) frames = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: gpu_cull_check [--count N] [--frames N]\n";
+            return 1;
+        }
+    }
+
+    if (!makeContext()) {
+        std::cerr << "no OpenGL 4.5 core context\n";
+        return 1;
+    }
+    std::cout << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << '\n';
+
+    GpuCulling culler;
+    if (!culler.create())
+        return 1;
+
+    // Instances as InstancedModel lays them out: matrices plus the world box of a unit cube.
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(-200.0f, 200.0f), size(0.2f, 3.0f), angle(0.0f, 6.2831853f);
+    const std::size_t n = static_cast<std::size_t>(count);
+    std::vector<GpuCulling::Instance> source(n);
+    std::vector<glm::mat4> models(n);
+    Frustum::BoxList boxes;
+    boxes.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(pos(rng), 0.0f, pos(rng)));
+        m = glm::rotate(m, angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+        m = glm::scale(m, glm::vec3(size(rng)));
+        models[i] = m;
+        boxes.setTransformed(i, m, glm::vec3(-0.5f), glm::vec3(0.5f));
+
+        source[i].model = m;
+        glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(m)));
+        for (int col = 0; col < 3; ++col)
+            source[i].normal[col] = glm::vec4(normal[col], 0.0f);
+        source[i].box_min = glm::vec4(boxes.min_x[i], boxes.min_y[i], boxes.min_z[i], 0.0f);
+        source[i].box_max = glm::vec4(boxes.max_x[i], boxes.max_y[i], boxes.max_z[i], 0.0f);
+    }
+
+    GLuint source_buffer = 0, visible_buffer = 0, command_buffer = 0;
+    glCreateBuffers(1, &source_buffer);
+    glNamedBufferData(source_buffer, static_cast<GLsizeiptr>(n * sizeof(GpuCulling::Instance)), source.data(), GL_STATIC_DRAW);
+    glCreateBuffers(1, &visible_buffer);
+    glNamedBufferData(visible_buffer, static_cast<GLsizeiptr>(n * sizeof(Mesh::InstanceData)), nullptr, GL_DYNAMIC_DRAW);
+
+    // Two meshes, so both commands have to end up with the same count.
+    const IndirectDrawList::Command templates[2] = { { 36, 7, 0, 0, 0 }, { 24, 7, 36, 8, 0 } };
+    glCreateBuffers(1, &command_buffer);
+    glNamedBufferData(command_buffer, sizeof(templates), nullptr, GL_DYNAMIC_DRAW);
+
+    // The draw side: a unit cube (8 vertices, 36 indices, so it fits command 0) drawn the way InstancedModel
+    // draws its meshes. Its vertex shader records what every drawn instance fetched from the visible buffer.
+    std::vector<vertex> cube_vertices;
+    for (int c = 0; c < 8; ++c) {
+        glm::vec3 p((c & 1) ? 0.5f : -0.5f, (c & 2) ? 0.5f : -0.5f, (c & 4) ? 0.5f : -0.5f);
+        cube_vertices.push_back({ p, glm::normalize(p), glm::vec2(p.x, p.z) + 0.5f });
+    }
+    const std::vector<GLuint> cube_indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+        2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+    ShaderProgram draw_shader("bench/gpu_cull_check.vert", "bench/gpu_cull_check.frag");
+    const Mesh cube(GL_TRIANGLES, draw_shader, cube_vertices, cube_indices, glm::vec3(0.0f), glm::vec3(0.0f));
+    cube.attachInstanceBuffer(visible_buffer);
+    SceneTarget target;     // a surfaceless context has no default framebuffer to draw into
+    if (!target.resize(1280, 720)) {
+        std::cerr << "no scene target\n";
+        return 1;
+    }
+    GLuint drawn_buffer = 0, primitives_query = 0;
+    glCreateBuffers(1, &drawn_buffer);
+    glNamedBufferData(drawn_buffer, static_cast<GLsizeiptr>(n * sizeof(glm::vec4)), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, drawn_buffer);
+    glCreateQueries(GL_PRIMITIVES_GENERATED, 1, &primitives_query);
+    std::vector<glm::vec4> drawn(n);
+
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    std::vector<std::uint8_t> expected(n);
+    std::vector<Mesh::InstanceData> visible(n);
+    bool ok = true;
+    double gpu_ms = 0.0;
+    std::size_t total_visible = 0, total_drawn = 0;
+    for (int f = 0; f < frames; ++f) {
+        float yaw = static_cast<float>(f) * 6.2831853f / static_cast<float>(frames);
+        glm::vec3 eye(0.0f, 15.0f, 0.0f);
+        const Frustum frustum(projection * glm::lookAt(eye, eye + glm::vec3(std::cos(yaw), -0.2f, std::sin(yaw)), glm::vec3(0, 1, 0)));
+
+        std::size_t cpu_count = frustum.cull(boxes, expected.data());
+
+        auto t0 = std::chrono::steady_clock::now();
+        culler.run(frustum, source_buffer, n, visible_buffer, command_buffer, templates, 2);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        IndirectDrawList::Command commands[2];
+        glGetNamedBufferSubData(command_buffer, 0, sizeof(commands), commands);
+        gpu_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        bool frame_ok = commands[0].instance_count == cpu_count && commands[1].instance_count == cpu_count
+            && commands[0].count == templates[0].count && commands[1].base_vertex == templates[1].base_vertex;
+        std::vector<std::array<long long, 3>> cpu_keys;
+        if (frame_ok && cpu_count > 0) {
+            glGetNamedBufferSubData(visible_buffer, 0, static_cast<GLsizeiptr>(cpu_count * sizeof(Mesh::InstanceData)), visible.data());
+            std::vector<std::array<long long, 3>> gpu_keys;
+            for (std::size_t i = 0; i < cpu_count; ++i)
+                gpu_keys.push_back(key(visible[i].model));
+            for (std::size_t i = 0; i < n; ++i)
+                if (expected[i])
+                    cpu_keys.push_back(key(models[i]));
+            std::sort(gpu_keys.begin(), gpu_keys.end());
+            std::sort(cpu_keys.begin(), cpu_keys.end());
+            frame_ok = gpu_keys == cpu_keys;
+        }
+        if (!frame_ok) {
+            std::cerr << "frame " << f << ": GPU kept " << commands[0].instance_count << "/" << commands[1].instance_count
+                << ", CPU " << cpu_count << '\n';
+            ok = false;
+            continue;
+        }
+
+        // Draw command 0 with rasterization off: 12 triangles per visible instance, each instance with the
+        // matrix of one visible box.
+        target.bind();
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBeginQuery(GL_PRIMITIVES_GENERATED, primitives_query);
+        cube.drawInstancedIndirect(command_buffer, 0, -1, visible_buffer);
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+        glDisable(GL_RASTERIZER_DISCARD);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        GLuint primitives = 0;
+        glGetQueryObjectuiv(primitives_query, GL_QUERY_RESULT, &primitives);
+        std::vector<std::array<long long, 3>> drawn_keys;
+        if (cpu_count > 0) {
+            glGetNamedBufferSubData(drawn_buffer, 0, static_cast<GLsizeiptr>(cpu_count * sizeof(glm::vec4)), drawn.data());
+            for (std::size_t i = 0; i < cpu_count; ++i)
+                drawn_keys.push_back(key(glm::translate(glm::mat4(1.0f), glm::vec3(drawn[i]))));
+            std::sort(drawn_keys.begin(), drawn_keys.end());
+        }
+        if (primitives != cpu_count * 12 || drawn_keys != cpu_keys) {
+            std::cerr << "frame " << f << ": indirect draw made " << primitives << " triangles for " << cpu_count
+                << " instances, " << (drawn_keys == cpu_keys ? "same" : "other") << " matrices\n";
+            ok = false;
+        }
+        total_drawn += primitives / 12;
+        total_visible += cpu_count;
+    }
+
+    std::cout << std::fixed << std::setprecision(3) << count << " instances, " << frames << " frames: "
+        << static_cast<double>(total_visible) / frames << " visible/frame, " << gpu_ms / frames
+        << " ms/frame dispatch + readback, " << static_cast<double>(total_drawn) / frames
+        << " instances/frame drawn through Mesh::drawInstancedIndirect, glGetError " << glGetError() << '\n';
+
+    // Hi-Z: camera looking down -z from the origin, the wall at distance 60 in front of it.
+    HiZPyramid hiz;
+    if (!hiz.create()) {
+        std::cerr << "no Hi-Z program\n";
+        return 1;
+    }
+    const float wall_distance = 60.0f;
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 15.0f, 0.0f), glm::vec3(0.0f, 15.0f, -1.0f), glm::vec3(0, 1, 0));
+    const glm::mat4 view_projection = projection * view;
+    const Frustum frustum(view_projection);
+    const glm::vec4 wall_clip = projection * glm::vec4(0.0f, 0.0f, -wall_distance, 1.0f);
+    const float wall_depth = wall_clip.z / wall_clip.w * 0.5f + 0.5f;
+
+    // Per instance: nearest view distance of the box corners and how far right its screen rectangle reaches.
+    std::vector<float> nearest(n), right(n);
+    std::vector<bool> crosses_camera(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        nearest[i] = 1e9f;
+        right[i] = -1e9f;
+        crosses_camera[i] = false;
+        for (int c = 0; c < 8; ++c) {
+            glm::vec3 corner((c & 1) ? boxes.max_x[i] : boxes.min_x[i], (c & 2) ? boxes.max_y[i] : boxes.min_y[i],
+                (c & 4) ? boxes.max_z[i] : boxes.min_z[i]);
+            glm::vec4 clip = view_projection * glm::vec4(corner, 1.0f);
+            nearest[i] = std::min(nearest[i], -(view * glm::vec4(corner, 1.0f)).z);
+            if (clip.w <= 1e-5f) crosses_camera[i] = true;
+            else right[i] = std::max(right[i], clip.x / clip.w);
+        }
+    }
+    frustum.cull(boxes, expected.data());
+
+    for (int half = 0; half < 2; ++half) {
+        target.bind();
+        glClearDepth(1.0);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(0, 0, half ? target.width() / 2 : target.width(), target.height());
+        glClearDepth(wall_depth);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        glClearDepth(1.0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        hiz.build(target.depthTexture(), target.width(), target.height());
+        culler.resetStats();
+        culler.setOcclusion(&hiz, view_projection);
+        culler.run(frustum, source_buffer, n, visible_buffer, command_buffer, templates, 2);
+        culler.setOcclusion(nullptr);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        IndirectDrawList::Command commands[2];
+        glGetNamedBufferSubData(command_buffer, 0, sizeof(commands), commands);
+        const std::size_t kept = commands[0].instance_count;
+        glGetNamedBufferSubData(visible_buffer, 0, static_cast<GLsizeiptr>(kept * sizeof(Mesh::InstanceData)), visible.data());
+        std::vector<std::array<long long, 3>> gpu_keys;
+        for (std::size_t i = 0; i < kept; ++i)
+            gpu_keys.push_back(key(visible[i].model));
+        std::sort(gpu_keys.begin(), gpu_keys.end());
+
+        // 0.5 units of slack around the wall for the depth precision.
+        std::size_t in_frustum = 0, wrong = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!expected[i])
+                continue;
+            ++in_frustum;
+            const bool seen = crosses_camera[i] || nearest[i] < wall_distance - 0.5f || (half && right[i] > 0.0f);
+            const bool hidden = !crosses_camera[i] && nearest[i] > wall_distance + 0.5f && !half;
+            const bool kept_i = std::binary_search(gpu_keys.begin(), gpu_keys.end(), key(models[i]));
+            if ((seen && !kept_i) || (hidden && kept_i))
+                ++wrong;
+        }
+        const GpuCulling::Occlusion occlusion = culler.occlusion();
+        if (wrong > 0 || occlusion.tested != in_frustum || occlusion.tested - occlusion.occluded != kept) {
+            std::cerr << (half ? "half" : "full") << " wall: " << wrong << " wrong, tested " << occlusion.tested << "/"
+                << in_frustum << ", occluded " << occlusion.occluded << ", kept " << kept << '\n';
+            ok = false;
+        }
+        std::cout << (half ? "half" : "full") << " wall: " << occlusion.occluded << " of " << occlusion.tested
+            << " instances in the frustum occluded, Hi-Z " << hiz.size().x << "x" << hiz.size().y << ", "
+            << hiz.levels() << " levels\n";
+    }
+    hiz.destroy();
+    target.destroy();
+
+    glDeleteBuffers(1, &source_buffer);
+    glDeleteBuffers(1, &visible_buffer);
+    glDeleteBuffers(1, &command_buffer);
+    glDeleteBuffers(1, &drawn_buffer);
+    glDeleteQueries(1, &primitives_query);
+    culler.destroy();
+
+    if (!ok) {
+        std::cerr << "MISMATCH\n";
+        return 1;
+    }
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,12 @@
+#version 450 core
+
+in vec3 normal;
+in vec2 texcoord;
+
+uniform int atlasLayer = -1;
+
+out vec4 FragColor;
+
+void main() {
+	FragColor = vec4(normalize(normal) * 0.5 + 0.5, atlasLayer < 0 ? texcoord.x : 1.0);
+}
@@ -0,0 +1,30 @@
+#version 450 core
+
+// bench/gpu_cull_check.cpp: the instancing inputs of lighting_shader.vert; every drawn instance writes the
+// translation of the matrix it fetched to its slot of the Drawn buffer.
+
+in vec3 aPos;
+in vec3 aNorm;
+in vec2 aTex;
+
+uniform bool instanced = false;
+uniform mat4 uM_m = mat4(1.0);
+uniform mat4 uVP_m = mat4(1.0);
+layout(location = 3) in mat4 iM_m;	// locations 3-6
+layout(location = 7) in mat3 iN_m;	// locations 7-9
+
+layout(std430, binding = 7) writeonly buffer Drawn {
+	vec4 drawn[];
+};
+
+out vec3 normal;
+out vec2 texcoord;
+
+void main() {
+	mat4 M = instanced ? iM_m : uM_m;
+	if (gl_VertexID == 0)
+		drawn[gl_InstanceID] = vec4(M[3].xyz, 1.0);
+	gl_Position = uVP_m * M * vec4(aPos, 1.0);
+	normal = iN_m * aNorm;
+	texcoord = aTex;
+}
@@ -0,0 +1,139 @@
+// Terrain height sampling benchmark: the old App::getTerrainHeight (vector<vector<float>>, two
+// pointer hops per corner) against HeightField::sample, scalar and batched (AVX2/SSE2).
+// Results are compared against the old function, so the batched paths are checked at the same time.
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -I. bench/heightfield_bench.cpp HeightField.cpp -o heightfield_bench
+// The batched path (AVX2 or SSE2) is picked at run time, as in the app.
+// Options: --size N (grid N x N, default 1024), --samples N (default 1000000), --iters N (default 10).
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "HeightField.hpp"
+
+namespace {
+
+// App::getTerrainHeight before HeightField (terrain scale 1), kept for comparison.
+float legacyTerrainHeight(float x, float z, int terrainWidth, int terrainHeight, const std::vector<std::vector<float>>& heightmap) {
+    float terrainScale = 1.0f;
+    float fx = (x + terrainHeight / 2.0f) / terrainScale;
+    float fz = (z + terrainWidth / 2.0f) / terrainScale;
+
+    int ix = static_cast<int>(fx);
+    int iz = static_cast<int>(fz);
+
+    ix = std::max(0, std::min(ix, terrainWidth - 2));
+    iz = std::max(0, std::min(iz, terrainHeight - 2));
+
+    float h00 = heightmap[ix][iz];
+    float h10 = heightmap[ix + 1][iz];
+    float h01 = heightmap[ix][iz + 1];
+    float h11 = heightmap[ix + 1][iz + 1];
+
+    float fracx = fx - ix;
+    float fracz = fz - iz;
+
+    float h0 = h00 * (1.0f - fracx) + h10 * fracx;
+    float h1 = h01 * (1.0f - fracx) + h11 * fracx;
+    return h0 * (1.0f - fracz) + h1 * fracz;
+}
+
+template <typename F>
+double timeMs(F&& run) {
+    auto t0 = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int size = 1024;
+    std::size_t samples = 1000000;
+    int iters = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) size = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--samples" && i + 1 < argc) samples = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--iters" && i + 1 < argc) iters = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: heightfield_bench [--size N] [--samples N] [--iters N]\n";
+            return 1;
+        }
+    }
+
+    // Rolling hills in the same range as Heightmap produces (-16 .. 48).
+    std::vector<std::vector<float>> nested(size, std::vector<float>(size));
+    std::vector<float> flat(static_cast<std::size_t>(size) * size);
+    for (int r = 0; r < size; ++r)
+        for (int c = 0; c < size; ++c) {
+            float h = 16.0f + 32.0f * std::sin(r * 0.05f) * std::cos(c * 0.07f);
+            nested[r][c] = h;
+            flat[static_cast<std::size_t>(r) * size + c] = h;
+        }
+    HeightField field(size, size, std::move(flat));
+
+    // Positions strictly inside the grid; at the border the old function extrapolated instead of clamping.
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(-size / 2.0f, size / 2.0f - 1.001f);
+    std::vector<glm::vec2> xz(samples);
+    for (auto& p : xz) p = { coord(rng), coord(rng) };
+
+    std::vector<float> expected(samples), scalar(samples), batched(samples);
+    volatile float sink = 0.0f;
+
+    auto runLegacy = [&] {
+        for (std::size_t i = 0; i < samples; ++i)
+            expected[i] = legacyTerrainHeight(xz[i].x, xz[i].y, size, size, nested);
+        sink = expected[samples / 2];
+        };
+    auto runScalar = [&] {
+        for (std::size_t i = 0; i < samples; ++i)
+            scalar[i] = field.sample(xz[i].x, xz[i].y);
+        sink = scalar[samples / 2];
+        };
+    auto runBatched = [&] {
+        field.sample(xz.data(), batched.data(), samples);
+        sink = batched[samples / 2];
+        };
+
+    // Interleaved rounds, best time of each: background noise hits all three alike.
+    double legacy_ms = 1e30, scalar_ms = 1e30, batched_ms = 1e30;
+    for (int it = 0; it < iters; ++it) {
+        legacy_ms = std::min(legacy_ms, timeMs(runLegacy));
+        scalar_ms = std::min(scalar_ms, timeMs(runScalar));
+        batched_ms = std::min(batched_ms, timeMs(runBatched));
+    }
+    (void)sink;
+
+    float max_scalar = 0.0f, max_batched = 0.0f;
+    for (std::size_t i = 0; i < samples; ++i) {
+        max_scalar = std::max(max_scalar, std::abs(scalar[i] - expected[i]));
+        max_batched = std::max(max_batched, std::abs(batched[i] - expected[i]));
+    }
+
+    auto ns = [&](double ms) { return ms * 1e6 / static_cast<double>(samples); };
+    std::cout << std::fixed << std::setprecision(2)
+        << size << "x" << size << " grid, " << samples << " samples, best of " << iters << "\n"
+        << "  vector<vector> getTerrainHeight: " << legacy_ms << " ms (" << ns(legacy_ms) << " ns/sample)\n"
+        << "  HeightField::sample scalar:      " << scalar_ms << " ms (" << ns(scalar_ms) << " ns/sample, x" << legacy_ms / scalar_ms << ")\n"
+        << "  HeightField::sample " << std::left << std::setw(6) << HeightField::simdPath() << std::right << " batch:  "
+        << batched_ms << " ms (" << ns(batched_ms) << " ns/sample, x" << legacy_ms / batched_ms << ")\n"
+        << std::scientific << std::setprecision(1)
+        << "  max |difference| vs old: scalar " << max_scalar << ", batched " << max_batched << "\n";
+
+    const float tolerance = 1e-3f;
+    if (max_scalar > tolerance || max_batched > tolerance) {
+        std::cerr << "MISMATCH\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Heightmap construction benchmark: the old per-texel loop (clamping lambda for every neighbour height,
+// push_back without reserve) against Heightmap::decodeHeights + buildVertices, on one thread and on all.
+// The image is synthetic (RGBA, iceland_heightmap.png size by default); outputs are compared vertex by vertex.
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -pthread -I. bench/heightmap_build_bench.cpp -o heightmap_build_bench
+// (the GLEW/GLM include paths of the app have to be on the include path as well).
+// Options: --width N --height N (default 1756 x 2624), --iters N (default 5).
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Heightmap.hpp"
+
+namespace {
+
+// Heightmap's vertex loop before the rewrite (texture coordinates and positions as there).
+void legacyBuild(unsigned char const* data, int width, int height, int nChannels, std::vector<float>& grid, std::vector<vertex>& vertices) {
+    grid.assign(static_cast<size_t>(width) * height, 0.0f);
+    vertices.clear();
+    float yScale = 64.0f / 255.0f, yShift = 16.0f;
+
+    for (int i = 0; i < height; i++)
+    {
+        for (int j = 0; j < width; j++)
+        {
+            auto getHeight = [&](int row, int col) {
+                row = glm::clamp(row, 0, height - 1);
+                col = glm::clamp(col, 0, width - 1);
+                unsigned char const* texel = data + (col + width * row) * nChannels;
+                return static_cast<float>(texel[0]) * yScale - yShift;
+                };
+
+            float h = getHeight(i, j);
+            grid[static_cast<size_t>(i) * width + j] = h;
+
+            glm::vec3 pL = glm::vec3(-height / 2.0f + (i - 1), getHeight(i - 1, j), -width / 2.0f + j);
+            glm::vec3 pR = glm::vec3(-height / 2.0f + (i + 1), getHeight(i + 1, j), -width / 2.0f + j);
+            glm::vec3 pD = glm::vec3(-height / 2.0f + i, getHeight(i, j - 1), -width / 2.0f + (j - 1));
+            glm::vec3 pU = glm::vec3(-height / 2.0f + i, getHeight(i, j + 1), -width / 2.0f + (j + 1));
+
+            glm::vec3 dX = pR - pL;
+            glm::vec3 dZ = pU - pD;
+            glm::vec3 N = glm::normalize(glm::cross(dZ, dX));
+
+            vertex v;
+            v.position = glm::vec3(-height / 2.0f + i, h, -width / 2.0f + j);
+            v.normal = N;
+            v.texcoord = glm::vec2(static_cast<float>(j) / (width - 1), static_cast<float>(i) / (height - 1));
+            vertices.push_back(v);
+        }
+    }
+}
+
+template <typename F>
+double timeMs(F&& run) {
+    auto t0 = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+float maxDifference(std::vector<vertex> const& a, std::vector<vertex> const& b) {
+    if (a.size() != b.size()) return 1e30f;
+    float d = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        d = std::max(d, glm::length(a[i].position - b[i].position));
+        d = std::max(d, glm::length(a[i].normal - b[i].normal));
+        d = std::max(d, glm::length(a[i].texcoord - b[i].texcoord));
+    }
+    return d;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int width = 1756, height = 2624, iters = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--width" && i + 1 < argc) width = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--height" && i + 1 < argc) height = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--iters" && i + 1 < argc) iters = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: heightmap_build_bench [--width N] [--height N] [--iters N]\n";
+            return 1;
+        }
+    }
+
+    // RGBA like iceland_heightmap.png; only the first channel is used.
+    const int channels = 4;
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * channels);
+    for (int r = 0; r < height; ++r)
+        for (int c = 0; c < width; ++c)
+            for (int k = 0; k < channels; ++k)
+                image[(static_cast<size_t>(r) * width + c) * channels + k] =
+                    static_cast<unsigned char>(127.5f + 127.5f * std::sin(r * 0.013f) * std::cos(c * 0.021f));
+
+    const unsigned threads = Heightmap::buildThreads(height);
+    std::vector<float> grid_old, grid_new;
+    std::vector<vertex> old_vertices, new_vertices, parallel_vertices;
+
+    double legacy_ms = 1e30, single_ms = 1e30, parallel_ms = 1e30;
+    for (int it = 0; it < iters; ++it) {
+        legacy_ms = std::min(legacy_ms, timeMs([&] {
+            std::vector<vertex>().swap(old_vertices);   // start empty like a fresh Heightmap
+            legacyBuild(image.data(), width, height, channels, grid_old, old_vertices);
+            }));
+        single_ms = std::min(single_ms, timeMs([&] {
+            std::vector<vertex>().swap(new_vertices);
+            Heightmap::decodeHeights(image.data(), width, height, channels, grid_new, 1);
+            Heightmap::buildVertices(grid_new, width, height, new_vertices, 1);
+            }));
+        parallel_ms = std::min(parallel_ms, timeMs([&] {
+            std::vector<vertex>().swap(parallel_vertices);
+            Heightmap::decodeHeights(image.data(), width, height, channels, grid_new, threads);
+            Heightmap::buildVertices(grid_new, width, height, parallel_vertices, threads);
+            }));
+    }
+
+    float diff = std::max(maxDifference(old_vertices, new_vertices), maxDifference(old_vertices, parallel_vertices));
+    std::cout << std::fixed << std::setprecision(1)
+        << width << "x" << height << " heightmap, best of " << iters << "\n"
+        << "  old per-texel loop:          " << legacy_ms << " ms\n"
+        << "  row passes, 1 thread:        " << single_ms << " ms (x" << legacy_ms / single_ms << ")\n"
+        << "  row passes, " << std::setw(2) << threads << " threads:      " << parallel_ms << " ms (x" << legacy_ms / parallel_ms << ")\n"
+        << std::scientific << std::setprecision(1)
+        << "  max vertex difference: " << diff << "\n";
+
+    if (grid_old != grid_new || diff > 1e-5f) {
+        std::cerr << "MISMATCH\n";
+        return 1;
+    }
+    return 0;
+}
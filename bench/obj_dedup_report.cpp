@@ -0,0 +1,104 @@
+// Vertex deduplication report: GPU buffer sizes and estimated vertex shader invocations of
+// the old unrolled 1:1 indexing vs. the indexed loadOBJ overload, per OBJ file.
+//
+// Vertex shader invocations are estimated by replaying the index buffer through a FIFO
+// post-transform cache (--cache N, default 32 entries), the usual model for desktop GPUs.
+// With 1:1 indexing every index is unique, so every corner is shaded.
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -I. bench/obj_dedup_report.cpp OBJloader.cpp MappedFile.cpp -o obj_dedup_report
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "OBJloader.hpp"
+
+namespace {
+
+// Same layout as `vertex` in assets.hpp (position, normal, texcoord).
+constexpr std::size_t kVertexBytes = sizeof(float) * (3 + 3 + 2);
+
+std::size_t simulateFifoMisses(const std::vector<unsigned int>& indices, std::size_t cache_size) {
+    std::deque<unsigned int> fifo;
+    std::unordered_set<unsigned int> resident;
+    std::size_t misses = 0;
+    for (unsigned int i : indices) {
+        if (resident.count(i)) continue;
+        ++misses;
+        fifo.push_back(i);
+        resident.insert(i);
+        if (fifo.size() > cache_size) {
+            resident.erase(fifo.front());
+            fifo.pop_front();
+        }
+    }
+    return misses;
+}
+
+double kib(std::size_t bytes) { return static_cast<double>(bytes) / 1024.0; }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t cache_size = 32;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cache" && i + 1 < argc) cache_size = std::max(1, std::atoi(argv[++i]));
+        else files.push_back(arg);
+    }
+    if (files.empty()) {
+        for (auto const& e : std::filesystem::directory_iterator("resources/objects")) {
+            std::string ext = e.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".obj") files.push_back(e.path().string());
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    std::cout << std::left << std::setw(30) << "file" << std::right
+        << std::setw(10) << "tris"
+        << std::setw(12) << "verts old" << std::setw(12) << "verts new"
+        << std::setw(12) << "VBO old KiB" << std::setw(12) << "VBO new KiB"
+        << std::setw(11) << "VS old" << std::setw(11) << "VS new"
+        << std::setw(10) << "ACMR new" << '\n';
+
+    std::size_t sum_tris = 0, sum_old = 0, sum_new = 0, sum_vs_new = 0;
+    for (auto const& path : files) {
+        std::vector<glm::vec3> v, n;
+        std::vector<glm::vec2> uv;
+        std::vector<unsigned int> indices;
+
+        if (!loadOBJ(path.c_str(), v, uv, n) || v.empty())
+            continue;
+        std::size_t corners = v.size();
+
+        if (!loadOBJ(path.c_str(), v, uv, n, indices))
+            continue;
+        std::size_t unique = v.size();
+        std::size_t tris = indices.size() / 3;
+        std::size_t vs_new = simulateFifoMisses(indices, cache_size);
+
+        sum_tris += tris; sum_old += corners; sum_new += unique; sum_vs_new += vs_new;
+        std::cout << std::left << std::setw(30) << std::filesystem::path(path).filename().string().substr(0, 29) << std::right
+            << std::setw(10) << tris
+            << std::setw(12) << corners << std::setw(12) << unique
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << kib(corners * kVertexBytes) << std::setw(12) << kib(unique * kVertexBytes)
+            << std::setw(11) << corners << std::setw(11) << vs_new
+            << std::setprecision(3) << std::setw(10) << static_cast<double>(vs_new) / tris << '\n';
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+        << "total: " << sum_tris << " triangles, VBO " << kib(sum_old * kVertexBytes) << " KiB -> "
+        << kib(sum_new * kVertexBytes) << " KiB, VS invocations " << sum_old << " -> " << sum_vs_new
+        << " (FIFO cache " << cache_size << ")\n"
+        << "index buffers are unchanged in size (one 32-bit index per corner in both cases)\n";
+    return 0;
+}
@@ -0,0 +1,230 @@
+// OBJ loader throughput benchmark: memory-mapped in-place parser (loadOBJ) vs. the
+// previous std::getline + istringstream implementation (kept below as reference).
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -I. bench/obj_loader_bench.cpp OBJloader.cpp MappedFile.cpp -o obj_loader_bench
+//   cl /O2 /EHsc /std:c++17 /I. /I<glm include dir> bench\obj_loader_bench.cpp OBJloader.cpp MappedFile.cpp
+// Run from the repo root (default file list is resources/objects/*.obj) or pass files/--iters N.
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "OBJloader.hpp"
+
+namespace {
+
+// Previous loader, verbatim apart from the name.
+bool loadOBJ_getline(const char * path, std::vector< glm::vec3 > & out_vertices, std::vector< glm::vec2 > & out_uvs, std::vector< glm::vec3 > & out_normals)
+{
+    out_vertices.clear();
+    out_uvs.clear();
+    out_normals.clear();
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Impossible to open the file: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> temp_vertices;
+    std::vector<glm::vec2> temp_uvs;
+    std::vector<glm::vec3> temp_normals;
+
+    std::vector<unsigned int> vertexIndices;
+    std::vector<unsigned int> uvIndices;
+    std::vector<unsigned int> normalIndices;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        std::istringstream ss(line);
+        std::string prefix;
+        ss >> prefix;
+        if (prefix == "v") {
+            glm::vec3 v;
+            ss >> v.x >> v.y >> v.z;
+            temp_vertices.push_back(v);
+        }
+        else if (prefix == "vt") {
+            glm::vec2 uv;
+            ss >> uv.x >> uv.y;
+            uv.y = 1.0f - uv.y;
+            temp_uvs.push_back(uv);
+        }
+        else if (prefix == "vn") {
+            glm::vec3 n;
+            ss >> n.x >> n.y >> n.z;
+            temp_normals.push_back(n);
+        }
+        else if (prefix == "f") {
+            std::vector<std::string> tokens;
+            std::string tok;
+            while (ss >> tok) tokens.push_back(tok);
+            if (tokens.size() < 3) {
+                std::cerr << "Face with fewer than 3 vertices: \"" << line << "\"" << std::endl;
+                continue;
+            }
+
+            std::vector<int> f_v, f_vt, f_vn;
+            f_v.reserve(tokens.size());
+            f_vt.reserve(tokens.size());
+            f_vn.reserve(tokens.size());
+
+            for (auto &t : tokens) {
+                int vi = 0, vti = 0, vni = 0;
+                size_t p1 = t.find('/');
+                if (p1 == std::string::npos) {
+                    vi = std::stoi(t);
+                }
+                else {
+                    std::string a = t.substr(0, p1);
+                    size_t p2 = t.find('/', p1 + 1);
+                    if (p2 == std::string::npos) {
+                        if (!a.empty()) vi = std::stoi(a);
+                        std::string b = t.substr(p1 + 1);
+                        if (!b.empty()) vti = std::stoi(b);
+                    }
+                    else {
+                        std::string b = t.substr(p1 + 1, p2 - p1 - 1);
+                        std::string c = t.substr(p2 + 1);
+                        if (!a.empty()) vi = std::stoi(a);
+                        if (!b.empty()) vti = std::stoi(b);
+                        if (!c.empty()) vni = std::stoi(c);
+                    }
+                }
+
+                auto fix = [](int idx, size_t size)->int {
+                    if (idx < 0) return static_cast<int>(size) + idx + 1;
+                    return idx;
+                };
+                if (vi != 0) f_v.push_back(fix(vi, temp_vertices.size()));
+                else f_v.push_back(0);
+                if (vti != 0) f_vt.push_back(fix(vti, temp_uvs.size()));
+                else f_vt.push_back(0);
+                if (vni != 0) f_vn.push_back(fix(vni, temp_normals.size()));
+                else f_vn.push_back(0);
+            }
+
+            for (size_t i = 1; i + 1 < f_v.size(); ++i) {
+                vertexIndices.push_back(static_cast<unsigned int>(f_v[0]));
+                vertexIndices.push_back(static_cast<unsigned int>(f_v[i]));
+                vertexIndices.push_back(static_cast<unsigned int>(f_v[i+1]));
+
+                uvIndices.push_back(static_cast<unsigned int>(f_vt[0]));
+                uvIndices.push_back(static_cast<unsigned int>(f_vt[i]));
+                uvIndices.push_back(static_cast<unsigned int>(f_vt[i+1]));
+
+                normalIndices.push_back(static_cast<unsigned int>(f_vn[0]));
+                normalIndices.push_back(static_cast<unsigned int>(f_vn[i]));
+                normalIndices.push_back(static_cast<unsigned int>(f_vn[i+1]));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < vertexIndices.size(); ++i) {
+        unsigned int vi = vertexIndices[i];
+        if (vi == 0 || vi > temp_vertices.size()) {
+            std::cerr << "Vertex index out of range in OBJ: " << vi << std::endl;
+            return false;
+        }
+        out_vertices.push_back(temp_vertices[vi - 1]);
+
+        unsigned int uvi = (i < uvIndices.size()) ? uvIndices[i] : 0;
+        if (uvi != 0 && uvi <= temp_uvs.size()) out_uvs.push_back(temp_uvs[uvi - 1]);
+        else out_uvs.push_back(glm::vec2(0.0f, 0.0f));
+
+        unsigned int ni = (i < normalIndices.size()) ? normalIndices[i] : 0;
+        if (ni != 0 && ni <= temp_normals.size()) out_normals.push_back(temp_normals[ni - 1]);
+        else out_normals.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+    }
+
+    return true;
+}
+
+using LoaderFn = bool (*)(const char*, std::vector<glm::vec3>&, std::vector<glm::vec2>&, std::vector<glm::vec3>&);
+
+// Best-of-N wall time in seconds (first call also warms the OS file cache).
+double timeLoader(LoaderFn fn, const std::string& path, int iters,
+    std::vector<glm::vec3>& v, std::vector<glm::vec2>& uv, std::vector<glm::vec3>& n) {
+    double best = 1e30;
+    for (int i = 0; i < iters; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn(path.c_str(), v, uv, n);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+template <class T>
+float maxAbsDiff(const std::vector<T>& a, const std::vector<T>& b) {
+    if (a.size() != b.size()) return 1e30f;
+    float d = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        T diff = glm::abs(a[i] - b[i]);
+        for (int c = 0; c < T::length(); ++c) d = std::max(d, diff[c]);
+    }
+    return d;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iters = 5;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iters" && i + 1 < argc) iters = std::max(1, std::atoi(argv[++i]));
+        else files.push_back(arg);
+    }
+    if (files.empty()) {
+        for (auto const& e : std::filesystem::directory_iterator("resources/objects")) {
+            std::string ext = e.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".obj") files.push_back(e.path().string());
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    std::cout << std::left << std::setw(40) << "file" << std::right
+        << std::setw(10) << "MB" << std::setw(14) << "getline MB/s" << std::setw(14) << "mapped MB/s"
+        << std::setw(10) << "speedup" << std::setw(12) << "max |diff|" << '\n';
+
+    double total_mb = 0.0, total_old = 0.0, total_new = 0.0;
+    for (auto const& path : files) {
+        std::error_code ec;
+        double mb = static_cast<double>(std::filesystem::file_size(path, ec)) / (1024.0 * 1024.0);
+        if (ec) {
+            std::cerr << "skipping " << path << ": " << ec.message() << '\n';
+            continue;
+        }
+
+        std::vector<glm::vec3> v0, n0, v1, n1;
+        std::vector<glm::vec2> uv0, uv1;
+        double t_old = timeLoader(&loadOBJ_getline, path, iters, v0, uv0, n0);
+        double t_new = timeLoader(&loadOBJ, path, iters, v1, uv1, n1);
+
+        float diff = std::max({ maxAbsDiff(v0, v1), maxAbsDiff(uv0, uv1), maxAbsDiff(n0, n1) });
+
+        total_mb += mb; total_old += t_old; total_new += t_new;
+        std::cout << std::left << std::setw(40) << std::filesystem::path(path).filename().string() << std::right
+            << std::fixed << std::setprecision(2) << std::setw(10) << mb
+            << std::setw(14) << mb / t_old << std::setw(14) << mb / t_new
+            << std::setw(9) << t_old / t_new << 'x'
+            << std::scientific << std::setprecision(1) << std::setw(12) << diff << '\n';
+    }
+
+    if (total_new > 0.0) {
+        std::cout << std::fixed << std::setprecision(2) << "total: " << total_mb << " MB, getline "
+            << total_mb / total_old << " MB/s, mapped " << total_mb / total_new << " MB/s ("
+            << total_old / total_new << "x)\n";
+    }
+    return 0;
+}
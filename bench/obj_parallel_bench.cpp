@@ -0,0 +1,132 @@
+// Parallel OBJ parsing benchmark: loadOBJ time vs. worker thread count (setOBJLoaderThreads).
+// Every run is compared against the single-threaded result, so chunk merging and negative index
+// resolution across chunk boundaries are checked at the same time.
+//
+// --synthetic MB also writes a generated grid mesh of about MB megabytes to the temp directory,
+// using negative (relative) face indices, and adds it to the file list.
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -pthread -I. bench/obj_parallel_bench.cpp OBJloader.cpp MappedFile.cpp -o obj_parallel_bench
+// Run from the repo root (default files are Pokeball.obj, Table.obj, towers.obj) or pass files/--iters N.
+// Thread counts go 1, 2, 4, ... up to the hardware thread count, or --max-threads N.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "OBJloader.hpp"
+
+namespace {
+
+struct Result {
+    std::vector<glm::vec3> v, n;
+    std::vector<glm::vec2> uv;
+    std::vector<unsigned int> indices;
+};
+
+bool sameResult(const Result& a, const Result& b) {
+    return a.v == b.v && a.n == b.n && a.uv == b.uv && a.indices == b.indices;
+}
+
+// Best-of-N wall time of the indexed loadOBJ (the overload Model uses).
+double timeLoad(const std::string& path, int iters, Result& out) {
+    double best = 1e30;
+    for (int i = 0; i < iters; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        loadOBJ(path.c_str(), out.v, out.uv, out.n, out.indices);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return best;
+}
+
+// Grid of quads, every face written with negative indices relative to its own vertices.
+std::string writeSyntheticObj(std::size_t megabytes) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "obj_parallel_bench_grid.obj";
+    std::ofstream out(path);
+    std::size_t written = 0, quad = 0;
+    char line[256];
+    while (written < megabytes * 1024 * 1024) {
+        const float x = static_cast<float>(quad % 1024), z = static_cast<float>(quad / 1024);
+        int len = std::snprintf(line, sizeof(line),
+            "v %.4f 0.0 %.4f\nv %.4f 0.0 %.4f\nv %.4f 0.0 %.4f\nv %.4f 0.0 %.4f\n"
+            "vt 0.0 0.0\nvt 1.0 0.0\nvt 1.0 1.0\nvt 0.0 1.0\nvn 0.0 1.0 0.0\n"
+            "f -4/-4/-1 -3/-3/-1 -2/-2/-1 -1/-1/-1\n",
+            x, z, x + 1, z, x + 1, z + 1, x, z + 1);
+        out.write(line, len);
+        written += static_cast<std::size_t>(len);
+        ++quad;
+    }
+    return path.string();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iters = 5;
+    std::size_t synthetic_mb = 0;
+    unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iters" && i + 1 < argc) iters = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--synthetic" && i + 1 < argc) synthetic_mb = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--max-threads" && i + 1 < argc) max_threads = static_cast<unsigned int>(std::max(1, std::atoi(argv[++i])));
+        else files.push_back(arg);
+    }
+    if (files.empty())
+        files = { "resources/objects/Pokeball.obj", "resources/objects/Table.obj", "resources/objects/towers.obj" };
+    if (synthetic_mb)
+        files.push_back(writeSyntheticObj(synthetic_mb));
+
+    std::vector<unsigned int> counts;
+    for (unsigned int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+    counts.push_back(max_threads);
+
+    std::cout << std::left << std::setw(30) << "file" << std::right << std::setw(10) << "MiB"
+        << std::setw(9) << "threads" << std::setw(11) << "ms" << std::setw(10) << "MB/s"
+        << std::setw(10) << "speedup" << std::setw(9) << "same" << '\n';
+
+    bool all_same = true;
+    for (auto const& path : files) {
+        std::error_code ec;
+        const auto bytes = std::filesystem::file_size(path, ec);
+        if (ec) {
+            std::cerr << "skipping " << path << ": " << ec.message() << '\n';
+            continue;
+        }
+
+        Result reference;
+        double base_ms = 0.0;
+        for (unsigned int t : counts) {
+            setOBJLoaderThreads(t);
+            Result r;
+            const double ms = timeLoad(path, iters, r);
+            if (t == 1) {
+                reference = r;
+                base_ms = ms;
+            }
+            const bool same = sameResult(reference, r);
+            all_same = all_same && same;
+
+            std::cout << std::left << std::setw(30) << std::filesystem::path(path).filename().string().substr(0, 29) << std::right
+                << std::fixed << std::setprecision(2) << std::setw(10) << bytes / (1024.0 * 1024.0)
+                << std::setw(9) << t
+                << std::setprecision(2) << std::setw(11) << ms
+                << std::setprecision(0) << std::setw(10) << (bytes / 1e6) / (ms / 1e3)
+                << std::setprecision(2) << std::setw(9) << base_ms / ms << "x"
+                << std::setw(9) << (same ? "yes" : "NO") << '\n';
+        }
+    }
+
+    setOBJLoaderThreads(0);
+    std::cout << (all_same ? "all thread counts produced identical meshes\n" : "MISMATCH between thread counts\n");
+    return all_same ? 0 : 1;
+}
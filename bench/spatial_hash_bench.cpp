@@ -0,0 +1,116 @@
+// Collision broadphase benchmark: the old linear scan over every solid AABB against SpatialHash::querySphere,
+// for growing prop counts scattered like the cacti and rocks (random spots, sizes 0.2 - 3 units).
+// Each frame queries a walking camera sphere and moves a few boxes (landed projectiles, the plane); the hit sets
+// of both ways are compared.
+//
+// Standalone program, not part of my_app.vcxproj. Build from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -I. bench/spatial_hash_bench.cpp SpatialHash.cpp -o spatial_hash_bench
+// (the GLM include path of the app has to be on the include path as well).
+// Options: --area N (side of the square the props are scattered over, default 400), --frames N (default 20000).
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "SpatialHash.hpp"
+
+namespace {
+
+struct Box {
+    glm::vec3 mn, mx;
+};
+
+// Model::intersectsSphere, once per box.
+void linearQuery(std::vector<Box> const& boxes, glm::vec3 center, float radius, std::vector<SpatialHash::Id>& out) {
+    out.clear();
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        glm::vec3 closest = glm::clamp(center, boxes[i].mn, boxes[i].mx);
+        if (glm::dot(closest - center, closest - center) <= radius * radius)
+            out.push_back(static_cast<SpatialHash::Id>(i));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    float area = 400.0f;
+    int frames = 20000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--area" && i + 1 < argc) area = std::max(10.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (arg == "--frames" && i + 1 < argc) frames = std::max(1, std::atoi(argv[++i]));
+        else {
+            std::cerr << "usage: spatial_hash_bench [--area N] [--frames N]\n";
+            return 1;
+        }
+    }
+
+    const float radius = 0.75f;     // App::run cameraRadius
+    const int moving = 8;           // boxes moved every frame
+    std::cout << std::fixed << std::setprecision(3) << "props over " << area << " x " << area << ", " << frames
+        << " frames (1 sphere query + " << moving << " moved boxes each)\n";
+
+    bool ok = true;
+    for (int count : { 140, 1000, 10000, 100000 }) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> pos(-area * 0.5f, area * 0.5f), size(0.2f, 3.0f);
+
+        std::vector<Box> boxes(static_cast<std::size_t>(count));
+        SpatialHash grid(4.0f);
+        for (auto& b : boxes) {
+            glm::vec3 c(pos(rng), 0.0f, pos(rng));
+            glm::vec3 half(size(rng) * 0.5f, size(rng), size(rng) * 0.5f);
+            b = { c - half, c + half };
+            grid.insert(b.mn, b.mx);   // ids follow the insertion order
+        }
+
+        std::vector<SpatialHash::Id> expected, hits;
+        std::size_t total_hits = 0;
+        double linear_s = 0.0, grid_s = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            // Camera walks a circle through the props.
+            float t = static_cast<float>(f) * 0.002f;
+            glm::vec3 camera(std::cos(t) * area * 0.3f, 0.5f, std::sin(t * 1.3f) * area * 0.3f);
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (int m = 0; m < moving; ++m) {
+                Box& b = boxes[static_cast<std::size_t>((f * moving + m) % count)];
+                glm::vec3 step(std::cos(t + m) * 0.05f, 0.0f, std::sin(t + m) * 0.05f);
+                b.mn += step;
+                b.mx += step;
+            }
+            linearQuery(boxes, camera, radius, expected);
+            auto t1 = std::chrono::steady_clock::now();
+            for (int m = 0; m < moving; ++m) {
+                auto id = static_cast<SpatialHash::Id>((f * moving + m) % count);
+                grid.update(id, boxes[id].mn, boxes[id].mx);
+            }
+            grid.querySphere(camera, radius, hits);
+            auto t2 = std::chrono::steady_clock::now();
+
+            linear_s += std::chrono::duration<double>(t1 - t0).count();
+            grid_s += std::chrono::duration<double>(t2 - t1).count();
+            total_hits += hits.size();
+
+            std::sort(hits.begin(), hits.end());
+            if (hits != expected)
+                ok = false;
+        }
+
+        auto const& st = grid.stats();
+        std::cout << std::setw(7) << count << " props: linear " << linear_s * 1e6 / frames << " us/frame, grid "
+            << grid_s * 1e6 / frames << " us/frame (x" << linear_s / grid_s << "), "
+            << static_cast<double>(st.tests) / st.queries << " boxes tested/query, " << total_hits << " hits\n";
+    }
+
+    if (!ok) {
+        std::cerr << "MISMATCH\n";
+        return 1;
+    }
+    return 0;
+}
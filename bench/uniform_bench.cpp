@@ -0,0 +1,156 @@
+// setUniform CPU cost per frame: one frame of App::run's uniform updates as they were when the handles came in
+// (146 scene entities, 67 of them with their own texture, one transparent), replayed on a headless EGL context.
+// Three ways are timed: every call by name with glGetUniformLocation (before, L on), by name through the
+// reflected table (L off), and through UniformHandles (after). Each prints the app's U report line, whose
+// timing reads the clock twice per call, and the wall time per frame with that timing off.
+//
+// Standalone program, not part of my_app.vcxproj. Build and run from the repo root, e.g.:
+//   g++ -O2 -std=c++17 -I. bench/uniform_bench.cpp ShaderProgram.cpp RenderState.cpp -lGLEW -lEGL -lGL -o uniform_bench
+//   LIBGL_ALWAYS_SOFTWARE=1 ./uniform_bench
+// (the GLM include path of the app has to be on the include path as well).
+// Options: --frames N (per run, best of 5 runs, default 3000).
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "ShaderProgram.hpp"
+
+namespace {
+
+const int kEntities = 146;
+const int kTextured = 67;   // rocks and lamps: bind their own texture, the rest sample the atlas
+
+bool makeContext() {
+    auto getDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (!getDisplay) return false;
+    EGLDisplay display = getDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (!eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) return false;
+    const EGLint attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return false;
+    glewExperimental = GL_TRUE;
+    return glewInit() == GLEW_OK;
+}
+
+// The frame before the handles: App::run, Mesh::draw and the transparent pass all by name.
+void frameByName(ShaderProgram& s, glm::mat4 const& m, glm::mat3 const& n) {
+    s.setUniform("uV_m", m);
+    s.setUniform("uP_m", m);
+    s.setUniform("my_color", glm::vec4(1.0f));
+    s.setUniform("lights[1].position", glm::vec4(1.0f));
+    s.setUniform("lights[1].direction", glm::vec3(1.0f));
+    s.setUniform("lights[3].ambientM", glm::vec3(1.0f));
+    s.setUniform("lights[3].diffuseM", glm::vec3(1.0f));
+    s.setUniform("lights[3].specularM", glm::vec3(1.0f));
+    s.setUniform("uM_m", m);                                    // Ground
+    s.setUniform("atlasLayer", 5);
+    for (int e = 0; e < kEntities; ++e) {
+        s.setUniform("N_matrix", n);
+        if (e == 0) s.setUniform("lights[3].position", glm::vec4(1.0f));   // the plane carries lights[3]
+        s.setUniform("uM_m", m);
+        s.setUniform("atlasLayer", e < kTextured ? -1 : 3);
+        if (e < kTextured) s.setUniform("tex0", 0);
+    }
+    s.setUniform("my_color", glm::vec4(0.5f));                  // transparent block
+    s.setUniform("N_matrix", n);
+    s.setUniform("uM_m", m);
+    s.setUniform("uM_m", m);
+    s.setUniform("atlasLayer", 4);
+}
+
+struct Handles {
+    UniformHandle view, projection, color, flashlight_position, flashlight_direction;
+    UniformHandle beacon_ambient, beacon_diffuse, beacon_specular, beacon_position;
+    UniformHandle model, normal_matrix, atlas_layer, tex0;
+};
+
+// The same calls through the handles App::u and Mesh resolve once.
+void frameByHandle(ShaderProgram& s, Handles const& u, glm::mat4 const& m, glm::mat3 const& n) {
+    s.setUniform(u.view, m);
+    s.setUniform(u.projection, m);
+    s.setUniform(u.color, glm::vec4(1.0f));
+    s.setUniform(u.flashlight_position, glm::vec4(1.0f));
+    s.setUniform(u.flashlight_direction, glm::vec3(1.0f));
+    s.setUniform(u.beacon_ambient, glm::vec3(1.0f));
+    s.setUniform(u.beacon_diffuse, glm::vec3(1.0f));
+    s.setUniform(u.beacon_specular, glm::vec3(1.0f));
+    s.setUniform(u.model, m);
+    s.setUniform(u.atlas_layer, 5);
+    for (int e = 0; e < kEntities; ++e) {
+        s.setUniform(u.normal_matrix, n);
+        if (e == 0) s.setUniform(u.beacon_position, glm::vec4(1.0f));
+        s.setUniform(u.model, m);
+        s.setUniform(u.atlas_layer, e < kTextured ? -1 : 3);
+        if (e < kTextured) s.setUniform(u.tex0, 0);
+    }
+    s.setUniform(u.color, glm::vec4(0.5f));
+    s.setUniform(u.normal_matrix, n);
+    s.setUniform(u.model, m);
+    s.setUniform(u.model, m);
+    s.setUniform(u.atlas_layer, 4);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int frames = 3000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--frames") frames = std::max(1, std::atoi(argv[i + 1]));
+    }
+    if (!makeContext()) {
+        std::cerr << "No OpenGL 4.5 context (EGL, surfaceless)\n";
+        return 1;
+    }
+
+    ShaderProgram shader("bench/uniform_bench.vert", "bench/uniform_bench.frag");
+    shader.activate();
+    const Handles u{ shader.uniform("uV_m"), shader.uniform("uP_m"), shader.uniform("my_color"),
+        shader.uniform("lights[1].position"), shader.uniform("lights[1].direction"),
+        shader.uniform("lights[3].ambientM"), shader.uniform("lights[3].diffuseM"), shader.uniform("lights[3].specularM"),
+        shader.uniform("lights[3].position"), shader.uniform("uM_m"), shader.uniform("N_matrix"),
+        shader.uniform("atlasLayer"), shader.uniform("tex0") };
+    const glm::mat4 m(1.0f);
+    const glm::mat3 n(1.0f);
+
+    std::cout << kEntities << " entities, " << frames << " frames per run, best of 5\n" << std::fixed << std::setprecision(1);
+    auto run = [&](const char* what, auto frame) {
+        for (int f = 0; f < 200; ++f) frame();     // warm up
+        double report_us = 1e30, wall_us = 1e30;
+        std::uint64_t by_name = 0, by_handle = 0;
+        for (int timed = 0; timed < 2; ++timed) {
+            ShaderProgram::profile_uniforms = timed == 0;
+            for (int rep = 0; rep < 5; ++rep) {
+                ShaderProgram::uniformStats() = {};
+                auto start = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames; ++f) frame();
+                const double wall = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+                auto const& stats = ShaderProgram::uniformStats();
+                if (timed == 0) report_us = std::min(report_us, stats.cpu_ms * 1000.0 / frames);
+                else wall_us = std::min(wall_us, wall);
+                by_name = stats.by_name / frames;
+                by_handle = stats.by_handle / frames;
+            }
+        }
+        std::cout << what << "\n  [Uniforms] " << by_name + by_handle << " calls/frame (" << by_name << " by name, "
+            << by_handle << " by handle), " << report_us << " us/frame CPU, name lookup: "
+            << (ShaderProgram::legacy_uniform_lookup ? "glGetUniformLocation" : "reflected table")
+            << "\n  U off: " << wall_us << " us/frame wall\n";
+    };
+
+    ShaderProgram::legacy_uniform_lookup = true;
+    run("before: by name, glGetUniformLocation per call (L on)", [&] { frameByName(shader, m, n); });
+    ShaderProgram::legacy_uniform_lookup = false;
+    run("by name, reflected table (L off)", [&] { frameByName(shader, m, n); });
+    run("after: handles", [&] { frameByHandle(shader, u, m, n); });
+    return glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#version 450 core
+
+// bench/uniform_bench.cpp: the default-block uniforms lighting_shader.frag had before the Lights uniform block.
+
+#define MAX_LIGHTS 4
+
+struct s_lights {
+	vec4 position;
+	vec3 ambientM;
+	vec3 diffuseM;
+	vec3 specularM;
+	vec3 direction;
+};
+uniform s_lights lights[MAX_LIGHTS];
+
+uniform sampler2D tex0;
+uniform sampler2DArray atlas;
+uniform int atlasLayer = -1;
+
+in vec4 color;
+in vec3 normal;
+out vec4 FragColor;
+
+void main() {
+	vec3 sum = vec3(0.0);
+	for (int i = 0; i < MAX_LIGHTS; ++i)
+		sum += lights[i].position.xyz + lights[i].ambientM + lights[i].diffuseM + lights[i].specularM + lights[i].direction;
+	vec4 tex = atlasLayer < 0 ? texture(tex0, normal.xy) : texture(atlas, vec3(normal.xy, float(atlasLayer)));
+	FragColor = color * tex + vec4(sum, 0.0);
+}
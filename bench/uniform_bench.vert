@@ -0,0 +1,21 @@
+#version 450 core
+
+// bench/uniform_bench.cpp: the default-block uniforms lighting_shader.vert had before the Frame/Lights
+// uniform blocks, all kept active.
+
+in vec3 aPos;
+
+uniform mat4 uP_m = mat4(1.0);
+uniform mat4 uM_m = mat4(1.0);
+uniform mat4 uV_m = mat4(1.0);
+uniform vec4 my_color = vec4(1.0);
+uniform mat3 N_matrix = mat3(0.0);
+
+out vec4 color;
+out vec3 normal;
+
+void main() {
+	gl_Position = uP_m * uV_m * uM_m * vec4(aPos, 1.0);
+	normal = N_matrix * aPos;
+	color = my_color;
+}
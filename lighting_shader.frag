@@ -2,23 +2,32 @@
 
 #define MAX_LIGHTS 4
 
+// std140 layout, mirrored by LightStd140 in UniformBlocks.hpp (each vec3 shares its 16 bytes with a float).
 struct s_lights {
-	vec4 position;	//position of the light  (w == 0.0 if Directional light 1.0 if Pointlight or Spotlight)
-	vec3 ambientM;	// \
-	float pad1;     //  \    -->  4 bytes (padding for alignment)
-    vec3 diffuseM;	//   > Material properties they can change the color of the light (needed for ALL LIGHTS)
-	float pad2;     //  /    -->  4 bytes (padding for alignment)
-    vec3 specularM;	// /
-	float pad3;		//       -->  4 bytes (padding for alignment)
-	float consAttenuation;	// \
-	float pad4;				//  \    -->  4 bytes (padding for alignment)
-	float linAttenuation;	//   > Light properties for realistic light calculations (needed for SPOTLIGHTS and POINTLIGHTS)
-	float quadAttenuation;	//  /
-	float cutoff;     // cos(cutoff angle) (180 deg if Pointlight else Spotlight)
-	vec3 direction;	//Direction the light is pointing at (only needed for SPOTLIGHTS)
-    float exponent;   // spotlight edge falloff	(only needed for SPOTLIGHTS)
+	vec4 position;			// position of the light (w == 0.0 if Directional light 1.0 if Pointlight or Spotlight)
+	vec3 ambientM;			// ambient/diffuse/specular: material properties, they can change the color of the light (needed for ALL LIGHTS)
+	float consAttenuation;	// constant/linear/quadratic attenuation: needed for SPOTLIGHTS and POINTLIGHTS
+	vec3 diffuseM;
+	float linAttenuation;
+	vec3 specularM;
+	float quadAttenuation;
+	vec3 direction;			// direction the light is pointing at (only needed for SPOTLIGHTS)
+	float cutoff;			// cutoff angle in degrees (180 deg if Pointlight else Spotlight)
+	float exponent;			// spotlight edge falloff (only needed for SPOTLIGHTS)
+};
+layout(std140, binding = 1) uniform Lights {
+	s_lights lights[MAX_LIGHTS];
+};
+
+// Per-frame data shared by every program (binding 0), mirrored by FrameStd140 in UniformBlocks.hpp.
+layout(std140, binding = 0) uniform Frame {
+	mat4 uV_m;				// view matrix
+	mat4 uP_m;				// projection matrix
+	vec4 camera_position;	// world space, w unused
+	vec4 fog_color;
+	float near;
+	float far;
 };
-uniform s_lights lights[MAX_LIGHTS];
 
 
 uniform vec3 ambient_intensity;	
@@ -37,12 +46,15 @@ vec2 texCoord;	// texture coordinates for FS
 vec3 N;			// normal in view space
 vec3 L;			// view-space light vector
 vec3 V;			// view vector (negative of the view-space position)
+flat int atlas_layer;	// atlas layer of the object (atlasLayer or the indirect draw's), -1 = use tex0
 } fs_in;
 
 uniform sampler2D tex0;					// texture unit from C++
-uniform vec2 tileOffset = vec2(0.0);	// the offset of one tile in a texture atlas
-uniform float tileSize = 1.0;			// size of one tile from a texture atlas
-out vec4 FragColor; 					// Final output
+uniform sampler2DArray atlas;			// texture atlas, one layer (with its own mipmaps) per tile
+layout(location = 0) out vec4 FragColor;	// Final output (OIT: weighted premultiplied color into the accumulation target)
+layout(location = 1) out float Revealage;	// OIT only: alpha, blended into the revealage target as product of (1 - alpha)
+
+uniform bool oit = false;				// transparent pass of TransparencyPass (weighted blended OIT)
 
 
 //------ Lighting calculations (using Phong lighting model) ------
@@ -108,10 +120,7 @@ vec4 SpotLight(int i){
 
 //------ Lighting calculations end ------
 
-//------ For fog calculations ------
-uniform vec4 fog_color = vec4(vec3(0.85f), 1.0f); // black, non-transparent = night
-uniform float near = 0.1f;
-uniform float far = 300.0f;
+//------ For fog calculations (fog_color, near, far come from the Frame block) ------
 float log_depth(float depth, float steepness, float offset){
 float linear_depth = (2.0 * near * far) / (far + near - (depth * 2.0 - 1.0) * (far - near));
 return (1 / (1 + exp(steepness * (linear_depth - offset))));
@@ -119,7 +128,7 @@ return (1 / (1 + exp(steepness * (linear_depth - offset))));
 
 void main() {
 
-vec2 tileUV = fs_in.texCoord * tileSize + tileOffset; //remapping the texturev coordinates for one tile from the texture atlas
+vec4 texColor = fs_in.atlas_layer >= 0 ? texture(atlas, vec3(fs_in.texCoord, float(fs_in.atlas_layer))) : texture(tex0, fs_in.texCoord);
 vec4 light_result = vec4(0.0, 0.0, 0.0, 0.0);
 vec4 additional_lights = vec4(1.0, 1.0, 1.0, 1.0);
 // Calculating the lighting based on the number and type of lights in the s_lights structure 
@@ -135,11 +144,20 @@ for (int i = 0; i < MAX_LIGHTS; ++i) {
 
 	light_result += additional_lights; 
 }
-//FragColor = fs_in.color * texture(tex0, tileUV) * light_result;	//Final output of FS
-vec4 PreFogColor = fs_in.color * texture(tex0, tileUV) * light_result;
+//FragColor = fs_in.color * texColor * light_result;	//Final output of FS
+vec4 PreFogColor = fs_in.color * texColor * light_result;
 
 float depth = log_depth(gl_FragCoord.z, 0.02f, 200.0f);
 FragColor = mix(fog_color, PreFogColor, depth); // linear interpolation
+
+// Weighted blended OIT (McGuire & Bavoil 2013, eq. 10): nearer and more opaque fragments weigh more, so the
+// average over the pixel needs no sorting. The 0.9 keeps the far plane (depth near 1 at far = 20000) above 0.
+if (oit) {
+	float alpha = clamp(FragColor.a, 0.0, 1.0);	// as the fixed-point blend of the sorted path sees it
+	float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+	FragColor = vec4(FragColor.rgb * alpha, alpha) * weight;
+	Revealage = alpha;
+}
 /*
 // Debug visualization of normals
     vec3 normalColor = normalize(fs_in.N) * 0.5 + 0.5;
@@ -4,9 +4,37 @@ in vec3 aPos; // Positions/Coordinates
 in vec3 aNorm;// Normals
 in vec2 aTex; // Texture Coordinates
 
-uniform mat4 uP_m = mat4(1.0);	//Projection matrix - 
+// Per-frame data shared by every program (binding 0), mirrored by FrameStd140 in UniformBlocks.hpp.
+layout(std140, binding = 0) uniform Frame {
+	mat4 uV_m;				// view matrix
+	mat4 uP_m;				// projection matrix
+	vec4 camera_position;	// world space, w unused
+	vec4 fog_color;
+	float near;
+	float far;
+};
+
 uniform mat4 uM_m = mat4(1.0);	//Model matrix - 
-uniform mat4 uV_m = mat4(1.0);	//View matrix -
+
+// Instanced draws (InstancedModel) take the model and normal matrix from the instance buffer instead.
+uniform bool instanced = false;
+layout(location = 3) in mat4 iM_m;	// locations 3-6
+layout(location = 7) in mat3 iN_m;	// locations 7-9
+
+// Indirect draws (IndirectDrawList) take matrices and atlas layer from entry draw_offset + gl_DrawID instead,
+// mirrored by IndirectDrawList::DrawData.
+struct DrawData {
+	mat4 model;
+	mat3 normal;
+	int atlas_layer;
+};
+layout(std430, binding = 2) readonly buffer Draws {
+	DrawData draws[];
+};
+uniform bool indirect = false;
+uniform int draw_offset = 0;
+
+uniform int atlasLayer = -1;			// atlas layer of the object, -1 = use tex0
 
 uniform vec4 my_color = vec4(1.0);			//Uniform to change the color of the shader
 
@@ -20,18 +48,29 @@ vec2 texCoord;	// Outputs texture coordinates for FS
 vec3 N;			// normal in view space
 vec3 L;			//view-space light vector
 vec3 V;			//view vector (negative of the view-space position)
+flat int atlas_layer;	// atlas layer for FS, -1 = use tex0
 } vs_out;
 
 void main() {
 
+mat4 M = instanced ? iM_m : uM_m;
+mat3 N_m = instanced ? iN_m : N_matrix;
+vs_out.atlas_layer = atlasLayer;
+if (indirect) {
+	int draw = draw_offset + gl_DrawID;
+	M = draws[draw].model;
+	N_m = draws[draw].normal;
+	vs_out.atlas_layer = draws[draw].atlas_layer;
+}
+
 // Create Model-View matrix
-mat4 mv_m = uV_m * uM_m;
+mat4 mv_m = uV_m * M;
 // Calculate view-space coordinate - in P point
 // we are computing the color
 vec4 P = mv_m * vec4(aPos,1.0f);
-vec3 P_world = vec3(uM_m * vec4(aPos,1.0));
+vec3 P_world = vec3(M * vec4(aPos,1.0));
 // Calculate normal in view space
-vec3 Normal = N_matrix * aNorm;
+vec3 Normal = N_m * aNorm;
 vs_out.N = mat3(mv_m) * Normal;
 // Calculate view-space light vector
 vs_out.L = light_position - P_world;
@@ -0,0 +1,22 @@
+#version 460 core
+
+// Resolve of weighted blended OIT (TransparencyPass): the weighted average color of all transparent fragments
+// over a pixel, blended onto the opaque image by how much of it shows through (revealage).
+// Blend state set by TransparencyPass::composite(): src * (1 - alpha) + dst * alpha, alpha = revealage.
+
+uniform sampler2D accum;		// sum of premultiplied color * weight (rgb) and alpha * weight (a)
+uniform sampler2D revealage;	// product of (1 - alpha)
+
+out vec4 FragColor;
+
+void main() {
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	float revealed = texelFetch(revealage, texel, 0).r;
+	if (revealed >= 1.0)
+		discard;		// no transparent fragment here
+
+	vec4 sum = texelFetch(accum, texel, 0);
+	if (isinf(max(max(abs(sum.r), abs(sum.g)), abs(sum.b))))
+		sum.rgb = vec3(sum.a);	// overflowed half floats: fall back to white of the right strength
+	FragColor = vec4(sum.rgb / clamp(sum.a, 1e-4, 5e4), revealed);
+}
@@ -0,0 +1,7 @@
+#version 460 core
+
+// Full-screen triangle for the OIT composite (TransparencyPass), no vertex buffer: gl_VertexID 0..2.
+void main() {
+	vec2 corner = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+	gl_Position = vec4(corner, 0.0, 1.0);
+}
@@ -0,0 +1,92 @@
+#version 460 core
+
+// CDLOD terrain (TerrainLOD): one kPatchQuads x kPatchQuads grid per instance, heights from a texture.
+// Pairs with lighting_shader.frag, so the outputs match lighting_shader.vert.
+
+layout(location = 0) in vec2 aGrid;		// integer grid position inside the patch (x along rows, y along columns)
+layout(location = 1) in vec4 iPatch;	// world x/z of the patch corner, vertex spacing, LOD level
+
+// Per-frame data shared by every program (binding 0), mirrored by FrameStd140 in UniformBlocks.hpp.
+layout(std140, binding = 0) uniform Frame {
+	mat4 uV_m;				// view matrix
+	mat4 uP_m;				// projection matrix
+	vec4 camera_position;	// world space, w unused
+	vec4 fog_color;
+	float near;
+	float far;
+};
+
+uniform sampler2D heights;		// R32F, one texel per heightmap cell (s = column, t = row)
+uniform vec2 terrain_cells;		// heightmap rows, columns (of the drawn window)
+uniform vec2 terrain_texture_cells;	// rows, columns of `heights`; a streamed window's ring holds map cell c at c mod this
+uniform vec2 terrain_first_cell = vec2(0.0);	// row, column of the window's first cell in the whole map (streamed window)
+uniform vec2 terrain_map_cells;	// rows, columns of the whole map
+uniform float terrain_scale;	// world units per cell
+uniform vec2 morph_range[16];	// per level: distance where morphing to the next coarser grid starts / ends (TerrainLOD::kMaxLevels)
+
+uniform vec4 my_color = vec4(1.0);
+uniform vec3 light_position = vec3(0.0f);
+uniform int atlasLayer = -1;
+
+out VS_OUT {
+vec4 color;		// Outputs color for FS
+vec2 texCoord;	// Outputs texture coordinates for FS
+vec3 N;			// normal in view space
+vec3 L;			//view-space light vector
+vec3 V;			//view vector (negative of the view-space position)
+flat int atlas_layer;	// atlas layer for FS, -1 = use tex0
+} vs_out;
+
+// Texture (row, column) of a world x/z; same placement as Heightmap for the whole map: x = (row - rows / 2) * scale.
+vec2 toGrid(vec2 xz) {
+	return xz / terrain_scale + terrain_map_cells * 0.5 - terrain_first_cell;
+}
+
+// Bilinear height at a (fractional) grid position, clamped at the border like HeightField::sample().
+// The map cell modulo the texture size is its texel; for a ring texture GL_REPEAT does the modulo.
+float heightAt(vec2 grid) {
+	vec2 cell = clamp(grid, vec2(0.0), terrain_cells - 1.0) + terrain_first_cell;
+	return texture(heights, (cell.yx + 0.5) / terrain_texture_cells.yx).r;
+}
+
+void main() {
+
+int level = int(iPatch.w);
+float spacing = iPatch.z;
+vec2 min_xz = (terrain_first_cell - terrain_map_cells * 0.5) * terrain_scale;
+vec2 max_xz = min_xz + (terrain_cells - 1.0) * terrain_scale;
+
+// Distance to the camera decides how far the vertex is morphed towards the coarser level: odd grid
+// vertices slide onto their even neighbour, so at the end of the range the patch matches the next level.
+vec2 xz = iPatch.xy + aGrid * spacing;
+float h = heightAt(toGrid(clamp(xz, min_xz, max_xz)));
+float dist = distance(camera_position.xyz, vec3(xz.x, h, xz.y));
+float k = clamp((dist - morph_range[level].x) / (morph_range[level].y - morph_range[level].x), 0.0, 1.0);
+xz -= fract(aGrid * 0.5) * 2.0 * spacing * k;
+
+// Patches at the far edge reach past it; their vertices collapse onto the border.
+xz = clamp(xz, min_xz, max_xz);
+vec2 grid = toGrid(xz);
+h = heightAt(grid);
+vec3 P_world = vec3(xz.x, h, xz.y);
+
+// Normal from central differences on the full-resolution heights (as Heightmap computes it).
+float hL = heightAt(grid - vec2(1.0, 0.0));
+float hR = heightAt(grid + vec2(1.0, 0.0));
+float hD = heightAt(grid - vec2(0.0, 1.0));
+float hU = heightAt(grid + vec2(0.0, 1.0));
+vec3 Normal = normalize(vec3(hL - hR, 2.0 * terrain_scale, hD - hU));
+
+vec4 P = uV_m * vec4(P_world, 1.0);
+vs_out.N = mat3(uV_m) * Normal;
+vs_out.L = light_position - P_world;
+vs_out.V = -P.xyz;
+gl_Position = uP_m * P;
+
+vs_out.color = my_color;
+vs_out.atlas_layer = atlasLayer;
+// Same mapping as the Heightmap vertices: u along the columns, v along the rows.
+vec2 map_grid = grid + terrain_first_cell;
+vs_out.texCoord = vec2(map_grid.y / (terrain_map_cells.y - 1.0), map_grid.x / (terrain_map_cells.x - 1.0));
+
+}